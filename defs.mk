@@ -0,0 +1,198 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+# SPDX-FileCopyrightText: Copyright © 2022 Erez Geva <ErezGeva2@gmail.com>
+#
+# parameters for Makefile detected by configure
+#
+# @author Erez Geva <ErezGeva2@@gmail.com>
+# @copyright © 2022 Erez Geva
+#
+###############################################################################
+
+# Identity of this package.
+PACKAGE_NAME:=libptpmgmt
+PACKAGE_TARNAME:=libptpmgmt-1.2.txz
+PACKAGE_STRING:=libptpmgmt 1.2
+PACKAGE_URL:=https://libptpmgmt.nwtime.org
+
+# Version
+PACKAGE_VERSION:=1.2
+PACKAGE_VERSION_MAJ:=1
+PACKAGE_VERSION_MIN:=2
+PACKAGE_VERSION_VAL:=0x0102
+
+# Architectures and cross compilation
+build_alias:=
+build:=x86_64-pc-linux-gnu
+build_cpu:=x86_64
+build_os:=linux-gnu
+host_alias:=
+host:=x86_64-pc-linux-gnu
+host_cpu:=x86_64
+host_os:=linux-gnu
+USE_CROSS_COMPILE:=
+CXX_COLOR_USE:=-fdiagnostics-color=always
+CXX_COLOR_NONE:=-fno-diagnostics-color
+
+# paths in system
+ROOT_DIR:=/root/repo
+prefix:=/usr/local
+exec_prefix:=${prefix}
+libdir:=${exec_prefix}/lib
+libexecdir:=${exec_prefix}/libexec
+includedir:=${prefix}/include
+sysconfdir:=${prefix}/etc
+localstatedir:=${prefix}/var
+datarootdir:=${prefix}/share
+mandir:=${datarootdir}/man
+infodir:=${datarootdir}/info
+sbindir:=${exec_prefix}/sbin
+bindir:=${exec_prefix}/bin
+
+# Objecy extension
+OBJEXT:=o
+
+# Compiler
+CC:=gcc
+CXX:=g++
+CXXFLAGS_PMC:=
+
+# Management IDs in library, empty for all
+MNG_IDS:=
+USE_FULL_PATH_LINK:=
+
+# Tools
+GREP:=/usr/bin/grep
+EGREP:=/usr/bin/grep -E
+FGREP:=/usr/bin/grep -F
+RANLIB:=ranlib
+SED:=/usr/bin/sed
+MKDIR_P:=/usr/bin/mkdir -p
+LN_S:=ln -s
+M4:=m4
+CTAGS:=
+READLINK:=readlink
+PKG_CONFIG:=pkg-config
+INSTALL:=/usr/bin/install -c
+INSTALL_PROGRAM:=${INSTALL}
+INSTALL_SCRIPT:=${INSTALL}
+INSTALL_DATA:=${INSTALL} -m 644
+ASTYLE:=
+ASTYLEVER:=
+ASTYLEMINVER:=
+DOXYGEN:=
+DOXYGENVER:=
+DOXYGENMINVER:=
+DOTTOOL:=
+EPSTOPDF_TOOL:=
+CPPCHECK:=
+VALGRIND:=
+
+# Testing tools
+HAVE_GTEST_HEADER:=gtest/gtest.h
+GTEST_INC_FLAGS:=-DGTEST_HAS_PTHREAD=1 
+GTEST_LIB_FLAGS:=-lgtest -lpthread 
+HAVE_CRITERION_HEADER:=
+CRITERION_INC_FLAGS:=
+CRITERION_LIB_FLAGS:=
+ASAN_LIBS:=	libasan.so.8  	libubsan.so.1  
+
+# JSON libraries
+HAVE_JSONC_LIB:=
+JSONC_LIB_FLAGS:=
+HAVE_FJSON_LIB:=
+FJSON_LIB_FLAGS:=-lfastjson
+
+# Swig
+SWIG:=
+SWIGBIN:=yes
+SWIGVER:=
+SWIGMINVER:=
+SWIGLIB:=
+SWIGARGCARGV_GO:=
+
+# Tcl
+TCLCONFIG:=
+TCLINCDIR:=
+TCLINCLUDE:=
+TCLLIB:=
+TCLVER:=
+TCLMINVER:=
+TCL_PKG_DIR:=
+
+# Python3
+PY3VER:=
+PY3VERSION:=
+PY3INCLUDE:=
+PY3INCDIR:=
+PY3PLATINCDIR:=
+PY3SITE_DIR:=
+PY3LINK:=
+PY3EXT:=
+PY3LDLIBS:=
+
+# Perl
+PERL:=perl
+PERL5DIR:=/usr/lib/x86_64-linux-gnu/perl/5.36.0
+PERL5EXT:=/usr/lib/x86_64-linux-gnu/perl/5.36.0/CORE
+PERL5TEST:=
+PERL5TOUCH:=
+
+# Ruby
+RUBY:=
+RUBYHDRDIR=
+RUBYARCHHDRDIR=
+RUBYINCLUDE:=
+RUBYVER:=
+RUBYLIB:=
+RUBYLINK:=
+RUBYSITE:=
+
+# PHP
+PHP:=
+PHPCONFIG:=
+PHPINCDIR:=
+PHPVER:=
+PHPEXT:=
+PHPINC:=
+PHPINC_FLAGS:=
+PHPUNIT:=
+
+# Lua
+LUABIN:=
+LUA_VERSION:=
+LUABIN_VERSION:=
+LUA_INC:=
+LUALINK:=
+LUAVERSIONS:=
+LUAVERSIONS_UNIT:=
+LUAUNIT:=
+LUA_5_1_INC:=
+LUA_5_2_INC:=
+LUA_5_3_INC:=
+LUA_5_4_INC:=
+LUA_5_5_INC:=
+LUA_5_6_INC:=
+LUA_5_7_INC:=
+LUA_5_1_LINK:=
+LUA_5_2_LINK:=
+LUA_5_3_LINK:=
+LUA_5_4_LINK:=
+LUA_5_5_LINK:=
+LUA_5_6_LINK:=
+LUA_5_7_LINK:=
+
+# Go
+GOBIN:=
+GOVER:=
+GOMINVER:=
+GOROOT:=
+GOARCH:=
+
+# Skip languages
+SKIP_TCL:=1
+SKIP_PERL5:=1
+SKIP_PYTHON3:=1
+SKIP_RUBY:=1
+SKIP_PHP:=1
+SKIP_LUA:=1
+SKIP_GO:=1
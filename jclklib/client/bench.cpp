@@ -0,0 +1,59 @@
+/*! \file bench.cpp
+    \brief Proxy message throughput benchmark. Logging is off, run the proxy with -l 0.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include "init.hpp"
+#include "client_state.hpp"
+
+#include <common/print.hpp>
+
+#include <unistd.h>
+#include <iostream>
+#include <chrono>
+
+using namespace JClkLibClient;
+using namespace JClkLibCommon;
+using namespace std;
+
+#define BENCH_DEFAULT_COUNT (100000)
+#define BENCH_CONNECT_TIMEOUT (1000 /*ms*/)
+
+int main(int argc, char *argv[])
+{
+	unsigned count = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+	jcl_subscription sub = {};
+	chrono::steady_clock::time_point begin;
+	chrono::duration<double> elapsed;
+	unsigned sent;
+	int ret = 0;
+
+	setLogLevel(LOG_ERROR);
+	connect();
+	for (int i = 0; i < BENCH_CONNECT_TIMEOUT && !state.get_connected(); ++i)
+		usleep(1000);
+	if (!state.get_connected()) {
+		cerr << "Proxy is not available" << endl;
+		disconnect();
+		return -1;
+	}
+
+	/* The proxy queue is short, the send blocks while the proxy is busy */
+	begin = chrono::steady_clock::now();
+	for (sent = 0; sent < count; ++sent) {
+		if (!subscribe(sub)) {
+			cerr << "Subscribe failed after " << sent << " messages" << endl;
+			ret = -1;
+			break;
+		}
+	}
+	elapsed = chrono::steady_clock::now() - begin;
+
+	cout << sent << " messages in " << elapsed.count() << " s, "
+	     << (unsigned long)(sent / elapsed.count()) << " messages/s" << endl;
+	disconnect();
+
+	return ret;
+}
@@ -1,10 +1,137 @@
 #include <client/client_state.hpp>
+#include <common/print.hpp>
+
+#include <chrono>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 using namespace JClkLibClient;
+using namespace JClkLibCommon;
+using namespace std;
 
 ClientState::ClientState()
 {
 	connected = false;
+	subscribed = false;
+	sessionId = JClkLibCommon::InvalidSessionId;
+	instance = JClkLibCommon::BestInstanceId;
+	event.zero();
+	eventCount.zero();
+	gmOffset = 0;
+	pending.zero();
+	eventFd = -1;
+}
+
+bool ClientState::openEventFd()
+{
+	lock_guard<mutex> guard(notifyLock);
+
+	if (eventFd != -1)
+		return true;
+	eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (eventFd == -1) {
+		PrintErrorCode("Failed to create notification event fd");
+		return false;
+	}
+
+	return true;
+}
+
+void ClientState::closeEventFd()
+{
+	lock_guard<mutex> guard(notifyLock);
+
+	if (eventFd == -1)
+		return;
+	close(eventFd);
+	eventFd = -1;
+}
+
+bool ClientState::get_connected()
+{
+	lock_guard<mutex> guard(notifyLock);
+
+	return connected;
+}
+
+void ClientState::set_connected(bool connected)
+{
+	/* The lock orders the state change before the waiter checks it */
+	lock_guard<mutex> guard(notifyLock);
+
+	this->connected = connected;
+	notifyCond.notify_all();
+}
+
+bool ClientState::anyPending(const jcl_event &eventMask) const
+{
+	for (int e = 0; e < eventLast; ++e)
+		if (eventMask.isSet((eventType)e) && pending.isSet((eventType)e))
+			return true;
+
+	return false;
+}
+
+void ClientState::setNotification(const JClkLibCommon::jcl_event &event,
+				  const JClkLibCommon::jcl_eventcount &eventCount, std::int64_t gmOffset)
+{
+	std::uint64_t one = 1;
+	std::lock_guard<std::mutex> guard(notifyLock);
+
+	/* The proxy counts each change of an event */
+	for (int e = 0; e < eventLast; ++e)
+		if (eventCount.get((eventType)e) != this->eventCount.get((eventType)e))
+			pending.set((eventType)e, true);
+	this->event = event;
+	this->eventCount = eventCount;
+	this->gmOffset = gmOffset;
+
+	notifyCond.notify_all();
+	if (eventFd != -1 && write(eventFd, &one, sizeof(one)) == -1 && errno != EAGAIN)
+		PrintErrorCode("Failed to signal notification event fd");
+}
+
+void ClientState::getNotification(JClkLibCommon::jcl_event &event,
+				  JClkLibCommon::jcl_eventcount &eventCount, std::int64_t &gmOffset)
+{
+	std::lock_guard<std::mutex> guard(notifyLock);
+
+	event = this->event;
+	eventCount = this->eventCount;
+	gmOffset = this->gmOffset;
+}
+
+bool ClientState::waitConnected(int timeout)
+{
+	unique_lock<mutex> lock(notifyLock);
+
+	return notifyCond.wait_for(lock, chrono::milliseconds(timeout), [this] { return connected; });
+}
+
+int ClientState::waitEvent(const jcl_event &eventMask, int timeout)
+{
+	std::uint64_t count;
+	jcl_event none;
+	unique_lock<mutex> lock(notifyLock);
+	auto ready = [&] { return !connected || anyPending(eventMask); };
+
+	if (timeout < 0)
+		notifyCond.wait(lock, ready);
+	else if (!notifyCond.wait_for(lock, chrono::milliseconds(timeout), ready))
+		return 0;
+	if (!connected)
+		return -1;
+	for (int e = 0; e < eventLast; ++e)
+		if (eventMask.isSet((eventType)e))
+			pending.set((eventType)e, false);
+	/* Nothing left to report, reset the event fd for the next notification */
+	none.zero();
+	if (pending == none && eventFd != -1)
+		while (read(eventFd, &count, sizeof(count)) > 0);
+
+	return 1;
 }
 
 ClientState JClkLibClient::state{};
@@ -1,18 +1,49 @@
 #ifndef PROXY_CLIENT_STATE
 #define PROXY_CLIENT_STATE
 
+#include <mutex>
+#include <condition_variable>
+
 #include <common/jcltypes.hpp>
+#include <common/jclklib_import.hpp>
 #include <common/util.hpp>
 
 namespace JClkLibClient {
 	class ClientState {
 	private:
-		bool connected;
+		bool subscribed;
 		JClkLibCommon::sessionId_t sessionId;
+		JClkLibCommon::instanceId_t instance;
+		/* Last notification, written by the transport listener */
+		std::mutex notifyLock;
+		JClkLibCommon::jcl_event event;
+		JClkLibCommon::jcl_eventcount eventCount;
+		std::int64_t gmOffset;
+		/* Set by the transport listener, read by the waiters */
+		bool connected;
+		/* Changed events not yet returned by waitEvent() */
+		JClkLibCommon::jcl_event pending;
+		std::condition_variable notifyCond;
+		int eventFd;
+		bool anyPending(const JClkLibCommon::jcl_event &eventMask) const;
 	public:
 		ClientState();
-		DECLARE_ACCESSOR(connected);
+		/* Signalled on each notification, valid while connected */
+		bool openEventFd();
+		void closeEventFd();
+		int getEventFd() const { return eventFd; }
+		/* Under the notification lock, a change wakes the waiters */
+		bool get_connected();
+		void set_connected(bool connected);
+		bool waitConnected(int timeout);
+		int waitEvent(const JClkLibCommon::jcl_event &eventMask, int timeout);
+		void setNotification(const JClkLibCommon::jcl_event &event,
+				     const JClkLibCommon::jcl_eventcount &eventCount, std::int64_t gmOffset);
+		void getNotification(JClkLibCommon::jcl_event &event,
+				     JClkLibCommon::jcl_eventcount &eventCount, std::int64_t &gmOffset);
+		DECLARE_ACCESSOR(subscribed);
 		DECLARE_ACCESSOR(sessionId);
+		DECLARE_ACCESSOR(instance);
 	};
 
 	extern JClkLibClient::ClientState state;
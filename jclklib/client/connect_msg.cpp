@@ -20,7 +20,7 @@ using namespace std;
  */
 MAKE_RXBUFFER_TYPE(ClientConnectMessage::buildMessage)
 {
-        msg = new ClientConnectMessage();
+        msg = MessagePool<ClientConnectMessage>::get();
 
         return true;
 }
@@ -60,8 +60,9 @@ PROCESS_MESSAGE_TYPE(ClientConnectMessage::processMessage)
 
         PrintDebug("Processing client connect message (reply)");
 
-	state.set_connected(true);
+	/* The session ID is valid once connect() sees the connection */
 	state.set_sessionId(this->get_sessionId());
+	state.set_connected(true);
 
         PrintDebug("Connected with session ID: " + to_string(this->get_sessionId()));
 
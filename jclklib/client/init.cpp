@@ -7,41 +7,77 @@
 
 #include <client/init.hpp>
 #include <client/msgq_tport.hpp>
+#include <client/shm_tport.hpp>
 #include <client/connect_msg.hpp>
+#include <client/subscribe_msg.hpp>
+#include <client/client_state.hpp>
 #include <common/sighandler.hpp>
 #include <common/print.hpp>
+#include <common/status_page.hpp>
+
+#include <mutex>
 
 using namespace JClkLibClient;
 using namespace JClkLibCommon;
 using namespace std;
 
+/* Best clock page and one page per ptp4l instance, mapped on first use */
+static StatusPage statusPages[BestInstanceId + 1];
+static mutex attachLock;
+
+/* Proxy reply to the connect message */
+#define CONNECT_TIMEOUT_MS (1000)
+
 bool JClkLibClient::connect()
 {
 	Message0 connectMsg(new ClientConnectMessage());
 
 	BlockStopSignal();
+	if(!state.openEventFd())
+		return false;
 	if(!ClientMessage::init()) {
 		PrintError("Client Message Init Failed");
-		return false;
+		goto fail;
 	}
 	if(!ClientTransport::init()) {
 		PrintError("Client Transport Init Failed");
-		return false;
+		goto fail_transport;
 	}
 
-	ClientMessageQueue::writeTransportClientId(connectMsg.get());
+	// Proxy may be older, status is then available thru notifications only
+	if(!statusPages[BestInstanceId].attach())
+		PrintDebug("Status page is not available");
+
+	// Replies on the ring if the client has one, otherwise on the message queue
+	if(!ClientShmRing::writeTransportClientId(connectMsg.get()))
+		ClientMessageQueue::writeTransportClientId(connectMsg.get());
 	ClientMessageQueue::sendMessage(connectMsg.get());
 
 	// Wait for connection result
-	
+	if(!state.waitConnected(CONNECT_TIMEOUT_MS)) {
+		PrintError("No connect reply from proxy");
+		goto fail_transport;
+	}
 
 	return true;
+
+ fail_transport:
+	// The listeners write to the event fd, stop them first
+	ClientTransport::stop();
+	ClientTransport::finalize();
+ fail:
+	state.closeEventFd();
+	return false;
 }
 
 bool JClkLibClient::disconnect()
 {
 	bool retVal = false;
 
+	for (auto &page : statusPages)
+		page.close();
+	// Release the waiters
+	state.set_connected(false);
 	// Send a disconnect message
 	if(!ClientTransport::stop()) {
 		PrintDebug("Client Stop Failed");
@@ -54,7 +90,52 @@ bool JClkLibClient::disconnect()
 	retVal = true;
 
  done:
+	state.closeEventFd();
 	if (!retVal)
 		PrintError("Client Error Occured");
 	return retVal;
 }
+
+bool JClkLibClient::subscribe(const jcl_subscription &subscription, instanceId_t instance)
+{
+	ClientSubscribeMessage subscribeMsg;
+
+	if (!state.get_connected()) {
+		PrintError("Client is not connected");
+		return false;
+	}
+	subscribeMsg.set_sessionId(state.get_sessionId());
+	subscribeMsg.set_subscription(subscription);
+	subscribeMsg.set_instance(instance);
+
+	return ClientMessageQueue::sendMessage(&subscribeMsg);
+}
+
+bool JClkLibClient::getStatus(jcl_event &event, jcl_eventcount &count, int64_t &gmOffset,
+			      instanceId_t instance)
+{
+	StatusPage &page = statusPages[instance];
+
+	if (!page.isOpen()) {
+		lock_guard<decltype(attachLock)> attach_guard(attachLock);
+		if (!page.attach(instance))
+			return false;
+	}
+
+	return page.read(event, count, gmOffset);
+}
+
+void JClkLibClient::getNotification(jcl_event &event, jcl_eventcount &count, int64_t &gmOffset)
+{
+	state.getNotification(event, count, gmOffset);
+}
+
+int JClkLibClient::waitEvent(const jcl_event &eventMask, int timeout)
+{
+	return state.waitEvent(eventMask, timeout);
+}
+
+int JClkLibClient::getEventFd()
+{
+	return state.getEventFd();
+}
@@ -5,13 +5,34 @@
     Author: Christopher Hall <christopher.s.hall@intel.com>
 */
 
+#include <cstdint>
+
 #ifndef CLIENT_INIT_HPP
 #define CLIENT_INIT_HPP
 
+#include <common/jclklib_import.hpp>
+#include <common/jcltypes.hpp>
+
 namespace JClkLibClient {
 	bool connect();
 	bool disconnect();
-	//bool subscribe();
+	/* Subscribe to a ptp4l instance of the proxy or to the best clock of all instances */
+	bool subscribe(const JClkLibCommon::jcl_subscription &subscription,
+		       JClkLibCommon::instanceId_t instance = JClkLibCommon::BestInstanceId);
+	/* Read the proxy status page, no system calls and no locks after the first read */
+	bool getStatus(JClkLibCommon::jcl_event &event, JClkLibCommon::jcl_eventcount &count,
+		       std::int64_t &gmOffset,
+		       JClkLibCommon::instanceId_t instance = JClkLibCommon::BestInstanceId);
+	/* Last notification from the proxy for this session */
+	void getNotification(JClkLibCommon::jcl_event &event, JClkLibCommon::jcl_eventcount &count,
+			     std::int64_t &gmOffset);
+	/* Block until a notification changes an event of the mask, timeout in
+	   milliseconds, negative waits forever. Return 1 on event, 0 on timeout
+	   and -1 if the client is not connected */
+	int waitEvent(const JClkLibCommon::jcl_event &eventMask, int timeout = -1);
+	/* Event fd for the application poll loop, readable when a notification
+	   arrives. waitEvent() with zero timeout consumes it */
+	int getEventFd();
 };
 
 #endif/*CLIENT_INIT_HPP*/
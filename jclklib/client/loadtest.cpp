@@ -0,0 +1,403 @@
+/*! \file loadtest.cpp
+    \brief Proxy load test. Runs the proxy against a stand-in ptp4l and forks many clients.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include "init.hpp"
+
+#include <common/print.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+using namespace JClkLibClient;
+using namespace JClkLibCommon;
+using namespace std;
+
+#define LOADTEST_DEFAULT_CLIENTS (100)
+#define LOADTEST_DEFAULT_EVENTS (20)
+/* Longer than the proxy notification interval, each event is sent on its own */
+#define LOADTEST_DEFAULT_INTERVAL (200 /*ms*/)
+#define LOADTEST_MAX_EVENTS (1000)
+#define LOADTEST_PROXY "../proxy/jclklib_proxy"
+#define LOADTEST_PTP4L_ADDRESS "/tmp/jclklib_loadtest.ptp4l"
+/* The offset toggles in and out of the subscribed window */
+#define LOADTEST_WINDOW (1000 /*ns*/)
+#define LOADTEST_OUT_OFFSET (100000 /*ns*/)
+#define LOADTEST_START_TIMEOUT (10 /*s*/)
+/* Clients connect one after the other, the proxy serves them in a single thread */
+#define LOADTEST_READY_TIMEOUT (60 /*s*/)
+
+/* Shared between the test and the forked clients */
+struct LoadTestShared
+{
+	atomic<unsigned> ready;
+	atomic<int64_t> sendTime[LOADTEST_MAX_EVENTS];
+};
+
+struct LoadTestClient
+{
+	int64_t connectTime;
+	/* Zero if the notification was not received */
+	int64_t latency[LOADTEST_MAX_EVENTS];
+};
+
+static int64_t monotonicNs()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Stand-in for ptp4l, pushes TIME_STATUS_NP responses to the proxy */
+class Ptp4lStandIn
+{
+private:
+	int fd;
+	string address;
+	struct sockaddr_un proxy;
+	socklen_t proxyLength;
+	uint16_t sequence;
+	template <typename T> static void put(vector<uint8_t> &buf, T value)
+	{
+		for (int i = sizeof(T) - 1; i >= 0; --i)
+			buf.push_back((uint8_t)((uint64_t)value >> (i * 8)));
+	}
+public:
+	Ptp4lStandIn() : fd(-1), proxyLength(0), sequence(0) {}
+	~Ptp4lStandIn() { close(); }
+	bool open(const string &address);
+	void close();
+	/* Wait for the first proxy request, ptp4l answers to the sender */
+	bool waitProxy(int timeout);
+	bool sendTimeStatus(int64_t offset, bool locked);
+};
+
+bool Ptp4lStandIn::open(const string &address)
+{
+	struct sockaddr_un addr = {};
+
+	if (address.length() >= sizeof(addr.sun_path)) {
+		cerr << "ptp4l address is too long" << endl;
+		return false;
+	}
+	fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd == -1) {
+		perror("socket");
+		return false;
+	}
+	unlink(address.c_str());
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, address.c_str());
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		perror("bind");
+		return false;
+	}
+	this->address = address;
+
+	return true;
+}
+
+void Ptp4lStandIn::close()
+{
+	if (fd == -1)
+		return;
+	::close(fd);
+	unlink(address.c_str());
+	fd = -1;
+}
+
+bool Ptp4lStandIn::waitProxy(int timeout)
+{
+	uint8_t buf[2000];
+	struct timeval tv = { timeout, 0 };
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	proxyLength = sizeof(proxy);
+	if (recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&proxy, &proxyLength) == -1) {
+		perror("No request from proxy");
+		return false;
+	}
+	/* Drop the requests, the stand-in only pushes */
+	shutdown(fd, SHUT_RD);
+
+	return true;
+}
+
+bool Ptp4lStandIn::sendTimeStatus(int64_t offset, bool locked)
+{
+	vector<uint8_t> data, msg;
+
+	/* TIME_STATUS_NP data set */
+	put<int64_t>(data, offset);		// master_offset
+	put<int64_t>(data, 0);			// ingress_time
+	put<int32_t>(data, 0);			// cumulativeScaledRateOffset
+	put<int32_t>(data, 0);			// scaledLastGmPhaseChange
+	put<uint16_t>(data, 0);			// gmTimeBaseIndicator
+	put<uint16_t>(data, 0);			// lastGmPhaseChange
+	put<uint64_t>(data, 0);
+	put<uint16_t>(data, 0);
+	put<int32_t>(data, 1);			// gmPresent
+	put<uint64_t>(data, 0x0101010101010101);// gmIdentity
+	put<uint8_t>(data, locked ? 2 : 0);	// servo_state, SERVO_LOCKED
+	put<uint8_t>(data, 0);
+
+	/* PTP header, management message */
+	put<uint8_t>(msg, 0x0d);
+	put<uint8_t>(msg, 0x02);
+	put<uint16_t>(msg, 34 + 14 + 6 + data.size());
+	put<uint32_t>(msg, 0);			// domain, minor SDO ID, flags
+	put<int64_t>(msg, 0);			// correction
+	put<uint32_t>(msg, 0);
+	put<uint64_t>(msg, 0x0202020202020202);	// source port identity
+	put<uint16_t>(msg, 1);
+	put<uint16_t>(msg, sequence++);
+	put<uint8_t>(msg, 0x04);		// control field, management
+	put<uint8_t>(msg, 0x7f);		// log message interval
+	/* Management header, all target ports, RESPONSE action */
+	for (int i = 0; i < 10; ++i)
+		put<uint8_t>(msg, 0xff);
+	put<uint8_t>(msg, 0);
+	put<uint8_t>(msg, 0);
+	put<uint8_t>(msg, 2);
+	put<uint8_t>(msg, 0);
+	/* Management TLV */
+	put<uint16_t>(msg, 1);
+	put<uint16_t>(msg, 2 + data.size());
+	put<uint16_t>(msg, 0xc000);		// TIME_STATUS_NP
+	msg.insert(msg.end(), data.begin(), data.end());
+
+	return sendto(fd, msg.data(), msg.size(), 0, (struct sockaddr *)&proxy, proxyLength) ==
+		(ssize_t)msg.size();
+}
+
+static pid_t startProxy(const string &path, const string &address)
+{
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		execl(path.c_str(), path.c_str(), "-l", "0", "-s", address.c_str(), (char *)NULL);
+		perror(path.c_str());
+		_exit(1);
+	}
+	return pid;
+}
+
+/* CPU time of all threads of a process */
+static int64_t processCpuNs(pid_t pid)
+{
+	struct timespec ts;
+	clockid_t clock;
+
+	if (clock_getcpuclockid(pid, &clock) != 0 || clock_gettime(clock, &ts) == -1)
+		return 0;
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void runClient(LoadTestShared *shared, LoadTestClient *result, unsigned events,
+		      int timeout)
+{
+	jcl_subscription sub = {};
+	jcl_event event;
+	jcl_eventcount count;
+	int64_t begin, gmOffset;
+	uint32_t received = 0;
+
+	sub.get_event().set(gmOffsetEvent, true);
+	sub.get_value().setLimits(gmOffsetValue, LOADTEST_WINDOW, LOADTEST_WINDOW);
+
+	setLogLevel(LOG_ERROR);
+	begin = monotonicNs();
+	if (!connect() || !subscribe(sub)) {
+		shared->ready++;
+		disconnect();
+		return;
+	}
+	result->connectTime = monotonicNs() - begin;
+	shared->ready++;
+
+	while (received < events && waitEvent(sub.get_event(), timeout) > 0) {
+		int64_t now = monotonicNs();
+
+		getNotification(event, count, gmOffset);
+		/* A count skip is a lost or merged notification, the latency is for the last */
+		received = count.get(gmOffsetEvent);
+		if (received > 0 && received <= events)
+			result->latency[received - 1] = now - shared->sendTime[received - 1];
+	}
+	disconnect();
+}
+
+/* Wait for the clients to subscribe, fail if a client dies or on timeout */
+static bool waitReady(LoadTestShared *shared, const vector<pid_t> &children)
+{
+	int64_t deadline = monotonicNs() + (int64_t)LOADTEST_READY_TIMEOUT * 1000000000;
+	int status;
+
+	while (shared->ready < children.size()) {
+		for (pid_t pid : children) {
+			/* A client exits before it is ready only if it crashed */
+			if (waitpid(pid, &status, WNOHANG) == pid &&
+			    (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+				cerr << "Client " << pid << " died before it subscribed" << endl;
+				return false;
+			}
+		}
+		if (monotonicNs() > deadline) {
+			cerr << "Only " << shared->ready << " of " << children.size()
+			     << " clients are ready after " << LOADTEST_READY_TIMEOUT << " s" << endl;
+			return false;
+		}
+		usleep(1000);
+	}
+	return true;
+}
+
+static void report(const string &name, vector<int64_t> &values)
+{
+	auto pct = [&](unsigned p) { return values[min(values.size() - 1, values.size() * p / 100)] / 1000.0; };
+
+	if (values.empty()) {
+		cout << name << ": no samples" << endl;
+		return;
+	}
+	sort(values.begin(), values.end());
+	cout << name << " (us): p50 " << pct(50) << " p90 " << pct(90) << " p99 " << pct(99)
+	     << " max " << values.back() / 1000.0 << endl;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned clients = LOADTEST_DEFAULT_CLIENTS, events = LOADTEST_DEFAULT_EVENTS;
+	int interval = LOADTEST_DEFAULT_INTERVAL;
+	string proxyPath = LOADTEST_PROXY, address = LOADTEST_PTP4L_ADDRESS;
+	LoadTestShared *shared;
+	LoadTestClient *results;
+	vector<pid_t> children;
+	vector<int64_t> connectTimes, latencies;
+	Ptp4lStandIn ptp4l;
+	size_t sharedSize;
+	unsigned missed = 0;
+	int64_t cpuBegin, cpuEnd;
+	int ret = -1;
+	pid_t proxy;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:e:i:p:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			clients = atoi(optarg);
+			break;
+		case 'e':
+			events = min(atoi(optarg), LOADTEST_MAX_EVENTS);
+			break;
+		case 'i':
+			interval = atoi(optarg);
+			break;
+		case 'p':
+			proxyPath = optarg;
+			break;
+		case 's':
+			address = optarg;
+			break;
+		default:
+			cout << "Usage: " << argv[0] << " [-n clients] [-e events] [-i interval ms]"
+				" [-p proxy path] [-s ptp4l UDS address]" << endl;
+			return -1;
+		}
+	}
+
+	sharedSize = sizeof(LoadTestShared) + clients * sizeof(LoadTestClient);
+	shared = (LoadTestShared *)mmap(NULL, sharedSize, PROT_READ | PROT_WRITE,
+					MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED) {
+		perror("mmap");
+		return -1;
+	}
+	results = (LoadTestClient *)(shared + 1);
+
+	if (!ptp4l.open(address))
+		return -1;
+	proxy = startProxy(proxyPath, address);
+	if (proxy == -1 || !ptp4l.waitProxy(LOADTEST_START_TIMEOUT))
+		goto do_exit;
+	/* In the window and locked before the clients subscribe */
+	ptp4l.sendTimeStatus(0, true);
+
+	for (unsigned i = 0; i < clients; ++i) {
+		pid_t pid = fork();
+
+		if (pid == 0) {
+			runClient(shared, &results[i], events, interval * 10);
+			_exit(0);
+		}
+		if (pid == -1) {
+			perror("fork");
+			break;
+		}
+		children.push_back(pid);
+	}
+	if (!waitReady(shared, children)) {
+		for (pid_t pid : children) {
+			kill(pid, SIGKILL);
+			waitpid(pid, NULL, 0);
+		}
+		goto do_exit;
+	}
+
+	cpuBegin = processCpuNs(proxy);
+	for (unsigned i = 0; i < events; ++i) {
+		shared->sendTime[i] = monotonicNs();
+		ptp4l.sendTimeStatus(i % 2 == 0 ? LOADTEST_OUT_OFFSET : 0, true);
+		usleep(interval * 1000);
+	}
+	cpuEnd = processCpuNs(proxy);
+
+	for (pid_t pid : children)
+		waitpid(pid, NULL, 0);
+
+	for (unsigned i = 0; i < children.size(); ++i) {
+		if (results[i].connectTime == 0)
+			continue;
+		connectTimes.push_back(results[i].connectTime);
+		for (unsigned e = 0; e < events; ++e) {
+			if (results[i].latency[e] == 0)
+				++missed;
+			else
+				latencies.push_back(results[i].latency[e]);
+		}
+	}
+	cout << children.size() << " clients, " << connectTimes.size() << " connected, "
+	     << events << " events, " << missed << " notifications missed" << endl;
+	if (connectTimes.size() < children.size())
+		cout << "Each client opens a message queue, check /proc/sys/fs/mqueue/queues_max"
+			" and ulimit -q" << endl;
+	report("Connect time", connectTimes);
+	report("Notification latency", latencies);
+	cout << "Proxy CPU per event (us): " << (cpuEnd - cpuBegin) / 1000.0 / events << endl;
+	ret = 0;
+
+ do_exit:
+	if (proxy > 0) {
+		kill(proxy, SIGINT);
+		waitpid(proxy, NULL, 0);
+	}
+	munmap(shared, sharedSize);
+
+	return ret;
+}
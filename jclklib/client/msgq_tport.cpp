@@ -32,15 +32,10 @@ DECLARE_STATIC(ClientMessageQueue::txContext);
 
 LISTENER_CONTEXT_PROCESS_MESSAGE_TYPE(ClientMessageQueueListenerContext::processMessage)
 {
-        ClientMessage *msg = dynamic_cast<decltype(msg)>(bmsg);
-
         PrintDebug("Processing received client message");
-        if (msg == NULL) {
-                PrintError("Wrong message type");
-                return false;
-        }
 
-        return msg->processMessage(*this,txcontext);
+        /* Only client message types are registered, no cast is needed */
+        return bmsg->processMessage(*this,txcontext);
 }
 
 bool ClientMessageQueue::initTransport()
@@ -52,8 +47,7 @@ bool ClientMessageQueue::initTransport()
 	mq_attr.mq_msgsize = (decltype(mq_attr.mq_msgsize)) std::tuple_size<TransportBuffer>::value;
 
 	PrintInfo("Initializing Message Queue Client Transport...");
-	mqListenerName += mqProxyName + ".";
-	mqListenerName += to_string(getpid());
+	mqListenerName = mqProxyName + "." + to_string(getpid());
 	mqNativeListenerDesc = mq_open(mqListenerName.c_str(), RX_QUEUE_FLAGS, RX_QUEUE_MODE, &mq_attr);
 	if (mqNativeListenerDesc == -1) {
 		PrintError("Failed to open listener queue");
@@ -62,9 +56,9 @@ bool ClientMessageQueue::initTransport()
 
 	if (InvalidTransportWorkDesc ==
 	    (mqListenerDesc = registerWork
-	     (move((TransportWork){MqListenerWork,
-				   TransportWorkArg(new ClientMessageQueueListenerContext(mqNativeListenerDesc))})) )) {
-		PrintError("Listener Thread Unexpectedly Exited");
+	     (MqListener(new ClientMessageQueueListenerContext(mqNativeListenerDesc)),
+	      mqNativeListenerDesc) )) {
+		PrintError("Failed to register listener");
 		return false;
 	}
 
@@ -84,10 +78,8 @@ bool ClientMessageQueue::stopTransport()
 {
 	PrintInfo("Stopping Message Queue Client Transport");
 	PrintDebug("mqListenerName = " + mqListenerName);
-	if (mq_unlink(mqListenerName.c_str()) == -1)
+	if (mqNativeListenerDesc != -1 && mq_unlink(mqListenerName.c_str()) == -1)
 		PrintErrorCode("unlink failed");
-	if (mqListenerDesc != InvalidTransportWorkDesc && !InterruptWorker(mqListenerDesc))
-		PrintError("Interrupt worker failed");
 
 	return true;
 }
@@ -96,7 +88,18 @@ bool ClientMessageQueue::finalizeTransport()
 {
 	PrintDebug("mqNativeListenerDesc = " + to_string(mqNativeListenerDesc));
 	PrintDebug("mqNativeClientTransmitterDesc = " + to_string(mqNativeClientTransmitterDesc));
-	return mq_close(mqNativeListenerDesc) != -1 && mq_close(mqNativeClientTransmitterDesc) != -1;
+	bool retVal = true;
+
+	/* Init may have failed half way */
+	if (mqNativeListenerDesc != -1 && mq_close(mqNativeListenerDesc) == -1)
+		retVal = false;
+	if (mqNativeClientTransmitterDesc != -1 && mq_close(mqNativeClientTransmitterDesc) == -1)
+		retVal = false;
+	mqNativeListenerDesc = -1;
+	mqNativeClientTransmitterDesc = -1;
+	txContext.reset();
+
+	return retVal;
 }
 
 bool ClientMessageQueue::writeTransportClientId(Message *msg)
@@ -0,0 +1,40 @@
+/*! \file notification_msg.cpp
+    \brief Client notification message class. Implements client specific functionality.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <client/notification_msg.hpp>
+#include <common/print.hpp>
+
+using namespace JClkLibClient;
+using namespace JClkLibCommon;
+using namespace std;
+
+MAKE_RXBUFFER_TYPE(ClientNotificationMessage::buildMessage)
+{
+	msg = MessagePool<ClientNotificationMessage>::get();
+
+	return true;
+}
+
+bool ClientNotificationMessage::initMessage()
+{
+	addMessageType(parseMsgMapElement_t(NOTIFY_MESSAGE, buildMessage));
+	return true;
+}
+
+PROCESS_MESSAGE_TYPE(ClientNotificationMessage::processMessage)
+{
+	PrintDebug("Processing client notification message");
+
+	if (get_instance() != state.get_instance()) {
+		PrintDebug("Notification for instance " + to_string(get_instance()) + " ignored");
+		return true;
+	}
+	state.setNotification(getc_event(), getc_eventCount(), get_gmOffset());
+
+	this->set_msgAck(ACK_NONE);
+	return true;
+}
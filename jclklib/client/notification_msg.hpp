@@ -0,0 +1,45 @@
+/*! \file notification_msg.hpp
+    \brief Client notification message class. Implements client specific functionality.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#ifndef CLIENT_NOTIFICATION_MSG_HPP
+#define CLIENT_NOTIFICATION_MSG_HPP
+
+#include <common/notification_msg.hpp>
+#include <client/message.hpp>
+
+namespace JClkLibClient
+{
+	class ClientNotificationMessage : virtual public JClkLibCommon::NotificationMessage,
+					  virtual public ClientMessage
+	{
+	public:
+		ClientNotificationMessage() : MESSAGE_NOTIFY() {};
+		/**
+		 * @brief process the notification from proxy.
+		 * @param LxContext client run-time transport listener context
+		 * @param TxContext client run-time transport transmitter context
+		 * @return true
+		 */
+		virtual PROCESS_MESSAGE_TYPE(processMessage);
+
+		/**
+		 * @brief Create the ClientNotificationMessage object
+		 * @param msg msg structure to be fill up
+		 * @param LxContext client run-time transport listener context
+		 * @return true
+		 */
+		static MAKE_RXBUFFER_TYPE(buildMessage);
+
+		/**
+		 * @brief Add client's NOTIFY_MESSAGE type and its builder to transport layer.
+		 * @return true
+		 */
+		static bool initMessage();
+	};
+}
+
+#endif/*CLIENT_NOTIFICATION_MSG_HPP*/
@@ -0,0 +1,72 @@
+/*! \file ringtest.cpp
+    \brief Shared memory ring full test
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <common/shm_tport.hpp>
+
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+#include <errno.h>
+
+using namespace JClkLibCommon;
+using namespace std;
+
+/* Proxy side of the ring, without the proxy */
+class RingTestTransmitter : public ShmRingTransmitterContext
+{
+public:
+	bool open(const string &name) { return openRing(name); }
+	bool send(uint8_t value)
+	{
+		get_buffer()[0] = value;
+		set_offset(1);
+		return sendBuffer();
+	}
+};
+
+static bool check(bool ok, const string &what)
+{
+	if (!ok)
+		cerr << "FAIL: " << what << endl;
+	return ok;
+}
+
+int main()
+{
+	string name = SHM_RING_PREFIX "test." + to_string(getpid());
+	ShmRing consumer;
+	RingTestTransmitter producer;
+	TransportBuffer data;
+	size_t length;
+	bool ok = true;
+
+	if (!check(consumer.create(name) && producer.open(name), "open ring " + name))
+		return 1;
+
+	/* Fill the ring */
+	for (unsigned i = 0; i < SHM_RING_SLOTS; ++i)
+		ok &= check(producer.send(i), "send to slot " + to_string(i));
+	/* Full ring is reported as EAGAIN, so the caller can drop or retry */
+	errno = 0;
+	ok &= check(!producer.send(SHM_RING_SLOTS), "send to a full ring fails");
+	ok &= check(errno == EAGAIN, "full ring error is EAGAIN");
+
+	/* Free one slot, the retry succeeds */
+	ok &= check(consumer.pop(data, length) && length == 1 && data[0] == 0, "pop the oldest message");
+	ok &= check(producer.send(SHM_RING_SLOTS), "send after pop");
+
+	/* Messages keep their order, the failed send did not overwrite a slot */
+	for (unsigned i = 1; i <= SHM_RING_SLOTS; ++i)
+		ok &= check(consumer.pop(data, length) && data[0] == i, "pop message " + to_string(i));
+	ok &= check(!consumer.pop(data, length), "ring is empty");
+
+	cout << (ok ? "PASS" : "FAIL") << endl;
+
+	return ok ? 0 : 1;
+}
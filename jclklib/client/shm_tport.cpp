@@ -0,0 +1,80 @@
+/*! \file shm_tport.cpp
+    \brief Client shared memory ring transport implementation.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <client/shm_tport.hpp>
+#include <client/connect_msg.hpp>
+
+#include <common/util.hpp>
+#include <common/print.hpp>
+
+#include <cstring>
+
+#include <unistd.h>
+
+using namespace JClkLibClient;
+using namespace JClkLibCommon;
+using namespace std;
+
+DECLARE_STATIC(ClientShmRing::ring);
+DECLARE_STATIC(ClientShmRing::ringName,"");
+DECLARE_STATIC(ClientShmRing::ringListenerDesc,InvalidTransportWorkDesc);
+
+LISTENER_CONTEXT_PROCESS_MESSAGE_TYPE(ClientShmRingListenerContext::processMessage)
+{
+	PrintDebug("Processing received client message");
+
+	/* Only client message types are registered, no cast is needed */
+	return bmsg->processMessage(*this,txcontext);
+}
+
+bool ClientShmRing::initTransport()
+{
+	PrintInfo("Initializing Shared Memory Ring Client Transport...");
+	ringName = SHM_RING_PREFIX + to_string(getpid());
+	/* Not fatal, the proxy then replies on the message queue */
+	if (!ring.create(ringName)) {
+		PrintDebug("Shared memory ring is not available");
+		return true;
+	}
+
+	if (InvalidTransportWorkDesc ==
+	    (ringListenerDesc = registerWork
+	     (ShmRingListener(new ClientShmRingListenerContext(&ring))) )) {
+		PrintError("Listener Thread Unexpectedly Exited");
+		ring.close();
+		return false;
+	}
+
+	PrintDebug("Client shared memory ring opened");
+
+	return true;
+}
+
+bool ClientShmRing::stopTransport()
+{
+	PrintInfo("Stopping Shared Memory Ring Client Transport");
+	/* Wakes the listener, the dispatch loop then sees the exit flag */
+	ring.shutdown();
+
+	return true;
+}
+
+bool ClientShmRing::finalizeTransport()
+{
+	ring.close();
+
+	return true;
+}
+
+bool ClientShmRing::writeTransportClientId(Message *msg)
+{
+	ClientConnectMessage *cmsg = dynamic_cast<decltype(cmsg)>(msg);
+	if (cmsg == NULL || !ring.isOpen())
+		return false;
+	strcpy((char *)cmsg->getClientId().data(), ringName.c_str());
+	return true;
+}
@@ -0,0 +1,43 @@
+/*! \file shm_tport.hpp
+    \brief Client shared memory ring transport class.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <cstdint>
+#include <string>
+
+#ifndef CLIENT_SHM_TPORT_HPP
+#define CLIENT_SHM_TPORT_HPP
+
+#include <client/transport.hpp>
+#include <common/shm_tport.hpp>
+#include <common/util.hpp>
+
+namespace JClkLibClient
+{
+	class ClientShmRingListenerContext : public JClkLibCommon::ShmRingListenerContext
+	{
+		friend class ClientShmRing;
+	protected:
+		virtual LISTENER_CONTEXT_PROCESS_MESSAGE_TYPE(processMessage);
+		ClientShmRingListenerContext(JClkLibCommon::ShmRing *ring) : ShmRingListenerContext(ring) {}
+	};
+
+	/* Receive only, messages to the proxy are sent on the message queue */
+	class ClientShmRing : public JClkLibCommon::SharedMemoryRing, public ClientTransport
+	{
+	private:
+		static JClkLibCommon::ShmRing ring;
+		static std::string ringName;
+		static TransportWorkDesc ringListenerDesc;
+	public:
+		static bool initTransport();
+		static bool stopTransport();
+		static bool finalizeTransport();
+		static bool writeTransportClientId(JClkLibCommon::Message *msg);
+	};
+}
+
+#endif/*CLIENT_SHM_TPORT_HPP*/
@@ -0,0 +1,51 @@
+/*! \file subscribe_msg.cpp
+    \brief Client subscribe message class. Implements client specific functionality.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <client/subscribe_msg.hpp>
+#include <common/print.hpp>
+
+using namespace JClkLibClient;
+using namespace JClkLibCommon;
+using namespace std;
+
+MAKE_RXBUFFER_TYPE(ClientSubscribeMessage::buildMessage)
+{
+	msg = MessagePool<ClientSubscribeMessage>::get();
+
+	return true;
+}
+
+bool ClientSubscribeMessage::initMessage()
+{
+	addMessageType(parseMsgMapElement_t(SUBSCRIBE_MSG, buildMessage));
+	return true;
+}
+
+/** @brief process the reply for subscribe msg from proxy.
+ *
+ * The proxy echoes the subscribe message with the ACK field.
+ * A failure means the proxy does not supervise the requested ptp4l instance.
+ *
+ * @param LxContext client run-time transport listener context
+ * @param TxContext client run-time transport transmitter context
+ * @return true
+ */
+PROCESS_MESSAGE_TYPE(ClientSubscribeMessage::processMessage)
+{
+	PrintDebug("Processing client subscribe message (reply)");
+
+	if (get_msgAck() != ACK_SUCCESS) {
+		PrintError("Subscription to instance " + to_string(get_instance()) + " failed");
+		state.set_subscribed(false);
+	} else {
+		state.set_subscribed(true);
+		state.set_instance(get_instance());
+	}
+
+	this->set_msgAck(ACK_NONE);
+	return true;
+}
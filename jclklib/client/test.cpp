@@ -8,14 +8,37 @@
 #include "init.hpp"
 
 #include <unistd.h>
+#include <iostream>
 
 using namespace JClkLibClient;
+using namespace JClkLibCommon;
 using namespace std;
 
 int main()
 {
-	connect();
-	sleep(1);
+	jcl_event event;
+	jcl_eventcount count;
+	int64_t gmOffset;
+	jcl_subscription sub = {};
+
+	sub.get_event().set(gmPresentEvent, true);
+	sub.get_event().set(servoLockedEvent, true);
+	/* Notify when the offset leaves or re-enters +/-100 ns */
+	sub.get_event().set(gmOffsetEvent, true);
+	sub.get_value().setLimits(gmOffsetValue, 100, 100);
+
+	if (!connect())
+		goto do_exit;
+	subscribe(sub);
+	if (getStatus(event, count, gmOffset))
+		cout << "GM present " << event.isSet(gmPresentEvent) << " servo locked "
+		     << event.isSet(servoLockedEvent) << " offset " << gmOffset << endl;
+	/* Report the next few notifications */
+	for (int i = 0; i < 3 && waitEvent(sub.get_event(), 10000) > 0; ++i) {
+		getNotification(event, count, gmOffset);
+		cout << "Notification offset in window " << event.isSet(gmOffsetEvent)
+		     << " servo locked " << event.isSet(servoLockedEvent) << " offset " << gmOffset << endl;
+	}
  do_exit:
 	disconnect();
 }
@@ -8,6 +8,7 @@
 #include <client/transport.hpp>
 #include <client/null_tport.hpp>
 #include <client/msgq_tport.hpp>
+#include <client/shm_tport.hpp>
 #include <common/print.hpp>
 #include <common/sighandler.hpp>
 #include <common/util.hpp>
@@ -22,7 +23,7 @@ bool ClientTransport::init()
 		return false;
 	PrintDebug("Finished common init");
 	
-	return JClkLibCommon::_initTransport<ClientMessageQueue>();
+	return JClkLibCommon::_initTransport<ClientShmRing,ClientMessageQueue>();
 }
 
 bool ClientTransport::stop()
@@ -31,7 +32,7 @@ bool ClientTransport::stop()
 		return false;
 
 	/* Do any transport specific stop */
-	return JClkLibCommon::_stopTransport<ClientMessageQueue>();
+	return JClkLibCommon::_stopTransport<ClientShmRing,ClientMessageQueue>();
 }
 
 bool ClientTransport::finalize()
@@ -39,6 +40,6 @@ bool ClientTransport::finalize()
 	if (!Transport::finalize())
 		return false;
 
-	return JClkLibCommon::_finalizeTransport<ClientMessageQueue>();
+	return JClkLibCommon::_finalizeTransport<ClientShmRing,ClientMessageQueue>();
 }
 
@@ -109,6 +109,22 @@ void jcl_event::zero()
 	memset(reserved, 0, sizeof(reserved));
 }
 
+bool jcl_event::isSet(eventType e) const
+{
+	return (event_mask[e / (sizeof(event_mask[0]) * BITS_PER_BYTE)] &
+		(1U << (e % (sizeof(event_mask[0]) * BITS_PER_BYTE)))) != 0;
+}
+
+void jcl_event::set(eventType e, bool on)
+{
+	std::uint32_t bit = 1U << (e % (sizeof(event_mask[0]) * BITS_PER_BYTE));
+
+	if (on)
+		event_mask[e / (sizeof(event_mask[0]) * BITS_PER_BYTE)] |= bit;
+	else
+		event_mask[e / (sizeof(event_mask[0]) * BITS_PER_BYTE)] &= ~bit;
+}
+
 bool jcl_event::equal(const jcl_event &c)
 {
 	if (memcmp(this->event_mask, c.event_mask, sizeof(event_mask)) == 0)
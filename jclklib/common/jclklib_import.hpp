@@ -37,6 +37,11 @@ namespace JClkLibCommon
 	public:
 		std::uint8_t *parse(std::uint8_t *buf, std::size_t &length);
 		std::uint8_t *write(std::uint8_t *buf, std::size_t &length);
+		/* Limits of the value window, zero for no limit */
+		std::uint32_t getUpper(valueType v) const { return value[v].upper; }
+		std::uint32_t getLower(valueType v) const { return value[v].lower; }
+		void setLimits(valueType v, std::uint32_t upper, std::uint32_t lower)
+		{ value[v].upper = upper; value[v].lower = lower; }
 		bool equal( const jcl_value &c);
 		bool operator== (const jcl_value &value) { return this->equal(value); }
 		bool operator!= (const jcl_value &value) { return !this->equal(value); }
@@ -59,6 +64,8 @@ namespace JClkLibCommon
 		std::uint8_t *parse(std::uint8_t *buf, std::size_t &length);
 		std::uint8_t *write(std::uint8_t *buf, std::size_t &length);
 		void zero();
+		bool isSet(eventType e) const;
+		void set(eventType e, bool on);
 		bool equal( const jcl_event &c);
 		bool operator== (const jcl_event &event) { return this->equal(event); }
 		bool operator!= (const jcl_event &event) { return !this->equal(event); }
@@ -73,6 +80,8 @@ namespace JClkLibCommon
 		std::uint8_t *parse(std::uint8_t *buf, std::size_t &length);
 		std::uint8_t *write(std::uint8_t *buf, std::size_t &length);
 		void zero();
+		std::uint32_t get(eventType e) const { return count[e]; }
+		void increment(eventType e) { ++count[e]; }
 		bool equal(const jcl_eventcount &ec);
 		bool operator== (const jcl_eventcount &ec) { return this->equal(ec); }
 		bool operator!= (const jcl_eventcount &ec) { return !this->equal(ec); }
@@ -7,6 +7,10 @@ namespace JClkLibCommon {
 	typedef std::uint16_t sessionId_t;
 	static const sessionId_t InvalidSessionId = (sessionId_t)(-1);
 
+	/* ptp4l instance supervised by the proxy */
+	typedef std::uint8_t instanceId_t;
+	static const instanceId_t BestInstanceId = (instanceId_t)(-1);
+
 	typedef std::uint8_t msgAck_t;
 	enum  : msgAck_t {ACK_FAIL = (msgAck_t)-1, ACK_NONE = 0, ACK_SUCCESS = 1, };
 
@@ -14,13 +14,14 @@
 using namespace JClkLibCommon;
 using namespace std;
 
-DECLARE_STATIC(Message::parseMsgMap);
+DECLARE_STATIC(Message::parseMsgArray);
 
 Message::Message(decltype(msgId) msgId)
  {
 	 this->msgId = msgId;
 	 this->msgAck = ACK_NONE;
 	 this->sessionId = InvalidSessionId;
+	 this->recycle = NULL;
  }
 
 string Message::ExtractClassName(string prettyFunction, string function)
@@ -45,6 +46,7 @@ string Message::toString()
 
 	ret += PRIMITIVE_TOSTRING(msgId);
 	ret += PRIMITIVE_TOSTRING(msgAck);
+	ret += PRIMITIVE_TOSTRING(sessionId);
 
 	return ret;
 }
@@ -55,6 +57,8 @@ BUILD_TXBUFFER_TYPE(Message::makeBuffer) const
 		return false;
 	if (!WRITE_TX(FIELD,msgAck,TxContext))
 		return false;
+	if (!WRITE_TX(FIELD,sessionId,TxContext))
+		return false;
 
 	return true;
 }
@@ -75,10 +79,9 @@ COMMON_PRESEND_MESSAGE_TYPE(Message::presendMessage)
 
 bool Message::addMessageType(parseMsgMapElement_t mapping)
 {
-	decltype(parseMsgMap)::size_type size = parseMsgMap.size();
-	parseMsgMap.insert(mapping);
-	if (parseMsgMap.size() == size)
+	if (parseMsgArray[mapping.first])
 		return false;
+	parseMsgArray[mapping.first] = mapping.second;
 
 	PrintDebug("Added message type: " + to_string(mapping.first));
 	
@@ -91,6 +94,8 @@ PARSE_RXBUFFER_TYPE(Message::parseBuffer)
 		return false;
 	if (!PARSE_RX(FIELD,msgAck, LxContext))
 		return false;
+	if (!PARSE_RX(FIELD,sessionId, LxContext))
+		return false;
 
 	return true;
 }
@@ -98,23 +103,32 @@ PARSE_RXBUFFER_TYPE(Message::parseBuffer)
 MAKE_RXBUFFER_TYPE(Message::buildMessage)
 {
 	msgId_t msgId;
-	decltype(parseMsgMap)::iterator it;
 
 	if (!PARSE_RX(FIELD,msgId,LxContext))
 		return false;
 	
-	it = parseMsgMap.find(msgId);
-	if (it == parseMsgMap.cend()) {
+	const BuildMessage_t &build = parseMsgArray[msgId];
+	if (!build) {
 		PrintError("Unknown message type " + to_string(msgId));
 		return false;
 	}
-	if (!it->second(msg, LxContext)) {
+	if (!build(msg, LxContext)) {
 		PrintError("Error parsing message");
 		return false;
 	}
 	LxContext.resetOffset();
-	if (!msg->parseBuffer(LxContext))
+	if (!msg->parseBuffer(LxContext)) {
+		releaseMessage(msg);
 		return false;
+	}
 
 	return true;
 }
+
+void Message::releaseMessage(Message *msg)
+{
+	if (msg->recycle != NULL)
+		msg->recycle(msg);
+	else
+		delete msg;
+}
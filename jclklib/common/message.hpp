@@ -5,9 +5,11 @@
     Author: Christopher Hall <christopher.s.hall@intel.com>
 */
 
-#include <map>
+#include <array>
+#include <vector>
 #include <memory>
 #include <functional>
+#include <limits>
 
 #ifndef COMMON_MESSAGE_HPP
 #define COMMON_MESSAGE_HPP
@@ -27,14 +29,19 @@ namespace JClkLibCommon
 
 	typedef std::pair<msgId_t,BuildMessage_t> parseMsgMapElement_t;
 	
+	template <typename T> class MessagePool;
+
 	class Message
 	{
+		template <typename T> friend class MessagePool;
 	private:
-		static std::map<decltype(parseMsgMapElement_t::first),
-				decltype(parseMsgMapElement_t::second)> parseMsgMap;
+		/* Builders indexed by the message ID */
+		static std::array<BuildMessage_t, std::numeric_limits<msgId_t>::max()+1> parseMsgArray;
 		msgId_t msgId;
 		msgAck_t msgAck;
 		sessionId_t sessionId;
+		/* Return to the pool of the message type, NULL if not from a pool */
+		void (*recycle)(Message *msg);
 
 	protected:
 		Message(decltype(msgId) msgId);
@@ -55,6 +62,8 @@ namespace JClkLibCommon
 		virtual TRANSMIT_MESSAGE_TYPE(transmitMessage) = 0;
 
 		static MAKE_RXBUFFER_TYPE(buildMessage);
+		/* Release a message from buildMessage() */
+		static void releaseMessage(Message *msg);
 
 #define PARSE_RXBUFFER_TYPE(name)					\
 	bool name (::JClkLibCommon::TransportListenerContext &LxContext)
@@ -73,6 +82,39 @@ namespace JClkLibCommon
 		static bool init() { return false; }
 	};
 
+	/* Free messages of a type, per thread, the receive path does not allocate after warm up.
+	   A received message is built, processed and released by the same thread. */
+#define MESSAGE_POOL_MAX (16)
+	template <typename T>
+	class MessagePool
+	{
+	private:
+		static thread_local std::vector<std::unique_ptr<Message>> freeList;
+		static void put(Message *msg)
+		{
+			if (freeList.size() < MESSAGE_POOL_MAX)
+				freeList.emplace_back(msg);
+			else
+				delete msg;
+		}
+	public:
+		static Message *get()
+		{
+			Message *msg;
+
+			if (freeList.empty()) {
+				msg = new T();
+				msg->recycle = put;
+				return msg;
+			}
+			msg = freeList.back().release();
+			freeList.pop_back();
+			return msg;
+		}
+	};
+	template <typename T>
+	thread_local std::vector<std::unique_ptr<Message>> MessagePool<T>::freeList;
+
 	template <typename T>
 	inline bool _initMessage()
 	{
@@ -8,7 +8,6 @@
 #include <common/msgq_tport.hpp>
 #include <common/message.hpp>
 
-#include <common/sighandler.hpp>
 #include <common/util.hpp>
 #include <common/print.hpp>
 
@@ -56,27 +55,25 @@ int mqRecvWrapper(mqd_t mqDesc, uint8_t *data, size_t length)
 	return ret;
 }
 
-bool MessageQueue::MqListenerWork(TransportContext *mqListenerContext)
+Transport::TransportWork MessageQueue::MqListener(MessageQueueListenerContext *context)
 {
-	MessageQueueListenerContext *context = dynamic_cast<decltype(context)>(mqListenerContext);
-
-	if(!context) {
-		PrintError("Internal Error: Received inappropriate context");
-	}
-	if (context->init() && !EnableSyscallInterruptSignal()) {
-		PrintError("Unable to enable interrupts in work process context");
-		return false;
-	}
+	/* Keep the typed context, no cast on each message */
+	return TransportWork([context](TransportContext *) { return MqListenerWork(context); },
+			     TransportWorkArg(context));
+}
 
+bool MessageQueue::MqListenerWork(MessageQueueListenerContext *context)
+{
 	int ret = mqRecvWrapper(context->mqListenerDesc, context->get_buffer().data(), context->getc_buffer().max_size());
 	if (ret < 0) {
-		if (ret != -EINTR)
+		/* Another worker may have taken the message */
+		if (ret != -EAGAIN && ret != -EINTR)
 			PrintError("MQ Receive Failed",-ret);
-		return ret != -EINTR ? false : true;
+		return ret != -EAGAIN && ret != -EINTR ? false : true;
 	}
 	PrintDebug("Receive complete");
 
-	DumpOctetArray("Received Message", context->getc_buffer().data(), context->getc_buffer().max_size());
+	DumpOctetArray("Received Message", context->getc_buffer().data(), ret);
 
 	Transport::processMessage(*context);
 	
@@ -86,7 +83,14 @@ bool MessageQueue::MqListenerWork(TransportContext *mqListenerContext)
 SEND_BUFFER_TYPE(MessageQueueTransmitterContext::sendBuffer)
 {
 	if (mq_send(mqTransmitterDesc, (char *)get_buffer().data(), get_offset(), 0) == -1) {
-		PrintErrorCode("Failed to send buffer");
+		int err = errno;
+
+		/* Queue opened non blocking is full, the caller decides to drop or retry */
+		if (err == EAGAIN)
+			PrintDebug("Failed to send buffer, queue is full");
+		else
+			PrintErrorCode("Failed to send buffer");
+		errno = err;
 		return false;
 	}
 
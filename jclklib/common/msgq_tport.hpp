@@ -22,7 +22,8 @@
 #define MESSAGE_QUEUE_PREFIX "/jclklib"
 
 #define TX_QUEUE_FLAGS (O_WRONLY)
-#define RX_QUEUE_FLAGS (O_RDONLY | O_CREAT)
+/* Listener is run by the transport reactor when the queue is readable */
+#define RX_QUEUE_FLAGS (O_RDONLY | O_CREAT | O_NONBLOCK)
 #define RX_QUEUE_MODE  (S_IRUSR | S_IWUSR | S_IWGRP)
 
 namespace JClkLibCommon
@@ -54,7 +55,9 @@ namespace JClkLibCommon
 		static std::string const mqProxyName;
 		static TransportWorkDesc mqListenerDesc;
 		static mqd_t mqNativeListenerDesc;
-		static bool MqListenerWork(TransportContext *mqListenerContext);
+		static bool MqListenerWork(MessageQueueListenerContext *context);
+		/* Listener work bound to its context */
+		static TransportWork MqListener(MessageQueueListenerContext *context);
 		static bool MqTransmit(TransportContext *mqTransmitterContext, Message *msg);
 	public:
 		static bool initTransport() { return true; };
@@ -7,13 +7,58 @@
 
 #include <common/serialize.hpp>
 #include <common/notification_msg.hpp>
+#include <common/print.hpp>
 
 using namespace JClkLibCommon;
 using namespace std;
 
-MAKE_RXBUFFER_TYPE(NotificationMessage::buildMessage)
+string NotificationMessage::toString()
 {
-	// Fill in the fields
-	
+	string name = ExtractClassName(string(__PRETTY_FUNCTION__),string(__FUNCTION__));
+	name += "\n";
+	name += Message::toString();
+	name += PRIMITIVE_TOSTRING(gmOffset);
+	name += PRIMITIVE_TOSTRING(instance);
+
+	return name;
+}
+
+PARSE_RXBUFFER_TYPE(NotificationMessage::parseBuffer)
+{
+	if (!Message::parseBuffer(LxContext))
+		return false;
+	if (!PARSE_RX(FIELD,event,LxContext))
+		return false;
+	if (!PARSE_RX(FIELD,eventCount,LxContext))
+		return false;
+	if (!PARSE_RX(FIELD,gmOffset,LxContext))
+		return false;
+	if (!PARSE_RX(FIELD,instance,LxContext))
+		return false;
+
+	return true;
+}
+
+BUILD_TXBUFFER_TYPE(NotificationMessage::makeBuffer) const
+{
+	if (!Message::makeBuffer(TxContext))
+		return false;
+	if (!WRITE_TX(FIELD,event,TxContext))
+		return false;
+	if (!WRITE_TX(FIELD,eventCount,TxContext))
+		return false;
+	if (!WRITE_TX(FIELD,gmOffset,TxContext))
+		return false;
+	if (!WRITE_TX(FIELD,instance,TxContext))
+		return false;
+
 	return true;
 }
+
+TRANSMIT_MESSAGE_TYPE(NotificationMessage::transmitMessage)
+{
+	if (!presendMessage(&TxContext))
+		return false;
+
+	return TxContext.sendBuffer();
+}
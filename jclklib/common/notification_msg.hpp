@@ -15,22 +15,30 @@
 
 namespace JClkLibCommon
 {
-	class NotificationMessage : public Message
+	/* Sent by the proxy when a subscribed event or value window is crossed.
+	   The gmOffsetEvent bit is set while the GM offset is in the window. */
+	class NotificationMessage : virtual public Message
 	{
+	private:
+		jcl_event	event;
+		jcl_eventcount	eventCount;
+		std::int64_t	gmOffset;
+		instanceId_t	instance;
 	public:
-		static msgId_t getMsgId() { return SUBSCRIBE_MSG; }
-		static MAKE_RXBUFFER_TYPE(buildMessage);
+		static msgId_t getMsgId() { return NOTIFY_MESSAGE; }
+
+		virtual PARSE_RXBUFFER_TYPE(parseBuffer);
+		virtual TRANSMIT_MESSAGE_TYPE(transmitMessage);
+		virtual BUILD_TXBUFFER_TYPE(makeBuffer) const;
+		virtual std::string toString();
 
-		const jcl_eventcount	&getEventCount();
-		const jcl_event		&getEvent();
-		bool			 isEnable() { return waitEnable == 0x1; }
+		DECLARE_ACCESSOR(event);
+		DECLARE_ACCESSOR(eventCount);
+		DECLARE_ACCESSOR(gmOffset);
+		DECLARE_ACCESSOR(instance);
 	protected:
 #define MESSAGE_NOTIFY() JClkLibCommon::Message(JClkLibCommon::NOTIFY_MESSAGE)
-		NotificationMessage() : MESSAGE_NOTIFY() {}
-	private:
-		std::uint32_t	waitEnable :1;
-		jcl_event	event;
-		jcl_eventcount	eventCount;
+		NotificationMessage() : MESSAGE_NOTIFY(), gmOffset(0), instance(BestInstanceId) {}
 	};
 }
 
@@ -14,6 +14,13 @@
 using namespace std;
 using namespace JClkLibCommon;
 
+int JClkLibCommon::logLevel = JCLKLIB_LOG_LEVEL;
+
+void JClkLibCommon::setLogLevel(int level)
+{
+	logLevel = level;
+}
+
 void JClkLibCommon::_PrintError(std::string msg, uint16_t line, std::string file, std::string func,
 			      errno_type errnum)
 {
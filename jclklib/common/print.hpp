@@ -13,6 +13,16 @@
 
 namespace JClkLibCommon
 {
+	/* Levels above JCLKLIB_LOG_LEVEL are compiled out, levels above
+	   the runtime level are skipped. A skipped print does not evaluate its arguments. */
+	enum logLevel_t : int { LOG_ERROR = 0, LOG_INFO, LOG_DEBUG };
+#ifndef JCLKLIB_LOG_LEVEL
+#define JCLKLIB_LOG_LEVEL 2 // LOG_DEBUG
+#endif
+	extern int logLevel;
+	void setLogLevel(int level);
+#define LOG_ENABLED(level)						\
+	((level) <= JCLKLIB_LOG_LEVEL && (level) <= ::JClkLibCommon::logLevel)
 
 	typedef std::remove_reference<decltype(errno)>::type errno_type;
 #define PrintErrorCode(msg) PrintError(msg, errno)
@@ -21,13 +31,26 @@ namespace JClkLibCommon
 	void _PrintError(std::string msg, uint16_t line, std::string file, std::string func,
 			errno_type errnum = (errno_type)-1);
 
-#define PrintDebug(msg) ::JClkLibCommon::_PrintDebug(msg, __LINE__, __FILE__, __func__)
-#define PrintInfo(msg) ::JClkLibCommon::_PrintInfo(msg, __LINE__, __FILE__, __func__)
+#define PrintDebug(msg)							\
+	do {								\
+		if (LOG_ENABLED(::JClkLibCommon::LOG_DEBUG))		\
+			::JClkLibCommon::_PrintDebug(msg, __LINE__, __FILE__, __func__); \
+	} while (0)
+#define PrintInfo(msg)							\
+	do {								\
+		if (LOG_ENABLED(::JClkLibCommon::LOG_INFO))		\
+			::JClkLibCommon::_PrintInfo(msg, __LINE__, __FILE__, __func__); \
+	} while (0)
 	
 	void _PrintDebug(std::string msg, uint16_t line, std::string file, std::string func);
 	void _PrintInfo(std::string msg, uint16_t line, std::string file, std::string func);
 
-#define DumpOctetArray(msg,arr,size) JClkLibCommon::_DumpOctetArray(msg, arr, size, __LINE__, __FILE__, __func__)
+	/* Dumps are debug output */
+#define DumpOctetArray(msg,arr,size)					\
+	do {								\
+		if (LOG_ENABLED(::JClkLibCommon::LOG_DEBUG))		\
+			::JClkLibCommon::_DumpOctetArray(msg, arr, size, __LINE__, __FILE__, __func__); \
+	} while (0)
 
  	void _DumpOctetArray(std::string msg, const std::uint8_t *arr, std::size_t length, std::uint16_t line, std::string file,
 			     std::string func);
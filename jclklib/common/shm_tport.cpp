@@ -0,0 +1,237 @@
+/*! \file shm_tport.cpp
+    \brief Common shared memory ring transport implementation.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <common/shm_tport.hpp>
+#include <common/message.hpp>
+#include <common/print.hpp>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include <errno.h>
+
+using namespace JClkLibCommon;
+using namespace std;
+
+static inline long futex(atomic<uint32_t> *addr, int op, uint32_t val)
+{
+	/* Shared futex, the proxy and the client are different processes */
+	return syscall(SYS_futex, (uint32_t *)addr, op, val, NULL, NULL, 0);
+}
+
+bool ShmRing::map(int fd)
+{
+	void *addr = mmap(NULL, sizeof(ShmRingLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		PrintErrorCode("Failed to map ring " + name);
+		return false;
+	}
+	ring = (ShmRingLayout *)addr;
+
+	return true;
+}
+
+bool ShmRing::create(const string &name)
+{
+	int fd;
+
+	if (ring != nullptr)
+		return true;
+	this->name = name;
+	fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, SHM_RING_MODE);
+	if (fd == -1) {
+		PrintErrorCode("Failed to create ring " + name);
+		return false;
+	}
+	if (ftruncate(fd, sizeof(ShmRingLayout)) == -1) {
+		PrintErrorCode("Failed to size ring " + name);
+		::close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+	if (!map(fd)) {
+		shm_unlink(name.c_str());
+		return false;
+	}
+	owner = true;
+	/* New shared memory is zero filled */
+	ring->size = sizeof(ShmRingLayout);
+
+	return true;
+}
+
+bool ShmRing::open(const string &name)
+{
+	int fd;
+	struct stat st;
+
+	if (ring != nullptr)
+		return true;
+	this->name = name;
+	fd = shm_open(name.c_str(), O_RDWR, 0);
+	if (fd == -1) {
+		PrintErrorCode("Failed to open ring " + name);
+		return false;
+	}
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(ShmRingLayout)) {
+		PrintError("Ring size mismatch " + name);
+		::close(fd);
+		return false;
+	}
+	if (!map(fd))
+		return false;
+	if (ring->size != sizeof(ShmRingLayout)) {
+		PrintError("Ring layout mismatch " + name);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void ShmRing::close()
+{
+	if (ring == nullptr)
+		return;
+	munmap(ring, sizeof(ShmRingLayout));
+	ring = nullptr;
+	if (owner)
+		shm_unlink(name.c_str());
+	owner = false;
+}
+
+bool ShmRing::push(const uint8_t *data, size_t length)
+{
+	uint32_t head, tail;
+
+	if (ring == nullptr) {
+		errno = EBADF;
+		return false;
+	}
+	if (length > sizeof(TransportBuffer)) {
+		errno = EMSGSIZE;
+		return false;
+	}
+	head = ring->head.load(memory_order_relaxed);
+	tail = ring->tail.load(memory_order_acquire);
+	if (head - tail >= SHM_RING_SLOTS) {
+		errno = EAGAIN;
+		return false;
+	}
+	auto &slot = ring->slots[head % SHM_RING_SLOTS];
+	memcpy(slot.data.data(), data, length);
+	slot.length = length;
+	ring->head.store(head + 1, memory_order_release);
+
+	/* Pairs with the consumer, which sets waiting before it checks the ring */
+	atomic_thread_fence(memory_order_seq_cst);
+	ring->wake.fetch_add(1, memory_order_relaxed);
+	if (ring->waiting.load(memory_order_relaxed))
+		futex(&ring->wake, FUTEX_WAKE, 1);
+
+	return true;
+}
+
+bool ShmRing::pop(TransportBuffer &data, size_t &length)
+{
+	uint32_t head, tail;
+
+	if (ring == nullptr)
+		return false;
+	tail = ring->tail.load(memory_order_relaxed);
+	head = ring->head.load(memory_order_acquire);
+	if (head == tail)
+		return false;
+	auto &slot = ring->slots[tail % SHM_RING_SLOTS];
+	length = slot.length;
+	memcpy(data.data(), slot.data.data(), length);
+	ring->tail.store(tail + 1, memory_order_release);
+
+	return true;
+}
+
+bool ShmRing::wait()
+{
+	uint32_t wake;
+
+	if (ring == nullptr)
+		return false;
+	wake = ring->wake.load(memory_order_relaxed);
+	ring->waiting.store(1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (ring->head.load(memory_order_relaxed) == ring->tail.load(memory_order_relaxed) &&
+	    !ring->closed.load(memory_order_relaxed))
+		/* Returns at once if the producer pushed since we read the futex word */
+		futex(&ring->wake, FUTEX_WAIT, wake);
+	ring->waiting.store(0, memory_order_relaxed);
+
+	return !ring->closed.load(memory_order_acquire);
+}
+
+void ShmRing::shutdown()
+{
+	if (ring == nullptr)
+		return;
+	ring->closed.store(1, memory_order_release);
+	ring->wake.fetch_add(1, memory_order_seq_cst);
+	futex(&ring->wake, FUTEX_WAKE, INT32_MAX);
+}
+
+SEND_BUFFER_TYPE(ShmRingTransmitterContext::sendBuffer)
+{
+	if (!ring.push(get_buffer().data(), get_offset())) {
+		int err = errno;
+
+		/* The caller decides to drop or retry */
+		if (err == EAGAIN)
+			PrintDebug("Failed to send buffer, ring is full");
+		else
+			PrintErrorCode("Failed to send buffer");
+		errno = err;
+		return false;
+	}
+
+	return true;
+}
+
+bool SharedMemoryRing::isRingClientId(const TransportClientId &clientId)
+{
+	return strncmp((const char *)clientId.data(), SHM_RING_PREFIX, sizeof(SHM_RING_PREFIX) - 1) == 0;
+}
+
+Transport::TransportWork SharedMemoryRing::ShmRingListener(ShmRingListenerContext *context)
+{
+	/* Keep the typed context, no cast on each message */
+	return TransportWork([context](TransportContext *) { return ShmRingListenerWork(context); },
+			     TransportWorkArg(context));
+}
+
+bool SharedMemoryRing::ShmRingListenerWork(ShmRingListenerContext *context)
+{
+	size_t length;
+
+	if (!context->ring->pop(context->get_buffer(), length)) {
+		/* After a shutdown the dispatch loop checks for exit */
+		context->ring->wait();
+		return true;
+	}
+	PrintDebug("Receive complete");
+
+	DumpOctetArray("Received Message", context->getc_buffer().data(), length);
+
+	Transport::processMessage(*context);
+
+	return true;
+}
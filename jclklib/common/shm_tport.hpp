@@ -0,0 +1,107 @@
+/*! \file shm_tport.hpp
+    \brief Common shared memory ring transport class.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+#ifndef COMMON_SHM_TPORT_HPP
+#define COMMON_SHM_TPORT_HPP
+
+#include <common/transport.hpp>
+#include <common/util.hpp>
+
+/* Client ring name is the prefix and the client process ID */
+#define SHM_RING_PREFIX "/jclklib.ring."
+#define SHM_RING_MODE (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP)
+#define SHM_RING_SLOTS (16)
+#define SHM_CACHE_LINE (64)
+
+namespace JClkLibCommon
+{
+	/* Single producer (proxy), single consumer (client) ring.
+	   The producer owns head, the consumer owns tail. The consumer sleeps
+	   on a futex when the ring is empty, the producer wakes it only if
+	   it sleeps. */
+	struct ShmRingLayout
+	{
+		alignas(SHM_CACHE_LINE) std::atomic<std::uint32_t> head;
+		alignas(SHM_CACHE_LINE) std::atomic<std::uint32_t> tail;
+		alignas(SHM_CACHE_LINE) std::atomic<std::uint32_t> wake; // futex word
+		std::atomic<std::uint32_t> waiting;
+		std::atomic<std::uint32_t> closed;
+		std::uint32_t size; // Layout size, check proxy and client match
+		struct Slot {
+			std::uint32_t length;
+			TransportBuffer data;
+		} slots[SHM_RING_SLOTS];
+	};
+
+	class ShmRing
+	{
+	private:
+		ShmRingLayout *ring;
+		bool owner;
+		std::string name;
+		bool map(int fd);
+	public:
+		ShmRing() : ring(nullptr), owner(false) {}
+		~ShmRing() { close(); }
+		/* Consumer side, create the ring */
+		bool create(const std::string &name);
+		/* Producer side, open an existing ring */
+		bool open(const std::string &name);
+		void close();
+		bool isOpen() const { return ring != nullptr; }
+
+		/* Copy the message to the next slot and wake the consumer.
+		   On failure errno is EAGAIN if the ring is full */
+		bool push(const std::uint8_t *data, std::size_t length);
+		/* Copy the oldest message, false if empty */
+		bool pop(TransportBuffer &data, std::size_t &length);
+		/* Sleep until a message is pushed or the ring is shut down */
+		bool wait();
+		/* Wake the consumer for exit */
+		void shutdown();
+	};
+
+	class ShmRingListenerContext : virtual public TransportListenerContext {
+		friend class SharedMemoryRing;
+	private:
+		ShmRing *ring;
+	protected:
+		ShmRingListenerContext(ShmRing *ring) : ring(ring) {}
+	public:
+		virtual ~ShmRingListenerContext() = default;
+	};
+
+	class ShmRingTransmitterContext : virtual public TransportTransmitterContext {
+	private:
+		ShmRing ring;
+	protected:
+		ShmRingTransmitterContext() {}
+		bool openRing(const std::string &name) { return ring.open(name); }
+	public:
+		virtual ~ShmRingTransmitterContext() = default;
+		virtual SEND_BUFFER_TYPE(sendBuffer);
+	};
+
+	class SharedMemoryRing : public Transport
+	{
+	protected:
+		static bool ShmRingListenerWork(ShmRingListenerContext *context);
+		/* Listener work bound to its context */
+		static TransportWork ShmRingListener(ShmRingListenerContext *context);
+	public:
+		static bool isRingClientId(const TransportClientId &clientId);
+		static bool initTransport() { return true; };
+		static bool stopTransport() { return true; };
+		static bool finalizeTransport() { return true; };
+	};
+}
+
+#endif/*COMMON_SHM_TPORT_HPP*/
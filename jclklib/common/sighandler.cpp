@@ -12,8 +12,6 @@
 
 #include <signal.h>
 
-#define INTR_SIGNAL (SIGUSR1)
-
 using namespace JClkLibCommon;
 using namespace std;
 
@@ -89,36 +87,3 @@ bool JClkLibCommon::WaitForStopSignal()
 	
 	return true;
 }
-
-void NullSigaction(int sig, siginfo_t *siginfo, void *ctx) {}
-
-bool JClkLibCommon::EnableSyscallInterruptSignal()
-{
-	sigset_t unblockSigset;
-	struct sigaction intrSigaction;
-
-	intrSigaction.sa_sigaction = NullSigaction;
-	sigemptyset(&intrSigaction.sa_mask);
-	intrSigaction.sa_flags = SA_SIGINFO;
-	if (sigaction(INTR_SIGNAL, &intrSigaction, NULL) == -1)
-		return false;
-
-	sigemptyset(&unblockSigset);
-	SIGADDSET(&unblockSigset, INTR_SIGNAL, false);
-	if (pthread_sigmask(SIG_UNBLOCK,&unblockSigset,NULL) != 0)
-		return false;
-
-	return true;
-}
-
-bool JClkLibCommon::SendSyscallInterruptSignal(thread &t)
-{
-	int ret;
-
-	if ((ret = pthread_kill(t.native_handle(), INTR_SIGNAL)) != 0) {
-		PrintError("pthread_kill()", ret);
-		return false;
-	}
-
-	return true;
-}
@@ -14,8 +14,6 @@ namespace JClkLibCommon
 {
 	bool BlockStopSignal();
 	bool WaitForStopSignal();
-	bool EnableSyscallInterruptSignal();
-	bool SendSyscallInterruptSignal(std::thread &t);
 }
 #endif/*SIGHANDLER_HPP*/
 
@@ -0,0 +1,146 @@
+/*! \file status_page.cpp
+    \brief Shared memory clock status page implementation.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <common/status_page.hpp>
+#include <common/print.hpp>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace JClkLibCommon;
+using namespace std;
+
+/* Give up if the proxy stays in the middle of a write */
+#define STATUS_PAGE_READ_RETRIES (1000)
+
+string StatusPage::pageName(instanceId_t instance)
+{
+	if (instance == BestInstanceId)
+		return STATUS_PAGE_NAME;
+	return STATUS_PAGE_NAME "." + to_string(instance);
+}
+
+bool StatusPage::create(instanceId_t instance)
+{
+	int fd;
+	void *addr;
+
+	if (page != nullptr)
+		return true;
+	name = pageName(instance);
+	fd = shm_open(name.c_str(), O_RDWR | O_CREAT, STATUS_PAGE_MODE);
+	if (fd == -1) {
+		PrintErrorCode("Failed to open status page");
+		return false;
+	}
+	/* Clients only read, drop the umask bits */
+	if (fchmod(fd, STATUS_PAGE_MODE) == -1 || ftruncate(fd, sizeof(StatusPageLayout)) == -1) {
+		PrintErrorCode("Failed to setup status page");
+		::close(fd);
+		return false;
+	}
+	addr = mmap(NULL, sizeof(StatusPageLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		PrintErrorCode("Failed to map status page");
+		return false;
+	}
+	page = (StatusPageLayout *)addr;
+	writer = true;
+	memset((void *)page, 0, sizeof(StatusPageLayout));
+	page->size = sizeof(StatusPageLayout);
+
+	return true;
+}
+
+bool StatusPage::attach(instanceId_t instance)
+{
+	int fd;
+	void *addr;
+	struct stat st;
+
+	if (page != nullptr)
+		return true;
+	name = pageName(instance);
+	fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd == -1) {
+		PrintErrorCode("Failed to open status page");
+		return false;
+	}
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(StatusPageLayout)) {
+		PrintError("Status page size mismatch");
+		::close(fd);
+		return false;
+	}
+	addr = mmap(NULL, sizeof(StatusPageLayout), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		PrintErrorCode("Failed to map status page");
+		return false;
+	}
+	page = (StatusPageLayout *)addr;
+	writer = false;
+	if (page->size != sizeof(StatusPageLayout)) {
+		PrintError("Status page layout mismatch");
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void StatusPage::close()
+{
+	if (page == nullptr)
+		return;
+	munmap(page, sizeof(StatusPageLayout));
+	page = nullptr;
+	if (writer)
+		shm_unlink(name.c_str());
+	writer = false;
+}
+
+void StatusPage::publish(const jcl_event &event, const jcl_eventcount &count, int64_t gmOffset)
+{
+	uint32_t seq;
+
+	if (!writer)
+		return;
+	seq = page->sequence.load(memory_order_relaxed);
+	page->sequence.store(seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	page->event = event;
+	page->count = count;
+	page->gmOffset = gmOffset;
+	page->sequence.store(seq + 2, memory_order_release);
+}
+
+bool StatusPage::read(jcl_event &event, jcl_eventcount &count, int64_t &gmOffset) const
+{
+	uint32_t begin, end;
+
+	if (page == nullptr)
+		return false;
+	for (int i = 0; i < STATUS_PAGE_READ_RETRIES; ++i) {
+		begin = page->sequence.load(memory_order_acquire);
+		if (begin & 1)
+			continue;
+		event = page->event;
+		count = page->count;
+		gmOffset = page->gmOffset;
+		atomic_thread_fence(memory_order_acquire);
+		end = page->sequence.load(memory_order_relaxed);
+		if (begin == end)
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,59 @@
+/*! \file status_page.hpp
+    \brief Shared memory clock status page. Written by the proxy, read by the clients.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+#ifndef COMMON_STATUS_PAGE_HPP
+#define COMMON_STATUS_PAGE_HPP
+
+#include <common/jclklib_import.hpp>
+#include <common/jcltypes.hpp>
+
+/* The best clock page, each instance page adds the instance number */
+#define STATUS_PAGE_NAME "/jclklib.status"
+#define STATUS_PAGE_MODE (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)
+
+namespace JClkLibCommon
+{
+	/* The page layout, shared between the proxy and the clients.
+	   The sequence is odd while the proxy writes, a reader retries
+	   if it reads an odd sequence or if the sequence changed during the copy. */
+	struct StatusPageLayout
+	{
+		std::atomic<std::uint32_t> sequence;
+		std::uint32_t size; // Layout size, check proxy and client match
+		jcl_event event;
+		jcl_eventcount count;
+		std::int64_t gmOffset;
+	};
+
+	class StatusPage
+	{
+	private:
+		StatusPageLayout *page;
+		bool writer;
+		std::string name;
+	public:
+		StatusPage() : page(nullptr), writer(false) {}
+		~StatusPage() { close(); }
+		static std::string pageName(instanceId_t instance);
+		/* Proxy side, create the page and map it for write */
+		bool create(instanceId_t instance = BestInstanceId);
+		/* Client side, map an existing page read only */
+		bool attach(instanceId_t instance = BestInstanceId);
+		void close();
+		bool isOpen() const { return page != nullptr; }
+
+		void publish(const jcl_event &event, const jcl_eventcount &count, std::int64_t gmOffset);
+		/* Lock free, no system calls */
+		bool read(jcl_event &event, jcl_eventcount &count, std::int64_t &gmOffset) const;
+	};
+}
+
+#endif/*COMMON_STATUS_PAGE_HPP*/
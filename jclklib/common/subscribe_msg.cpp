@@ -6,13 +6,50 @@
 */
 
 #include <common/subscribe_msg.hpp>
+#include <common/serialize.hpp>
+#include <common/print.hpp>
 
 using namespace JClkLibCommon;
 using namespace std;
 
-MAKE_RXBUFFER_TYPE(SubscribeMessage::buildMessage)
+string SubscribeMessage::toString()
 {
-	// Fill in fields
+	string name = ExtractClassName(string(__PRETTY_FUNCTION__),string(__FUNCTION__));
+	name += "\n";
+	name += Message::toString();
+	name += PRIMITIVE_TOSTRING(instance);
+
+	return name;
+}
+
+PARSE_RXBUFFER_TYPE(SubscribeMessage::parseBuffer)
+{
+	if (!Message::parseBuffer(LxContext))
+		return false;
+	if (!PARSE_RX(FIELD,subscription,LxContext))
+		return false;
+	if (!PARSE_RX(FIELD,instance,LxContext))
+		return false;
 
 	return true;
 }
+
+BUILD_TXBUFFER_TYPE(SubscribeMessage::makeBuffer) const
+{
+	if (!Message::makeBuffer(TxContext))
+		return false;
+	if (!WRITE_TX(FIELD,subscription,TxContext))
+		return false;
+	if (!WRITE_TX(FIELD,instance,TxContext))
+		return false;
+
+	return true;
+}
+
+TRANSMIT_MESSAGE_TYPE(SubscribeMessage::transmitMessage)
+{
+	if (!presendMessage(&TxContext))
+		return false;
+
+	return TxContext.sendBuffer();
+}
@@ -13,18 +13,24 @@
 
 namespace JClkLibCommon
 {
-	class SubscribeMessage : public Message
+	class SubscribeMessage : virtual public Message
 	{
+	private:
+		jcl_subscription subscription;
+		instanceId_t instance; // ptp4l instance or the best clock
 	public:
 		static msgId_t getMsgId() { return SUBSCRIBE_MSG; }
-		static MAKE_RXBUFFER_TYPE(buildMessage);
 
-		const jcl_subscription &getSubscription();
+		virtual PARSE_RXBUFFER_TYPE(parseBuffer);
+		virtual TRANSMIT_MESSAGE_TYPE(transmitMessage);
+		virtual BUILD_TXBUFFER_TYPE(makeBuffer) const;
+		virtual std::string toString();
+
+		DECLARE_ACCESSOR(subscription);
+		DECLARE_ACCESSOR(instance);
 	protected:
 #define MESSAGE_SUBSCRIBE() JClkLibCommon::Message(JClkLibCommon::SUBSCRIBE_MSG)
-		SubscribeMessage() : MESSAGE_SUBSCRIBE() {}
-	private:
-		jcl_subscription subscription;
+		SubscribeMessage() : MESSAGE_SUBSCRIBE(), instance(BestInstanceId) {}
 	};
 }
 
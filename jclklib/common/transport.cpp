@@ -9,17 +9,35 @@
 #include <common/message.hpp>
 #include <common/null_tport.hpp>
 #include <common/msgq_tport.hpp>
+#include <common/shm_tport.hpp>
 #include <common/print.hpp>
-#include <common/sighandler.hpp>
 #include <common/util.hpp>
 
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <errno.h>
+
 #define EXIT_TIMEOUT	(200 /*ms*/)
 #define START_TIMEOUT	(20 /*ms*/)
+#define REACTOR_EPOLL_EVENTS (16)
 
 using namespace std;
 
 using namespace JClkLibCommon;
 DECLARE_STATIC(Transport::workerList);
+DECLARE_STATIC(Transport::watchList);
+DECLARE_STATIC(Transport::watchLock);
+DECLARE_STATIC(Transport::epollFd,-1);
+DECLARE_STATIC(Transport::stopFd,-1);
+DECLARE_STATIC(Transport::reactor);
+DECLARE_STATIC(Transport::workerCount,0);
+DECLARE_STATIC(Transport::workerPool);
+DECLARE_STATIC(Transport::readyQueue);
+DECLARE_STATIC(Transport::readyLock);
+DECLARE_STATIC(Transport::readyCond);
+DECLARE_STATIC(Transport::poolExit,false);
 
 
 void Transport::dispatchLoop(promise<FUTURE_TYPEOF(TransportWorkerState::retVal)> promise,
@@ -70,10 +88,101 @@ Transport::TransportWorkDesc Transport::registerWork(TransportWork work)
 	return (workerList.cend()-1)-workerList.cbegin();
 }
 
+Transport::TransportWorkDesc Transport::registerWork(TransportWork work, int fd)
+{
+	lock_guard<mutex> guard(watchLock);
+	struct epoll_event ev;
+
+	watchList.push_back(make_unique<TransportWatch>(fd, move(work)));
+	/* One shot, the context is not processed by two workers at once */
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.ptr = watchList.back().get();
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		PrintErrorCode("Failed to add transport descriptor");
+		watchList.pop_back();
+		return InvalidTransportWorkDesc;
+	}
+
+	return (watchList.cend()-1)-watchList.cbegin();
+}
+
+bool Transport::runWatch(TransportWatch *watch)
+{
+	struct epoll_event ev;
+
+	if (!watch->work.first(watch->work.second.get())) {
+		PrintError("Transport work failed, descriptor " + to_string(watch->fd) + " is dropped");
+		return false;
+	}
+	watch->work.second.get()->_init = false;
+
+	ev.events = EPOLLIN | EPOLLONESHOT;
+	ev.data.ptr = watch;
+	if (epoll_ctl(epollFd, EPOLL_CTL_MOD, watch->fd, &ev) == -1) {
+		PrintErrorCode("Failed to re-arm transport descriptor");
+		return false;
+	}
+
+	return true;
+}
+
+void Transport::reactorLoop()
+{
+	struct epoll_event events[REACTOR_EPOLL_EVENTS];
+	int cnt;
+
+	PrintDebug("Transport reactor started");
+	for (;;) {
+		cnt = epoll_wait(epollFd, events, REACTOR_EPOLL_EVENTS, -1);
+		if (cnt == -1) {
+			if (errno == EINTR)
+				continue;
+			PrintErrorCode("Transport event wait failed");
+			break;
+		}
+		for (int i = 0; i < cnt; ++i) {
+			TransportWatch *watch = (TransportWatch *)events[i].data.ptr;
+
+			/* Stop eventfd */
+			if (watch == NULL)
+				goto done;
+			if (workerCount == 0) {
+				runWatch(watch);
+				continue;
+			}
+			{
+				lock_guard<mutex> guard(readyLock);
+				readyQueue.push_back(watch);
+			}
+			readyCond.notify_one();
+		}
+	}
+ done:
+	PrintDebug("Transport reactor exited");
+}
+
+void Transport::poolLoop()
+{
+	TransportWatch *watch;
+
+	for (;;) {
+		{
+			unique_lock<mutex> guard(readyLock);
+			readyCond.wait(guard, [] { return poolExit || !readyQueue.empty(); });
+			if (poolExit)
+				return;
+			watch = readyQueue.front();
+			readyQueue.pop_front();
+		}
+		runWatch(watch);
+	}
+}
+
 bool Transport::processMessage(TransportListenerContext &context)
 {
 	Message *msg;
-	TransportTransmitterContext *txcontext;
+	TransportTransmitterContext *txcontext = NULL;
+	bool retVal = false;
 
 	context.resetOffset();
 	if (!Message::buildMessage(msg, context))
@@ -81,31 +190,81 @@ bool Transport::processMessage(TransportListenerContext &context)
 	PrintDebug("Received message " + msg->toString());
 
 	if (!context.processMessage(msg, txcontext))
-		return false;
+		goto done;
 
 	/* Echo the message back with ACK disposition */
-	if (msg->get_msgAck() != ACK_NONE)
-		return msg->transmitMessage(*txcontext);
+	if (msg->get_msgAck() != ACK_NONE) {
+		if (txcontext == NULL)
+			goto done;
+		lock_guard<mutex> guard(txcontext->getTransmitLock());
+		retVal = msg->transmitMessage(*txcontext);
+		goto done;
+	}
+	retVal = true;
 
-	return true;
+ done:
+	Message::releaseMessage(msg);
+	return retVal;
 }
 
 
 bool Transport::init()
 {
-	return _initTransport<NullTransport,MessageQueue>();
+	struct epoll_event ev;
+
+	/* Stop and finalize first, the threads of the previous init are running */
+	if (reactor.joinable()) {
+		PrintError("Transport is already initialized");
+		return false;
+	}
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	stopFd = eventfd(0, EFD_CLOEXEC);
+	if (epollFd == -1 || stopFd == -1) {
+		PrintErrorCode("Failed to create transport reactor");
+		goto fail;
+	}
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &ev) == -1) {
+		PrintErrorCode("Failed to add reactor stop descriptor");
+		goto fail;
+	}
+	poolExit = false;
+	reactor = thread(reactorLoop);
+	for (unsigned i = 0; i < workerCount; ++i)
+		workerPool.emplace_back(poolLoop);
+
+	return _initTransport<NullTransport,MessageQueue,SharedMemoryRing>();
+
+ fail:
+	if (epollFd != -1)
+		close(epollFd);
+	if (stopFd != -1)
+		close(stopFd);
+	epollFd = -1;
+	stopFd = -1;
+	return false;
 }
 
 bool Transport::stop()
 {
+	uint64_t one = 1;
+
 	/* Send stop signal to all of the threads */
 	for (decltype(workerList)::iterator it = workerList.begin();
 	     it != workerList.end(); ++it) {
 		it->exitVal->store(true);
 	}
+	if (stopFd != -1 && write(stopFd, &one, sizeof(one)) == -1)
+		PrintErrorCode("Failed to stop transport reactor");
+	{
+		lock_guard<mutex> guard(readyLock);
+		poolExit = true;
+	}
+	readyCond.notify_all();
 
 	/* Do any transport specific stop */
-	if (!_stopTransport<NullTransport,MessageQueue>())
+	if (!_stopTransport<NullTransport,MessageQueue,SharedMemoryRing>())
 		return false;
 
 	return true;
@@ -114,7 +273,21 @@ bool Transport::stop()
 bool Transport::finalize()
 {
 	bool retVal = false;
-	
+
+	if (reactor.joinable())
+		reactor.join();
+	for (auto &worker : workerPool)
+		worker.join();
+	workerPool.clear();
+	readyQueue.clear();
+	watchList.clear();
+	if (epollFd != -1)
+		close(epollFd);
+	if (stopFd != -1)
+		close(stopFd);
+	epollFd = -1;
+	stopFd = -1;
+
 	for (auto it = workerList.begin();
 	     it != workerList.end(); ++it) {
 		if (it->retVal.wait_for(chrono::milliseconds(EXIT_TIMEOUT)) !=
@@ -126,24 +299,12 @@ bool Transport::finalize()
 	     it->thread.get()->join();
 	     retVal &= it->retVal.get();
 	}
+	workerList.clear();
 
-	if (!_finalizeTransport<NullTransport,MessageQueue>())
+	if (!_finalizeTransport<NullTransport,MessageQueue,SharedMemoryRing>())
 		goto done;
 
 	retVal = true;
  done:
 	return retVal;
 }
-
-bool Transport::InterruptWorker(TransportWorkDesc d)
-{
-	if (d == InvalidTransportWorkDesc)
-		return false;
-
-	/* Thread has exited, no need to interrupt */
-	if (isFutureSet<FUTURE_TYPEOF(TransportWorkerState::retVal)>(workerList.back().retVal))
-		return true;
-		
-	PrintDebug("Sending interrupt to MessageQueue worker");
-	return SendSyscallInterruptSignal(*workerList[d].thread.get());
-}
@@ -11,6 +11,9 @@
 #include <memory>
 #include <future>
 #include <thread>
+#include <mutex>
+#include <deque>
+#include <condition_variable>
 
 #ifndef COMMON_TRANSPORT_HPP
 #define COMMON_TRANSPORT_HPP
@@ -41,8 +44,13 @@ namespace JClkLibCommon
 	};
 
 	class TransportTransmitterContext : public TransportContext {
+	private:
+		/* Held while the buffer is built and sent, replies and notifications share the context */
+		std::mutex transmitLock;
 	public:
 		virtual ~TransportTransmitterContext() = default;
+		std::mutex &getTransmitLock() { return transmitLock; }
+		/* On failure errno is EAGAIN if the receiver queue is full */
 #define SEND_BUFFER_TYPE(name)			\
 		bool name()
 		virtual SEND_BUFFER_TYPE(sendBuffer) = 0;
@@ -85,16 +93,42 @@ namespace JClkLibCommon
 					 decltype(TransportWorkerState::exitVal) exitVal,
 					 TransportWork arg
 					 );
+		/* Work on a pollable file descriptor, run when the descriptor is readable */
+		class TransportWatch {
+		public:
+			int fd;
+			TransportWork work;
+			TransportWatch(int fd, TransportWork work) : fd(fd), work(std::move(work)) {}
+		};
+		static std::vector<std::unique_ptr<TransportWatch>> watchList;
+		static std::mutex watchLock;
+		static int epollFd;
+		static int stopFd;
+		static std::thread reactor;
+		static void reactorLoop();
+		static bool runWatch(TransportWatch *watch);
+		/* Optional pool, without workers the reactor runs the work */
+		static unsigned workerCount;
+		static std::vector<std::thread> workerPool;
+		static std::deque<TransportWatch *> readyQueue;
+		static std::mutex readyLock;
+		static std::condition_variable readyCond;
+		static bool poolExit;
+		static void poolLoop();
 	public:
 		static bool processMessage(TransportListenerContext &context);
 		static bool initTransport() { return true; }
 		static bool stopTransport() { return true; }
 		static bool finalizeTransport() { return true; }
+		/* Work blocking on its own, run by a dedicated thread until stop */
 		static TransportWorkDesc registerWork(TransportWork work);
+		/* Work is called by the reactor each time fd is readable, it must not block */
+		static TransportWorkDesc registerWork(TransportWork work, int fd);
+		/* Set before init */
+		static void setWorkerCount(unsigned count) { workerCount = count; }
 		static bool init();
 		static bool stop();
 		static bool finalize();
-		static bool InterruptWorker(TransportWorkDesc d);
 	};
 
 #define PER_TRANSPORT_VARIADIC_TEMPLATE(x)				\
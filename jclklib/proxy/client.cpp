@@ -7,9 +7,12 @@ using namespace std;
 
 DECLARE_STATIC(Client::nextSession,sessionId_t(InvalidSessionId+1));
 DECLARE_STATIC(Client::SessionMap);
+DECLARE_STATIC(Client::SessionLock);
 
 sessionId_t Client::CreateClientSession()
 {
+	lock_guard<mutex> guard(SessionLock);
+
 	for (auto iter = SessionMap.find(nextSession); nextSession != InvalidSessionId && iter != SessionMap.cend();
 	     iter = SessionMap.find(++nextSession));
 	SessionMap.emplace(SessionMapping_t(nextSession,new Client()));
@@ -18,6 +21,7 @@ sessionId_t Client::CreateClientSession()
 
 ClientX Client::GetClientSession(sessionId_t sessionId)
 {
+	lock_guard<mutex> guard(SessionLock);
 	auto iter = SessionMap.find(sessionId);
 	if (iter == SessionMap.cend()) {
 		PrintError("Session ID " + to_string(sessionId) + " not found");
@@ -26,3 +30,17 @@ ClientX Client::GetClientSession(sessionId_t sessionId)
 
 	return iter->second;
 }
+
+void Client::ForEachClientSession(function<void(sessionId_t,ClientX &)> func)
+{
+	vector<SessionMapping_t> sessions;
+
+	{
+		lock_guard<mutex> guard(SessionLock);
+
+		sessions.assign(SessionMap.cbegin(), SessionMap.cend());
+	}
+	/* Without the lock, a slow client must not block new sessions */
+	for (auto &session : sessions)
+		func(session.first, session.second);
+}
@@ -1,9 +1,14 @@
 #include <map>
+#include <vector>
+#include <mutex>
+#include <functional>
 
 #ifndef PROXY_CLIENT
 #define PROXY_CLIENT
 
 #include <client/message.hpp>
+#include <common/jclklib_import.hpp>
+#include <proxy/notify_filter.hpp>
 
 namespace JClkLibProxy {
 	class Client;
@@ -16,15 +21,23 @@ namespace JClkLibProxy {
 	private:
 		static JClkLibCommon::sessionId_t nextSession;
 		static std::map<SessionMapping_t::first_type,SessionMapping_t::second_type> SessionMap;
+		/* Sessions are created by the transport, notified by the ptp4l event loop */
+		static std::mutex SessionLock;
 	public:
 		static JClkLibCommon::sessionId_t CreateClientSession();
 		static ClientX GetClientSession(JClkLibCommon::sessionId_t sessionId);
+		/* Called on a copy of the sessions, without the session lock */
+		static void ForEachClientSession(std::function<void(JClkLibCommon::sessionId_t,ClientX &)> func);
 	private:
 		std::unique_ptr<JClkLibCommon::TransportTransmitterContext> transmitContext;
 	public:
 		void set_transmitContext(decltype(transmitContext)::pointer context)
 		{ this->transmitContext.reset(context); }
 		auto get_transmitContext() { return transmitContext.get(); }
+	private:
+		NotificationFilter filter;
+	public:
+		NotificationFilter &getFilter() { return filter; }
 	};
 }
 
@@ -21,9 +21,22 @@ bool ClockStatus::readConsume()
 	return update;
 }
 
+void ClockStatus::getCommitted(jcl_event &event, int64_t &gmOffset)
+{
+	lock_guard<decltype(update_lock)> update_guard(update_lock);
+	event = status.event;
+	gmOffset = status.gmOffset;
+}
+
 ClockStatus::ClockStatus()
 {
 	// Initialize status
+	update = false;
+	writeUpdate = false;
+	status.event.zero();
+	status.count.zero();
+	status.gmOffset = 0;
+	writeShadow = readShadow = status;
 }
 
 void ClockStatus::speculateWrite()
@@ -48,12 +61,21 @@ void ClockStatus::setCount( const jcl_eventcount &sCount )
 	}
 }
 
+void ClockStatus::setGmOffset( int64_t gmOffset )
+{
+	if (writeShadow.gmOffset != gmOffset) {
+		writeShadow.gmOffset = gmOffset;
+		writeUpdate = true;
+	}
+}
+
 void ClockStatus::commitWrite()
 {
 	lock_guard<decltype(update_lock)> update_guard(update_lock);
 	if (writeUpdate) {
 		status = writeShadow;
 		update = writeUpdate;
+		page.publish(status.event, status.count, status.gmOffset);
 	}
 	writeUpdate = false;
 }
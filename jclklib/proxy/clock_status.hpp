@@ -11,6 +11,7 @@
 #define CLOCK_STATUS_HPP
 
 #include <common/jclklib_import.hpp>
+#include <common/status_page.hpp>
 
 namespace JClkLibProxy
 {
@@ -21,21 +22,31 @@ namespace JClkLibProxy
 		public:
 			JClkLibCommon::jcl_event	event;
 			JClkLibCommon::jcl_eventcount	count;
+			std::int64_t			gmOffset;
 		};
 		bool update, writeUpdate;
 		std::mutex update_lock;
 		Status status;
 		Status writeShadow, readShadow;
+		/* Shared with all the clients, published on each commit */
+		JClkLibCommon::StatusPage page;
 	public:
 		ClockStatus();
 		void speculateWrite();
 		void setEvent( const JClkLibCommon::jcl_event &event );
 		void setCount( const JClkLibCommon::jcl_eventcount &count );
+		void setGmOffset( std::int64_t gmOffset );
 		void commitWrite();
 
 		bool readConsume();
 		const JClkLibCommon::jcl_event &getEvent() { return readShadow.event; }
 		const JClkLibCommon::jcl_eventcount &getCount() { return readShadow.count; }
+		std::int64_t getGmOffset() { return readShadow.gmOffset; }
+		/* Last committed status, safe from any thread */
+		void getCommitted(JClkLibCommon::jcl_event &event, std::int64_t &gmOffset);
+
+		bool initPage(JClkLibCommon::instanceId_t instance) { return page.create(instance); }
+		void finalizePage() { page.close(); }
 	};
 }
 
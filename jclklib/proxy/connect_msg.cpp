@@ -21,7 +21,7 @@ using namespace JClkLibCommon;
  */
 MAKE_RXBUFFER_TYPE(ProxyConnectMessage::buildMessage)
 {
-	msg = new ProxyConnectMessage();
+	msg = MessagePool<ProxyConnectMessage>::get();
 	return true;
 }
 
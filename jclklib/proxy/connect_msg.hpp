@@ -16,6 +16,7 @@ namespace JClkLibProxy
 	class ProxyConnectMessage : virtual public ProxyMessage, virtual public JClkLibCommon::CommonConnectMessage
 	{
 	protected:
+		friend class JClkLibCommon::MessagePool<ProxyConnectMessage>;
 		ProxyConnectMessage() : MESSAGE_CONNECT() {};
 	public:
 		/**
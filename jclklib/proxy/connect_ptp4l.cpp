@@ -0,0 +1,466 @@
+/*! \file connect_ptp4l.cpp
+    \brief Proxy connection to ptp4l implementation.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <proxy/connect_ptp4l.hpp>
+#include <proxy/notification_msg.hpp>
+#include <proxy/client.hpp>
+#include <common/print.hpp>
+#include <common/util.hpp>
+
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+using namespace JClkLibProxy;
+using namespace JClkLibCommon;
+using namespace ptpmgmt;
+using namespace std;
+
+#define PTP4L_BUFFER_LENGTH (2000)
+#define PTP4L_EPOLL_EVENTS (16)
+/* epoll data: instance index and the file type */
+#define EPOLL_STOP_DATA ((uint64_t)-1)
+#define EPOLL_DATA(index,renew) (((uint64_t)(index) << 1) | ((renew) ? 1 : 0))
+
+DECLARE_STATIC(ConnectPtp4l::instances);
+DECLARE_STATIC(ConnectPtp4l::epollFd,-1);
+DECLARE_STATIC(ConnectPtp4l::stopFd,-1);
+DECLARE_STATIC(ConnectPtp4l::eventThread);
+DECLARE_STATIC(ConnectPtp4l::bestStatus);
+DECLARE_STATIC(ConnectPtp4l::bestIndex,0);
+DECLARE_STATIC(ConnectPtp4l::bestEvent);
+DECLARE_STATIC(ConnectPtp4l::bestCount);
+
+Ptp4lInstance::Ptp4lInstance(const string &udsAddress, uint8_t domainNumber)
+	: udsAddress(udsAddress), domainNumber(domainNumber)
+{
+	renewFd = -1;
+	sequence = 0;
+	gmIdentity.clear();
+	synced = false;
+	stateReplies = 0;
+	subscribed = false;
+	event.zero();
+	count.zero();
+	gmOffset = 0;
+}
+
+bool Ptp4lInstance::open(instanceId_t index)
+{
+	MsgParams prms = msg.getParams();
+	struct itimerspec renew = {};
+
+	/* Abstract address, unique per instance and nothing to clean on exit */
+	if (!sock.setSelfAddress("jclklib_proxy." + to_string(getpid()) + "." + to_string(index), true) ||
+	    !sock.init() || !sock.setPeerAddress(udsAddress)) {
+		PrintError("Failed to open ptp4l socket " + udsAddress + ": " + Error::getError());
+		return false;
+	}
+	/* Only the local ptp4l answers */
+	prms.boundaryHops = 0;
+	prms.domainNumber = domainNumber;
+	prms.self_id.portNumber = getpid() & 0xffff;
+	msg.updateParams(prms);
+
+	if (!status.initPage(index))
+		return false;
+
+	renewFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (renewFd == -1) {
+		PrintErrorCode("Failed to create renew timer");
+		return false;
+	}
+	renew.it_value.tv_sec = PTP4L_RENEW_INTERVAL;
+	renew.it_interval.tv_sec = PTP4L_RENEW_INTERVAL;
+	if (timerfd_settime(renewFd, 0, &renew, NULL) == -1) {
+		PrintErrorCode("Failed to set renew timer");
+		return false;
+	}
+
+	return true;
+}
+
+void Ptp4lInstance::close()
+{
+	status.finalizePage();
+	sock.close();
+	if (renewFd != -1)
+		::close(renewFd);
+	renewFd = -1;
+}
+
+bool Ptp4lInstance::sendAction(actionField_e action, mng_vals_e id, const BaseMngTlv *data)
+{
+	uint8_t buf[PTP4L_BUFFER_LENGTH];
+	MNG_PARSE_ERROR_e err;
+	bool ret;
+
+	if (!msg.setAction(action, id, data)) {
+		PrintError(string("Failed to set action ") + ptpmgmt::Message::mng2str_c(id));
+		return false;
+	}
+	err = msg.build(buf, sizeof(buf), sequence++);
+	/* Do not keep a reference to the caller data */
+	msg.clearData();
+	if (err != MNG_PARSE_ERROR_OK) {
+		PrintError(string("Failed to build ") + ptpmgmt::Message::mng2str_c(id) + ": " + ptpmgmt::Message::err2str_c(err));
+		return false;
+	}
+	ret = sock.send(buf, msg.getMsgLen());
+	if (!ret)
+		PrintDebug("Failed to send to " + udsAddress);
+
+	return ret;
+}
+
+bool Ptp4lInstance::subscribe()
+{
+	SUBSCRIBE_EVENTS_NP_t d;
+
+	d.duration = PTP4L_SUBSCRIBE_DURATION;
+	d.setEvent(NOTIFY_PORT_STATE);
+	d.setEvent(NOTIFY_TIME_SYNC);
+	d.setEvent(NOTIFY_PARENT_DATA_SET);
+	/* No answer to the previous subscription, ptp4l may have restarted */
+	if (!subscribed)
+		resetSync();
+	subscribed = false;
+	if (!sendAction(SET, SUBSCRIBE_EVENTS_NP, &d)) {
+		/* ptp4l is down or restarted, query the state again once it answers */
+		resetSync();
+		return false;
+	}
+	if (synced)
+		return true;
+
+	/* Current state, later updates are pushed by ptp4l */
+	return sendAction(GET, PORT_DATA_SET) && sendAction(GET, TIME_STATUS_NP) &&
+		sendAction(GET, PARENT_DATA_SET);
+}
+
+void Ptp4lInstance::resetSync()
+{
+	synced = false;
+	stateReplies = 0;
+}
+
+void Ptp4lInstance::setEvent(eventType e, bool on)
+{
+	if (event.isSet(e) == on)
+		return;
+	event.set(e, on);
+	count.increment(e);
+}
+
+void Ptp4lInstance::handlePortDataSet(const PORT_DATA_SET_t *pd)
+{
+	bool peerPresent = false, locked = false;
+
+	ports[pd->portIdentity] = pd->portState;
+	for (const auto &port : ports) {
+		switch (port.second) {
+		case TIME_RECEIVER:
+			/* ptp4l leaves UNCALIBRATED once the servo locks */
+			locked = true;
+			/* Fall through */
+		case UNCALIBRATED:
+			peerPresent = true;
+			break;
+		default:
+			break;
+		}
+	}
+	setEvent(peerPresentEvent, peerPresent);
+	if (!locked)
+		setEvent(servoLockedEvent, false);
+}
+
+void Ptp4lInstance::handleTimeStatus(const TIME_STATUS_NP_t *ts)
+{
+	gmOffset = ts->master_offset;
+	setEvent(gmPresentEvent, ts->gmPresent != 0);
+	setEvent(servoLockedEvent, ts->servo_state == SERVO_LOCKED || ts->servo_state == SERVO_LOCKED_STABLE);
+}
+
+void Ptp4lInstance::handleParentDataSet(const PARENT_DATA_SET_t *pd)
+{
+	if (pd->grandmasterIdentity == gmIdentity)
+		return;
+	gmIdentity = pd->grandmasterIdentity;
+	/* A new grandmaster is a presence change even if one was present before */
+	if (event.isSet(gmPresentEvent))
+		count.increment(gmPresentEvent);
+}
+
+bool Ptp4lInstance::processReceive()
+{
+	uint8_t buf[PTP4L_BUFFER_LENGTH];
+	ssize_t cnt;
+	MNG_PARSE_ERROR_e err;
+
+	cnt = sock.rcv(buf, sizeof(buf));
+	if (cnt <= 0)
+		return false;
+	err = msg.parse(buf, cnt);
+	if (err == MNG_PARSE_ERROR_MSG && msg.getTlvId() == SUBSCRIBE_EVENTS_NP) {
+		PrintInfo("ptp4l refused the subscription at " + udsAddress);
+		resetSync();
+		return false;
+	}
+	if (err != MNG_PARSE_ERROR_OK) {
+		PrintDebug(string("Ignore ptp4l message: ") + ptpmgmt::Message::err2str_c(err));
+		return false;
+	}
+	switch (msg.getTlvId()) {
+	case SUBSCRIBE_EVENTS_NP:
+		subscribed = true;
+		return false;
+	case PORT_DATA_SET:
+		handlePortDataSet((const PORT_DATA_SET_t *)msg.getData());
+		stateReplies |= PTP4L_STATE_PORT;
+		break;
+	case TIME_STATUS_NP:
+		handleTimeStatus((const TIME_STATUS_NP_t *)msg.getData());
+		stateReplies |= PTP4L_STATE_TIME;
+		break;
+	case PARENT_DATA_SET:
+		handleParentDataSet((const PARENT_DATA_SET_t *)msg.getData());
+		stateReplies |= PTP4L_STATE_PARENT;
+		break;
+	default:
+		return false;
+	}
+	/* Pushed updates count as well, they carry the current state */
+	if (stateReplies == PTP4L_STATE_ALL)
+		synced = true;
+
+	status.speculateWrite();
+	status.setEvent(event);
+	status.setCount(count);
+	status.setGmOffset(gmOffset);
+	status.commitWrite();
+
+	return true;
+}
+
+unsigned Ptp4lInstance::rank() const
+{
+	return (event.isSet(servoLockedEvent) ? 4 : 0) + (event.isSet(gmPresentEvent) ? 2 : 0) +
+		(event.isSet(peerPresentEvent) ? 1 : 0);
+}
+
+bool Ptp4lInstance::processRenew()
+{
+	uint64_t expired;
+
+	if (read(renewFd, &expired, sizeof(expired)) == -1)
+		return errno == EAGAIN;
+	subscribe();
+
+	return true;
+}
+
+bool ConnectPtp4l::add(const string &udsAddress, uint8_t domainNumber)
+{
+	if (epollFd != -1) {
+		PrintError("Can not add ptp4l instance after init");
+		return false;
+	}
+	/* The last instance ID is reserved for the best clock */
+	if (instances.size() >= BestInstanceId) {
+		PrintError("Too many ptp4l instances");
+		return false;
+	}
+	instances.emplace_back(new Ptp4lInstance(udsAddress, domainNumber));
+
+	return true;
+}
+
+bool ConnectPtp4l::init()
+{
+	struct epoll_event ev = {};
+
+	if (instances.empty())
+		add(PTP4L_DEFAULT_UDS);
+	bestEvent.zero();
+	bestCount.zero();
+	if (!bestStatus.initPage(BestInstanceId))
+		return false;
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	stopFd = eventfd(0, EFD_CLOEXEC);
+	if (epollFd == -1 || stopFd == -1) {
+		PrintErrorCode("Failed to create ptp4l event loop");
+		return false;
+	}
+	ev.events = EPOLLIN;
+	ev.data.u64 = EPOLL_STOP_DATA;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &ev) == -1) {
+		PrintErrorCode("Failed to add stop event");
+		return false;
+	}
+	for (size_t i = 0; i < instances.size(); ++i) {
+		Ptp4lInstance &inst = *instances[i];
+
+		if (!inst.open(i))
+			return false;
+		ev.data.u64 = EPOLL_DATA(i,false);
+		if (epoll_ctl(epollFd, EPOLL_CTL_ADD, inst.getSockFd(), &ev) == -1) {
+			PrintErrorCode("Failed to add ptp4l socket");
+			return false;
+		}
+		ev.data.u64 = EPOLL_DATA(i,true);
+		if (epoll_ctl(epollFd, EPOLL_CTL_ADD, inst.getRenewFd(), &ev) == -1) {
+			PrintErrorCode("Failed to add renew timer");
+			return false;
+		}
+		/* ptp4l may start later, the renewal retries */
+		if (!inst.subscribe())
+			PrintInfo("ptp4l is not available at " + inst.getUdsAddress());
+	}
+	eventThread = thread(eventLoop);
+
+	return true;
+}
+
+void ConnectPtp4l::eventLoop()
+{
+	struct epoll_event events[PTP4L_EPOLL_EVENTS];
+	bool pending = false;
+	bool updated;
+	int cnt;
+
+	for (;;) {
+		/* Wake up for the notifications delayed by the rate limit */
+		cnt = epoll_wait(epollFd, events, PTP4L_EPOLL_EVENTS, pending ? NOTIFY_MIN_INTERVAL_MS : -1);
+		if (cnt == -1) {
+			if (errno == EINTR)
+				continue;
+			PrintErrorCode("ptp4l event wait failed");
+			return;
+		}
+		updated = false;
+		for (int i = 0; i < cnt; ++i) {
+			uint64_t data = events[i].data.u64;
+
+			if (data == EPOLL_STOP_DATA)
+				return;
+			Ptp4lInstance &inst = *instances[data >> 1];
+			if (data & 1)
+				inst.processRenew();
+			else if (inst.processReceive()) {
+				updateBest();
+				updated = true;
+			}
+		}
+		if (updated || pending)
+			pending = notifyClients();
+	}
+}
+
+/* Evaluate the subscription of each client against its instance.
+   The sessions lock is not held during the send, the send never blocks. */
+bool ConnectPtp4l::notifyClients()
+{
+	bool pending = false;
+
+	Client::ForEachClientSession([&pending](sessionId_t sessionId, ClientX &client) {
+		ProxyNotificationMessage msg;
+		TransportTransmitterContext *context = client->get_transmitContext();
+		instanceId_t instance = client->getFilter().getInstance();
+		const jcl_event *event = &bestEvent;
+		int64_t gmOffset = instances[bestIndex]->getGmOffset();
+
+		if (context == NULL)
+			return;
+		if (instance != BestInstanceId) {
+			if (instance >= instances.size())
+				return;
+			event = &instances[instance]->getEvent();
+			gmOffset = instances[instance]->getGmOffset();
+		}
+		if (!client->getFilter().evaluate(*event, gmOffset, msg.get_event(), msg.get_eventCount(),
+						  pending))
+			return;
+		msg.set_sessionId(sessionId);
+		msg.set_gmOffset(gmOffset);
+		msg.set_instance(instance);
+
+		lock_guard<mutex> guard(context->getTransmitLock());
+		if (msg.transmitMessage(*context))
+			return;
+		/* The send does not block, a full client queue drops the notification */
+		if (errno != EAGAIN)
+			PrintError("Failed to notify session " + to_string(sessionId));
+		else if (client->getFilter().drop(pending))
+			PrintInfo("Session " + to_string(sessionId) + " queue is full, " +
+				  to_string(client->getFilter().getDropCount()) + " notifications dropped");
+	});
+
+	return pending;
+}
+
+ClockStatus &ConnectPtp4l::getClockStatus(instanceId_t instance)
+{
+	if (instance == BestInstanceId)
+		return bestStatus;
+	return instances[instance]->getStatus();
+}
+
+/* Follow the instance with the best rank, switch only to a better one */
+void ConnectPtp4l::updateBest()
+{
+	size_t best = bestIndex;
+	const jcl_event *event;
+
+	for (size_t i = 0; i < instances.size(); ++i) {
+		if (instances[i]->rank() > instances[best]->rank())
+			best = i;
+	}
+	event = &instances[best]->getEvent();
+	for (int e = 0; e < eventLast; ++e) {
+		eventType type = (eventType)e;
+
+		if (bestEvent.isSet(type) != event->isSet(type)) {
+			bestEvent.set(type, event->isSet(type));
+			bestCount.increment(type);
+		} else if (type == gmPresentEvent && best != bestIndex && event->isSet(type))
+			/* Moved to the grandmaster of another instance */
+			bestCount.increment(type);
+	}
+	bestIndex = best;
+
+	bestStatus.speculateWrite();
+	bestStatus.setEvent(bestEvent);
+	bestStatus.setCount(bestCount);
+	bestStatus.setGmOffset(instances[best]->getGmOffset());
+	bestStatus.commitWrite();
+}
+
+bool ConnectPtp4l::stop()
+{
+	uint64_t one = 1;
+
+	if (stopFd != -1 && write(stopFd, &one, sizeof(one)) == -1) {
+		PrintErrorCode("Failed to stop ptp4l event loop");
+		return false;
+	}
+	if (eventThread.joinable())
+		eventThread.join();
+	for (auto &inst : instances)
+		inst->close();
+	bestStatus.finalizePage();
+	if (epollFd != -1)
+		close(epollFd);
+	if (stopFd != -1)
+		close(stopFd);
+	epollFd = -1;
+	stopFd = -1;
+
+	return true;
+}
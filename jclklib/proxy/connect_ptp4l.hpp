@@ -0,0 +1,108 @@
+/*! \file connect_ptp4l.hpp
+    \brief Proxy connection to ptp4l. Subscribe to ptp4l events and update the clock status.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <memory>
+#include <map>
+
+#ifndef PROXY_CONNECT_PTP4L_HPP
+#define PROXY_CONNECT_PTP4L_HPP
+
+#include <proxy/clock_status.hpp>
+
+#include <pub/sock.h>
+#include <pub/msg.h>
+#include <pub/err.h>
+
+#define PTP4L_DEFAULT_UDS "/var/run/ptp4l"
+/* ptp4l drops the subscription after the duration, renew it on a third of it */
+#define PTP4L_SUBSCRIBE_DURATION (180 /*sec*/)
+#define PTP4L_RENEW_INTERVAL (PTP4L_SUBSCRIBE_DURATION / 3)
+/* Replies of the initial state query */
+#define PTP4L_STATE_PORT (1 << 0)
+#define PTP4L_STATE_TIME (1 << 1)
+#define PTP4L_STATE_PARENT (1 << 2)
+#define PTP4L_STATE_ALL (PTP4L_STATE_PORT | PTP4L_STATE_TIME | PTP4L_STATE_PARENT)
+
+namespace JClkLibProxy
+{
+	class Ptp4lInstance
+	{
+	private:
+		std::string udsAddress;
+		std::uint8_t domainNumber;
+		ptpmgmt::SockUnix sock;
+		ptpmgmt::Message msg;
+		int renewFd;
+		std::uint16_t sequence;
+		bool synced; // Received replies for the initial state
+		unsigned stateReplies; // PTP4L_STATE_xxx received since the last reset
+		bool subscribed; // ptp4l answered the last subscription
+		/* Port states of the clock ports */
+		std::map<ptpmgmt::PortIdentity_t,ptpmgmt::portState_e> ports;
+		ptpmgmt::ClockIdentity_t gmIdentity;
+		ClockStatus status;
+		JClkLibCommon::jcl_event event;
+		JClkLibCommon::jcl_eventcount count;
+		std::int64_t gmOffset;
+
+		bool sendAction(ptpmgmt::actionField_e action, ptpmgmt::mng_vals_e id,
+				const ptpmgmt::BaseMngTlv *data = nullptr);
+		void setEvent(JClkLibCommon::eventType e, bool on);
+		void resetSync();
+		void handlePortDataSet(const ptpmgmt::PORT_DATA_SET_t *pd);
+		void handleTimeStatus(const ptpmgmt::TIME_STATUS_NP_t *ts);
+		void handleParentDataSet(const ptpmgmt::PARENT_DATA_SET_t *pd);
+	public:
+		Ptp4lInstance(const std::string &udsAddress, std::uint8_t domainNumber);
+		~Ptp4lInstance() { close(); }
+		bool open(JClkLibCommon::instanceId_t index);
+		void close();
+		/* Subscribe and query the current state, called again on each renewal */
+		bool subscribe();
+		/* Return true if the status is updated */
+		bool processReceive();
+		bool processRenew();
+		int getSockFd() const { return sock.fileno(); }
+		int getRenewFd() const { return renewFd; }
+		const std::string &getUdsAddress() const { return udsAddress; }
+		ClockStatus &getStatus() { return status; }
+		const JClkLibCommon::jcl_event &getEvent() const { return event; }
+		std::int64_t getGmOffset() const { return gmOffset; }
+		/* Higher is a better clock to follow */
+		unsigned rank() const;
+	};
+
+	class ConnectPtp4l
+	{
+	private:
+		static std::vector<std::unique_ptr<Ptp4lInstance>> instances;
+		static int epollFd;
+		static int stopFd;
+		static std::thread eventThread;
+		/* Merged view of all the instances */
+		static ClockStatus bestStatus;
+		static std::size_t bestIndex;
+		static JClkLibCommon::jcl_event bestEvent;
+		static JClkLibCommon::jcl_eventcount bestCount;
+		static void eventLoop();
+		static void updateBest();
+		/* Return true if a notification is delayed by the rate limit */
+		static bool notifyClients();
+	public:
+		static bool add(const std::string &udsAddress, std::uint8_t domainNumber = 0);
+		static std::size_t getInstanceCount() { return instances.size(); }
+		/* Status of an instance or of the best clock */
+		static ClockStatus &getClockStatus(JClkLibCommon::instanceId_t instance);
+		static bool init();
+		static bool stop();
+	};
+}
+
+#endif/*PROXY_CONNECT_PTP4L_HPP*/
@@ -7,17 +7,47 @@
 
 #include <proxy/transport.hpp>
 #include <proxy/message.hpp>
+#include <proxy/connect_ptp4l.hpp>
 #include <common/sighandler.hpp>
 #include <common/print.hpp>
 
 #include <iostream>
 
+#include <unistd.h>
+
 using namespace JClkLibProxy;
 using namespace JClkLibCommon;
 using namespace std;
 
-int main()
+int main(int argc, char *argv[])
 {
+	int opt;
+	uint8_t domainNumber = 0;
+
+	/* Each -s adds a ptp4l instance, -d sets the domain of the following instances */
+	while ((opt = getopt(argc, argv, "d:l:s:w:")) != -1) {
+		switch (opt) {
+		case 'l':
+			/* 0 errors only, 1 adds info, 2 adds debug and message dumps */
+			setLogLevel(atoi(optarg));
+			break;
+		case 'w':
+			/* Process client messages in a pool, default is the transport reactor thread */
+			Transport::setWorkerCount(atoi(optarg));
+			break;
+		case 'd':
+			domainNumber = atoi(optarg);
+			break;
+		case 's':
+			if (!ConnectPtp4l::add(optarg, domainNumber))
+				return -1;
+			break;
+		default:
+			cout << "Usage: " << argv[0] << " [-l log level] [-w workers] [-d domain] [-s ptp4l UDS address] ..." << endl;
+			return -1;
+		}
+	}
+
 	BlockStopSignal();
 	if(!ProxyTransport::init()) {
 		cout << "Transport init failed" << endl;
@@ -27,8 +57,13 @@ int main()
 		cout << "Message init failed" << endl;
 		return -1;
 	}
+	if(!ConnectPtp4l::init()) {
+		cout << "ptp4l connect failed" << endl;
+		return -1;
+	}
 	WaitForStopSignal();
 	PrintDebug("Got stop signal");
+	ConnectPtp4l::stop();
 	if(!ProxyTransport::stop()) {
 		cout << "stop failed" << endl;
 		return -1;
@@ -7,6 +7,7 @@
 
 #include <proxy/msgq_tport.hpp>
 #include <proxy/message.hpp>
+#include <proxy/shm_tport.hpp>
 
 #include <common/sighandler.hpp>
 #include <common/util.hpp>
@@ -31,25 +32,32 @@ using namespace std;
 
 LISTENER_CONTEXT_PROCESS_MESSAGE_TYPE(ProxyMessageQueueListenerContext::processMessage)
 {
-	ProxyMessage *msg = dynamic_cast<decltype(msg)>(bmsg);
-
 	PrintDebug("Processing received proxy message");
-	if (msg == NULL) {
-		PrintError("Wrong message type");
-		return false;
-	}
 
-	return msg->processMessage(*this,txcontext);
+	/* Only proxy message types are registered, no cast is needed */
+	return bmsg->processMessage(*this,txcontext);
 }
 
 CREATE_TRANSMIT_CONTEXT_TYPE(ProxyMessageQueueListenerContext::CreateTransmitterContext)
 {
-	mqd_t txd = mq_open((char *)clientId.data(), TX_QUEUE_FLAGS);
+	string name((const char *)clientId.data());
+
+	/* Client prefers replies and notifications on its ring */
+	if (SharedMemoryRing::isRingClientId(clientId)) {
+		TransportTransmitterContext *context = ProxyShmRing::CreateTransmitterContext(clientId);
+		if (context != NULL)
+			return context;
+		/* The client queue is named by the process ID as its ring */
+		name = MESSAGE_QUEUE_PREFIX "." + name.substr(sizeof(SHM_RING_PREFIX) - 1);
+		PrintInfo("Client ring is not available, use message queue " + name);
+	}
+
+	mqd_t txd = mq_open(name.c_str(), PROXY_TX_QUEUE_FLAGS);
 	if (txd == -1) {
-		PrintErrorCode("Failed to open message queue " + string((const char*)clientId.data()));
+		PrintErrorCode("Failed to open message queue " + name);
 		return NULL;
 	}
-	PrintDebug("Successfully connected to client " + string((const char*)clientId.data()));
+	PrintDebug("Successfully connected to client " + name);
 	return new ProxyMessageQueueTransmitterContext(txd);
 }
 
@@ -80,8 +88,8 @@ bool ProxyMessageQueue::initTransport()
 
 	if (InvalidTransportWorkDesc ==
 	    (mqListenerDesc =
-	     registerWork(move((TransportWork){MqListenerWork,
-					       TransportWorkArg(new ProxyMessageQueueListenerContext(mqNativeListenerDesc))}))))
+	     registerWork(MqListener(new ProxyMessageQueueListenerContext(mqNativeListenerDesc)),
+			  mqNativeListenerDesc)))
 		return false;
 	    
 	PrintDebug("Proxy Message queue opened");
@@ -93,8 +101,6 @@ bool ProxyMessageQueue::stopTransport()
 {
 	PrintInfo("Stopping Message Queue Proxy Transport");
 	mq_unlink(mqProxyName.c_str());
-	if (mqListenerDesc != InvalidTransportWorkDesc && !InterruptWorker(mqListenerDesc))
-		PrintError("Interrupt worker failed");
 
 	return true;
 }
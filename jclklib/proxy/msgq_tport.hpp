@@ -20,6 +20,8 @@
 #include <common/util.hpp>
 
 #define MAX_CLIENT_COUNT	(8)
+/* A client that does not read its queue must not block the proxy */
+#define PROXY_TX_QUEUE_FLAGS (TX_QUEUE_FLAGS | O_NONBLOCK)
 
 namespace JClkLibProxy
 {
@@ -1,5 +1,5 @@
 /*! \file notification_msg.cpp
-    \brief Proxy connect message implementation. Implements proxy specific connect message function.
+    \brief Proxy notification message implementation. Implements proxy specific notification message function.
 
     (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
     Author: Christopher Hall <christopher.s.hall@intel.com>
@@ -7,20 +7,20 @@
 
 #include <proxy/notification_msg.hpp>
 #include <common/serialize.hpp>
-#include <proxy/clock_config.hpp>
+#include <common/print.hpp>
 
 using namespace JClkLibProxy;
+using namespace JClkLibCommon;
 
-bool ProxyNotificationMessage::processMessage(ClockConfiguration &config)
+PROCESS_MESSAGE_TYPE(ProxyNotificationMessage::processMessage)
 {
-	//config.setWait( waitEnable );
+	PrintError("Unexpected notification message from client");
 
-	return true;
+	return false;
 }
+
 bool ProxyNotificationMessage::generateResponse(uint8_t *msgBuffer, size_t &length,
 					   const ClockStatus &status)
 {
 	return false;
 }
-
-
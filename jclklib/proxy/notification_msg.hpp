@@ -1,5 +1,5 @@
 /*! \file notification_msg.hpp
-    \brief Proxy connect message class. Implements proxy specific connect message function.
+    \brief Proxy notification message class. Implements proxy specific notification message function.
 
     (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
     Author: Christopher Hall <christopher.s.hall@intel.com>
@@ -20,12 +20,11 @@ namespace JClkLibProxy
 					 virtual public JClkLibCommon::NotificationMessage
 	{
 	public:
-		bool processMessage(ClockConfiguration &config);
+		ProxyNotificationMessage() : MESSAGE_NOTIFY() {}
+		/* Proxy only transmits notifications */
+		virtual PROCESS_MESSAGE_TYPE(processMessage);
 		bool generateResponse(std::uint8_t *msgBuffer, std::size_t &length,
 				      const ClockStatus &status);
-
-	protected:
-		ProxyNotificationMessage() : MESSAGE_NOTIFY() {}
 	};
 }
 
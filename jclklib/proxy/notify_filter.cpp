@@ -0,0 +1,141 @@
+/*! \file notify_filter.cpp
+    \brief Proxy notification filter implementation.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <proxy/notify_filter.hpp>
+
+using namespace JClkLibProxy;
+using namespace JClkLibCommon;
+using namespace std;
+
+NotificationFilter::NotificationFilter()
+{
+	subscribed = false;
+	dropped = false;
+	dropCount = 0;
+	instance = BestInstanceId;
+	state.zero();
+	count.zero();
+}
+
+void NotificationFilter::subscribe(const jcl_subscription &subscription, instanceId_t instance,
+				   ClockStatus &status)
+{
+	lock_guard<mutex> guard(lock);
+	jcl_event event;
+	int64_t gmOffset;
+
+	this->subscription = subscription;
+	this->instance = instance;
+	subscribed = true;
+	/* Read under the filter lock, an update committed later is evaluated against it */
+	status.getCommitted(event, gmOffset);
+	/* No hysteresis for the reference */
+	state.zero();
+	state.set(gmOffsetEvent, true);
+	state = filter(event, gmOffset);
+}
+
+instanceId_t NotificationFilter::getInstance()
+{
+	lock_guard<mutex> guard(lock);
+
+	return instance;
+}
+
+/* The window is -lower to upper, a zero limit is not checked.
+   Coming back into the window the limits are narrowed by the hysteresis. */
+bool NotificationFilter::inWindow(const jcl_value &limits, valueType v, int64_t value, bool wasIn)
+{
+	int64_t upper = limits.getUpper(v);
+	int64_t lower = limits.getLower(v);
+
+	if (!wasIn) {
+		upper -= upper * NOTIFY_HYSTERESIS_PERCENT / 100;
+		lower -= lower * NOTIFY_HYSTERESIS_PERCENT / 100;
+	}
+	if (limits.getUpper(v) != 0 && value > upper)
+		return false;
+	if (limits.getLower(v) != 0 && value < -lower)
+		return false;
+
+	return true;
+}
+
+/* Called with the lock held, the window hysteresis depends on the notified state */
+jcl_event NotificationFilter::filter(const jcl_event &status, int64_t gmOffset)
+{
+	jcl_event mask = subscription.getc_event();
+	jcl_value limits = subscription.getc_value();
+	jcl_event next;
+
+	next.zero();
+	for (int e = 0; e < eventLast; ++e) {
+		eventType type = (eventType)e;
+
+		if (!mask.isSet(type))
+			continue;
+		if (type != gmOffsetEvent)
+			next.set(type, status.isSet(type));
+		else if (limits.getUpper(gmOffsetValue) != 0 || limits.getLower(gmOffsetValue) != 0)
+			next.set(type, inWindow(limits, gmOffsetValue, gmOffset, state.isSet(type)));
+	}
+
+	return next;
+}
+
+bool NotificationFilter::evaluate(const jcl_event &status, int64_t gmOffset,
+				  jcl_event &event, jcl_eventcount &count, bool &pending)
+{
+	lock_guard<mutex> guard(lock);
+	jcl_event next;
+	chrono::steady_clock::time_point now;
+
+	if (!subscribed)
+		return false;
+	next = filter(status, gmOffset);
+	/* A dropped notification is sent again with the current state */
+	if (next == state && !dropped)
+		return false;
+	now = chrono::steady_clock::now();
+	if (now - lastNotify < chrono::milliseconds(NOTIFY_MIN_INTERVAL_MS)) {
+		pending = true;
+		return false;
+	}
+	for (int e = 0; e < eventLast; ++e) {
+		eventType type = (eventType)e;
+
+		if (next.isSet(type) != state.isSet(type))
+			this->count.increment(type);
+	}
+	state = next;
+	lastNotify = now;
+	dropped = false;
+	event = state;
+	count = this->count;
+
+	return true;
+}
+
+bool NotificationFilter::drop(bool &pending)
+{
+	lock_guard<mutex> guard(lock);
+	bool first = !dropped;
+
+	dropped = true;
+	++dropCount;
+	/* Retry after the rate limit interval */
+	pending = true;
+
+	return first;
+}
+
+uint64_t NotificationFilter::getDropCount()
+{
+	lock_guard<mutex> guard(lock);
+
+	return dropCount;
+}
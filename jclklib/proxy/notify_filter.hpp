@@ -0,0 +1,62 @@
+/*! \file notify_filter.hpp
+    \brief Proxy notification filter. One filter per client session.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <cstdint>
+#include <mutex>
+#include <chrono>
+
+#ifndef PROXY_NOTIFY_FILTER_HPP
+#define PROXY_NOTIFY_FILTER_HPP
+
+#include <common/jclklib_import.hpp>
+#include <common/jcltypes.hpp>
+#include <proxy/clock_status.hpp>
+
+/* Re-entering a value window needs a margin of the limit */
+#define NOTIFY_HYSTERESIS_PERCENT (10)
+/* At most one notification per interval per client, later changes are coalesced */
+#define NOTIFY_MIN_INTERVAL_MS (100)
+
+namespace JClkLibProxy
+{
+	class NotificationFilter
+	{
+	private:
+		std::mutex lock;
+		bool subscribed;
+		JClkLibCommon::jcl_subscription subscription;
+		JClkLibCommon::instanceId_t instance;
+		/* Subscribed events, as last notified */
+		JClkLibCommon::jcl_event state;
+		JClkLibCommon::jcl_eventcount count;
+		std::chrono::steady_clock::time_point lastNotify;
+		/* Last notification was dropped, the client queue was full */
+		bool dropped;
+		std::uint64_t dropCount;
+		static bool inWindow(const JClkLibCommon::jcl_value &limits, JClkLibCommon::valueType v,
+				     std::int64_t value, bool wasIn);
+		/* Subscribed events of a status */
+		JClkLibCommon::jcl_event filter(const JClkLibCommon::jcl_event &status, std::int64_t gmOffset);
+	public:
+		NotificationFilter();
+		/* The current status of the instance is the reference for the first notification */
+		void subscribe(const JClkLibCommon::jcl_subscription &subscription,
+			       JClkLibCommon::instanceId_t instance, ClockStatus &status);
+		JClkLibCommon::instanceId_t getInstance();
+		/* Return true if the client is notified, event and count are the notified state.
+		   pending is set if the rate limit delays a notification. */
+		bool evaluate(const JClkLibCommon::jcl_event &status, std::int64_t gmOffset,
+			      JClkLibCommon::jcl_event &event, JClkLibCommon::jcl_eventcount &count,
+			      bool &pending);
+		/* The notification was not sent, the next evaluate sends the current state.
+		   Return true on the first drop since the last sent notification. */
+		bool drop(bool &pending);
+		std::uint64_t getDropCount();
+	};
+}
+
+#endif/*PROXY_NOTIFY_FILTER_HPP*/
@@ -0,0 +1,27 @@
+/*! \file shm_tport.cpp
+    \brief Proxy shared memory ring transport implementation.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <proxy/shm_tport.hpp>
+
+#include <common/print.hpp>
+
+using namespace JClkLibProxy;
+using namespace JClkLibCommon;
+using namespace std;
+
+CREATE_TRANSMIT_CONTEXT_TYPE(ProxyShmRing::CreateTransmitterContext)
+{
+	ProxyShmRingTransmitterContext *context = new ProxyShmRingTransmitterContext();
+
+	if (!context->openRing((const char *)clientId.data())) {
+		delete context;
+		return NULL;
+	}
+	PrintDebug("Successfully connected to client ring " + string((const char*)clientId.data()));
+
+	return context;
+}
@@ -0,0 +1,39 @@
+/*! \file shm_tport.hpp
+    \brief Proxy shared memory ring transport class.
+
+    (C) Copyright Intel Corporation 2023. All rights reserved. Intel Confidential.
+    Author: Christopher Hall <christopher.s.hall@intel.com>
+*/
+
+#include <cstdint>
+#include <string>
+
+#ifndef PROXY_SHM_TPORT_HPP
+#define PROXY_SHM_TPORT_HPP
+
+#include <proxy/transport.hpp>
+#include <common/shm_tport.hpp>
+#include <common/util.hpp>
+
+namespace JClkLibProxy
+{
+	class ProxyShmRingTransmitterContext : virtual public JClkLibCommon::ShmRingTransmitterContext,
+					       virtual public ProxyTransportTransmitterContext
+	{
+		friend class ProxyShmRing;
+	protected:
+		ProxyShmRingTransmitterContext() {}
+	public:
+		virtual ~ProxyShmRingTransmitterContext() = default;
+	};
+
+	/* Proxy only transmits on rings, the client creates its ring and
+	   sends the name as its client ID on the message queue */
+	class ProxyShmRing : public JClkLibCommon::SharedMemoryRing, public ProxyTransport
+	{
+	public:
+		static CREATE_TRANSMIT_CONTEXT_TYPE(CreateTransmitterContext);
+	};
+}
+
+#endif/*PROXY_SHM_TPORT_HPP*/
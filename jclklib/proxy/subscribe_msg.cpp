@@ -6,21 +6,55 @@
 */
 
 #include <proxy/subscribe_msg.hpp>
-#include <proxy/clock_config.hpp>
+#include <proxy/connect_ptp4l.hpp>
+#include <proxy/client.hpp>
+#include <common/print.hpp>
 
+using namespace std;
 using namespace JClkLibProxy;
+using namespace JClkLibCommon;
 
-bool ProxySubscribeMessage::processMessage(ClockConfiguration &config)
+MAKE_RXBUFFER_TYPE(ProxySubscribeMessage::buildMessage)
 {
-	//config.setEvent(subscription.getEvent());
-	//config.setValue(subscription.getValue());
-
+	msg = MessagePool<ProxySubscribeMessage>::get();
 	return true;
 }
-bool ProxySubscribeMessage::generateResponse(uint8_t *msgBuffer, size_t &length,
-					const ClockStatus &status)
+
+bool ProxySubscribeMessage::initMessage()
 {
-	return false;
+	addMessageType(parseMsgMapElement_t(SUBSCRIBE_MSG, buildMessage));
+	return true;
 }
 
+/** @brief process the subscribe msg from client-runtime
+ *
+ * Store the subscription and the ptp4l instance in the client session
+ * notification filter.
+ * The reply is sent using the session transmitter context.
+ * A client can subscribe to a single instance or to the best clock
+ * of all the instances.
+ *
+ * @param LxContext proxy transport listener context
+ * @param TxContext proxy transport transmitter context
+ * @return true
+ */
+PROCESS_MESSAGE_TYPE(ProxySubscribeMessage::processMessage)
+{
+	ClientX client = Client::GetClientSession(getc_sessionId());
+
+	PrintDebug("Processing proxy subscribe message");
+
+	if (!client)
+		return false;
+	TxContext = client->get_transmitContext();
+	if (get_instance() != BestInstanceId && get_instance() >= ConnectPtp4l::getInstanceCount()) {
+		PrintError("Unknown ptp4l instance " + to_string(get_instance()));
+		set_msgAck(ACK_FAIL);
+		return true;
+	}
+	client->getFilter().subscribe(getc_subscription(), get_instance(),
+				       ConnectPtp4l::getClockStatus(get_instance()));
+	set_msgAck(ACK_SUCCESS);
 
+	return true;
+}
@@ -16,11 +16,32 @@ namespace JClkLibProxy
 	class ProxySubscribeMessage : virtual public ProxyMessage, virtual public JClkLibCommon::SubscribeMessage
 	{
 	public:
-		bool processMessage(ClockConfiguration &config);
+		/**
+		 * @brief process the subscribe msg from client-runtime
+		 * @param LxContext proxy transport listener context
+		 * @param TxContext proxy transport transmitter context
+		 * @return true
+		 */
+		virtual PROCESS_MESSAGE_TYPE(processMessage);
 		bool generateResponse(uint8_t *msgBuffer, std::size_t &length,
-				      const ClockStatus &status);
+				      const ClockStatus &status)
+		{ return false; }
+
+		/**
+		 * @brief Create the ProxySubscribeMessage object
+		 * @param msg msg structure to be fill up
+		 * @param LxContext proxy transport listener context
+		 * @return true
+		 */
+		static MAKE_RXBUFFER_TYPE(buildMessage);
+
+		/** @brief Add proxy's SUBSCRIBE_MSG type and its builder to transport layer.
+		 * @return true
+		 */
+		static bool initMessage();
 
 	protected:
+		friend class JClkLibCommon::MessagePool<ProxySubscribeMessage>;
 		ProxySubscribeMessage() : MESSAGE_SUBSCRIBE() {};
 	};
 }
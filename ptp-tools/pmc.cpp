@@ -11,6 +11,7 @@
  */
 
 #include "pmc.h"
+#include "json.h"
 
 #ifndef INFTIM
 #define INFTIM -1
@@ -26,6 +27,90 @@ static Message &msg = obj.msg();
 static SockBase *sk;
 static bool use_uds;
 static uint64_t timeout;
+static uint16_t seq = 0;
+// Batch mode, replies of each command sent
+struct BatchSend {
+    std::string cmd;
+    std::vector<Binary> replies;
+};
+static std::vector<BatchSend> batchSent;
+bool show_sending = true;
+// Fleet mode, send the commands to many ptp4l
+struct FleetSock {
+    std::unique_ptr<SockBase> sk;
+    MsgParams prms; // Self port identity of the socket
+};
+struct FleetTarget {
+    std::string name; // Target as given in the targets file
+    size_t sock;
+    MsgParams prms; // Socket parameters with the target port identity
+};
+struct FleetSend {
+    size_t target;
+    std::string cmd;
+    bool done;
+};
+static bool fleet = false;
+static std::vector<FleetSock> fleetSocks;
+static std::map<std::string, size_t> fleetSockIndex; // transport and address
+static std::vector<FleetTarget> fleetTargets;
+static std::vector<FleetSend> fleetSent; // index is sequence from fleetFirst
+static uint16_t fleetFirst;
+static const Pmc_option fleetOption = {
+    'F', "", true, false, "send the commands to the targets in 'file'", "file"
+};
+static const Pmc_option jsonOption = {
+    'j', "", false, false, "print the replies as JSON, one object per line"
+};
+// JSON lines output, written with writev when the buffer is full or idle
+static const size_t jsonFlushSize = 64 * 1024;
+static const size_t jsonMaxLines = 256; // two vectors per line
+static bool use_json = false;
+static std::vector<std::string> jsonLines;
+static std::vector<iovec> jsonIov;
+static size_t jsonSize = 0;
+// Set by the signal handler, the main loop flushes and exits
+static volatile sig_atomic_t stopSig = 0;
+
+static void json_flush()
+{
+    static const char nl = '\n';
+    if(jsonLines.empty())
+        return;
+    jsonIov.clear();
+    for(auto &line : jsonLines) {
+        jsonIov.push_back({(void *)line.data(), line.size()});
+        jsonIov.push_back({(void *)&nl, 1});
+    }
+    iovec *iov = jsonIov.data();
+    int cnt = jsonIov.size();
+    while(cnt > 0) {
+        ssize_t ret = writev(STDOUT_FILENO, iov, cnt);
+        if(ret < 0) {
+            if(errno == EINTR)
+                continue;
+            fprintf(stderr, "JSON output fails %m\n");
+            break;
+        }
+        // Skip the written vectors and continue a partial one
+        for(; cnt > 0 && (size_t)ret >= iov->iov_len; iov++, cnt--)
+            ret -= iov->iov_len;
+        if(cnt > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + ret;
+            iov->iov_len -= ret;
+        }
+    }
+    // Keep the vectors capacity for the next lines
+    jsonLines.clear();
+    jsonSize = 0;
+}
+static void json_line(std::string &&line)
+{
+    jsonSize += line.size() + 1;
+    jsonLines.push_back(std::move(line));
+    if(jsonSize >= jsonFlushSize || jsonLines.size() >= jsonMaxLines)
+        json_flush();
+}
 
 static inline void dump_head(actionField_e action)
 {
@@ -72,12 +157,15 @@ static inline bool updatePortIdentity(MsgParams &prms, char *str)
     nc.copy(prms.target.clockIdentity.v);
     return true;
 }
+static bool fleet_send();
 bool sendAction()
 {
-    static int seq = 0;
+    if(fleet)
+        return fleet_send();
     MNG_PARSE_ERROR_e err = msg.build(buf, bufSize, seq);
     if(err != MNG_PARSE_ERROR_OK) {
-        DUMPS("build error %s\n", msg.err2str_c(err));
+        fprintf(use_json ? stderr : stdout, "build error %s\n",
+            msg.err2str_c(err));
         return false;
     }
     if(!sk->send(buf, msg.getMsgLen())) {
@@ -87,6 +175,31 @@ bool sendAction()
     seq++;
     return true;
 }
+// Dump a parsed message
+static inline void dump_msg(MNG_PARSE_ERROR_e err)
+{
+    if(use_json) {
+        json_line(msg2json(msg, -1));
+        return;
+    }
+    switch(err) {
+        case MNG_PARSE_ERROR_MSG:
+            dump_err();
+            break;
+        case MNG_PARSE_ERROR_SIG:
+            dump_sig();
+            msg.traversSigTlvs(call_dumpSig);
+            break;
+        default:
+            dump_head(msg.getReplyAction());
+            call_dump(msg);
+            break;
+    }
+}
+static inline void dump_parse_err(MNG_PARSE_ERROR_e err)
+{
+    fprintf(use_json ? stderr : stdout, "Parse error %s\n", msg.err2str_c(err));
+}
 static inline int rcv()
 {
     const ssize_t cnt = sk->rcv(buf, bufSize);
@@ -97,15 +210,13 @@ static inline int rcv()
     MNG_PARSE_ERROR_e err = msg.parse(buf, cnt);
     switch(err) {
         case MNG_PARSE_ERROR_MSG:
-            dump_err();
+            dump_msg(err);
             break;
         case MNG_PARSE_ERROR_OK:
-            dump_head(msg.getReplyAction());
-            call_dump(msg);
+            dump_msg(err);
             return 0;
         case MNG_PARSE_ERROR_SIG:
-            dump_sig();
-            msg.traversSigTlvs(call_dumpSig);
+            dump_msg(err);
             return 1; // Do not count signaling messages
         case MNG_PARSE_ERROR_ACTION: // Not management, or another clock id
         case MNG_PARSE_ERROR_HEADER: // Not reply
@@ -113,7 +224,7 @@ static inline int rcv()
                 // We got the wrong message, wait for the next one
                 return 1;
         default:
-            DUMPS("Parse error %s\n", msg.err2str_c(err));
+            dump_parse_err(err);
             break;
     }
     return -1;
@@ -123,11 +234,314 @@ static inline void rcv_timeout()
     timeout = wait;
     do {
         if(!sk->tpoll(timeout)) {
-            PMCLERR;
+            if(!stopSig)
+                PMCLERR;
             break;
         }
     }while(rcv() == 1 && timeout > 0);
 }
+static std::string json_str(const std::string &str)
+{
+    std::string ret = "\"";
+    for(char c : str) {
+        if(c == '"' || c == '\\') {
+            ret += '\\';
+            ret += c;
+        } else if((unsigned char)c < 0x20) {
+            char e[7];
+            snprintf(e, sizeof e, "\\u%04x", c);
+            ret += e;
+        } else
+            ret += c;
+    }
+    return ret + '"';
+}
+// The action and management ID of the command built
+static std::string sent_cmd()
+{
+    std::string cmd = msg.act2str_c(msg.getSendAction());
+    cmd += ' ';
+    cmd += msg.mng2str_c(msg.getBuildTlvId());
+    return cmd;
+}
+// Store a batch reply by its sequence, return 0 on first reply of a command
+static inline int rcv_batch(uint16_t first)
+{
+    const ssize_t cnt = sk->rcv(buf, bufSize);
+    if(cnt < 0) {
+        PMCLERR;
+        return -1;
+    }
+    MNG_PARSE_ERROR_e err = msg.parse(buf, cnt);
+    switch(err) {
+        case MNG_PARSE_ERROR_MSG:
+        case MNG_PARSE_ERROR_OK:
+            break;
+        case MNG_PARSE_ERROR_SIG:
+        case MNG_PARSE_ERROR_ACTION: // Not management, or another clock id
+        case MNG_PARSE_ERROR_HEADER: // Not reply
+            return 1;
+        default:
+            dump_parse_err(err);
+            return -1;
+    }
+    uint16_t index = msg.getSequence() - first;
+    if(index >= batchSent.size())
+        return 1; // Not our command
+    std::vector<Binary> &rep = batchSent[index].replies;
+    rep.push_back(Binary(buf, cnt));
+    return rep.size() == 1 ? 0 : 1;
+}
+// Wait for all replies, the timeout restarts on each command reply
+static inline void rcv_batch_all(uint16_t first)
+{
+    size_t pending = batchSent.size();
+    timeout = wait;
+    // Unmatched replies use the timeout, poll with zero timeout blocks
+    while(pending > 0 && timeout > 0) {
+        if(!sk->tpoll(timeout)) {
+            if(!stopSig)
+                PMCLERR;
+            break;
+        }
+        if(rcv_batch(first) == 0) {
+            pending--;
+            timeout = wait;
+        }
+    }
+    // Dump in command order, a command without a reply is dumped too
+    const char *noReply = stopSig ? "interrupted" : "timeout";
+    for(const auto &send : batchSent) {
+        for(const auto &b : send.replies)
+            dump_msg(msg.parse(b.get(), b.size()));
+        if(!send.replies.empty())
+            continue;
+        if(use_json)
+            json_line("{\"command\":" + json_str(send.cmd) +
+                ",\"error\":" + json_str(noReply) + '}');
+        else
+            DUMPS("%s: no reply, %s\n", send.cmd.c_str(), noReply);
+    }
+}
+// One JSON line per reply or error
+static void fleet_dump(const FleetTarget &t, const std::string &cmd,
+    const char *key, const std::string &value)
+{
+    std::string line = "{\"target\":" + json_str(t.name);
+    if(!cmd.empty())
+        line += ",\"command\":" + json_str(cmd);
+    line += ",\"";
+    line += key;
+    line += "\":";
+    line += value;
+    line += '}';
+    json_line(std::move(line));
+}
+static bool fleet_send()
+{
+    bool ret = false;
+    std::string cmd = sent_cmd();
+    for(size_t i = 0; i < fleetTargets.size(); i++) {
+        const FleetTarget &t = fleetTargets[i];
+        // The reply is found by its sequence
+        if(fleetSent.size() > UINT16_MAX) {
+            PMCERR("Too many commands and targets");
+            break;
+        }
+        msg.updateParams(t.prms);
+        MNG_PARSE_ERROR_e err = msg.build(buf, bufSize, seq);
+        if(err != MNG_PARSE_ERROR_OK) {
+            fprintf(stderr, "build error %s\n", msg.err2str_c(err));
+            break;
+        }
+        if(!fleetSocks[t.sock].sk->send(buf, msg.getMsgLen())) {
+            fleet_dump(t, cmd, "error", json_str(Error::getError()));
+            continue;
+        }
+        fleetSent.push_back({i, cmd, false});
+        seq++;
+        ret = true;
+    }
+    return ret;
+}
+static SockBase *fleet_sock(const Options &opt, const ConfigFile &cfg,
+    const std::string &transport, const std::string &address, MsgParams &prms)
+{
+    std::string interface;
+    if(transport != "uds")
+        interface = address;
+    prms.boundaryHops = opt.have('b') ? opt.val_i('b') : 1;
+    prms.domainNumber = opt.have('d') ? opt.val_i('d') :
+        cfg.domainNumber(interface);
+    prms.transportSpecific = opt.have('t') ?
+        strtol(opt.val_c('t'), nullptr, 16) : cfg.transportSpecific(interface);
+    prms.useZeroGet = opt.val('z') == "1";
+    if(transport == "uds") {
+        std::unique_ptr<SockUnix> sku(new SockUnix);
+        pid_t pid = getpid();
+        // Abstract address, unique per socket and nothing to clean on exit
+        std::string self = "pmc." + std::to_string(pid) + "." +
+            std::to_string(fleetSocks.size());
+        if(!sku->setSelfAddress(self, true) || !sku->init() ||
+            !sku->setPeerAddress(address))
+            return nullptr;
+        prms.self_id.clockIdentity.v[6] = (pid >> 24) & 0xff;
+        prms.self_id.clockIdentity.v[7] = (pid >> 16) & 0xff;
+        prms.self_id.portNumber = pid & 0xffff;
+        return sku.release();
+    }
+    IfInfo ifObj;
+    if(!ifObj.initUsingName(interface))
+        return nullptr;
+    Binary clockIdentity(ifObj.mac());
+    clockIdentity.eui48ToEui64();
+    clockIdentity.copy(prms.self_id.clockIdentity.v);
+    prms.self_id.portNumber = 1;
+    if(transport == "udp4") {
+        std::unique_ptr<SockIp4> sk4(new SockIp4);
+        if(!sk4->setAll(ifObj, cfg, interface) ||
+            (opt.have('T') && !sk4->setUdpTtl(opt.val_i('T'))) || !sk4->init())
+            return nullptr;
+        return sk4.release();
+    } else if(transport == "udp6") {
+        std::unique_ptr<SockIp6> sk6(new SockIp6);
+        if(!sk6->setAll(ifObj, cfg, interface) ||
+            (opt.have('T') && !sk6->setUdpTtl(opt.val_i('T'))) ||
+            (opt.have('S') && !sk6->setScope(opt.val_i('S'))) || !sk6->init())
+            return nullptr;
+        return sk6.release();
+    }
+    std::unique_ptr<SockRaw> skr(new SockRaw);
+    if(!skr->setAll(ifObj, cfg, interface) ||
+        (opt.have('P') && !skr->setSocketPriority(opt.val_i('P'))) ||
+        !skr->init())
+        return nullptr;
+    return skr.release();
+}
+/*
+ * Each line of the targets file is
+ *  <uds|udp4|udp6|l2> <UDS path|interface> [clock ID-port|*]
+ * Targets using the same transport and address share the socket.
+ */
+static bool fleet_open(const Options &opt, const std::string &file)
+{
+    ConfigFile cfg;
+    if(opt.have('f') && !cfg.read_cfg(opt.val('f')))
+        return false;
+    FILE *f = file == "-" ? stdin : fopen(file.c_str(), "r");
+    if(f == nullptr) {
+        fprintf(stderr, "Fail to open targets file %s: %m\n", file.c_str());
+        return false;
+    }
+    char lineBuf[bufSize];
+    while(fgets(lineBuf, bufSize, f) != nullptr) {
+        char *save;
+        char *transport = strtok_r(lineBuf, toksep, &save);
+        if(transport == nullptr || *transport == '#')
+            continue;
+        char *address = strtok_r(nullptr, toksep, &save);
+        if(address == nullptr) {
+            fprintf(stderr, "Target %s without address\n", transport);
+            continue;
+        }
+        char *port = strtok_r(nullptr, toksep, &save);
+        FleetTarget t;
+        t.name = std::string(transport) + " " + address;
+        std::string key = t.name;
+        if(port != nullptr)
+            t.name += std::string(" ") + port;
+        if(strcmp(transport, "uds") != 0 && strcmp(transport, "udp4") != 0 &&
+            strcmp(transport, "udp6") != 0 && strcmp(transport, "l2") != 0) {
+            fleet_dump(t, "", "error", json_str("Unknown transport"));
+            continue;
+        }
+        auto it = fleetSockIndex.find(key);
+        if(it == fleetSockIndex.end()) {
+            FleetSock fs;
+            fs.prms = msg.getParams();
+            fs.sk.reset(fleet_sock(opt, cfg, transport, address, fs.prms));
+            if(!fs.sk) {
+                fleet_dump(t, "", "error", json_str(Error::getError()));
+                continue;
+            }
+            it = fleetSockIndex.emplace(key, fleetSocks.size()).first;
+            fleetSocks.push_back(std::move(fs));
+        }
+        t.sock = it->second;
+        t.prms = fleetSocks[t.sock].prms;
+        if(port != nullptr && strcmp(port, "*") != 0 &&
+            !updatePortIdentity(t.prms, port)) {
+            fleet_dump(t, "", "error", json_str("Wrong clock ID"));
+            continue;
+        }
+        fleetTargets.push_back(std::move(t));
+    }
+    if(f != stdin)
+        fclose(f);
+    return true;
+}
+// Return 1 on the first reply of a command
+static inline int fleet_rcv(size_t sock)
+{
+    const FleetSock &fs = fleetSocks[sock];
+    const ssize_t cnt = fs.sk->rcv(buf, bufSize);
+    if(cnt < 0) {
+        PMCLERR;
+        return 0;
+    }
+    msg.updateParams(fs.prms);
+    MNG_PARSE_ERROR_e err = msg.parse(buf, cnt);
+    if(err != MNG_PARSE_ERROR_OK && err != MNG_PARSE_ERROR_MSG)
+        return 0;
+    uint16_t index = msg.getSequence() - fleetFirst;
+    if(index >= fleetSent.size())
+        return 0;
+    FleetSend &send = fleetSent[index];
+    const FleetTarget &t = fleetTargets[send.target];
+    if(t.sock != sock)
+        return 0;
+    // Replies of all clocks are dumped
+    fleet_dump(t, send.cmd, "reply", msg2json(msg, -1));
+    if(send.done)
+        return 0;
+    send.done = true;
+    return 1;
+}
+static inline int64_t mono_ms()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+// Wait for all replies, the timeout restarts on each command reply
+static inline void fleet_rcv_all()
+{
+    std::vector<pollfd> fds(fleetSocks.size());
+    for(size_t i = 0; i < fds.size(); i++) {
+        fds[i].fd = fleetSocks[i].sk->fileno();
+        fds[i].events = POLLIN;
+    }
+    size_t pending = fleetSent.size();
+    int64_t end = mono_ms() + wait;
+    // A signal interrupts the poll, the pending commands are dumped
+    while(pending > 0 && !stopSig) {
+        int left = end - mono_ms();
+        if(left <= 0 || poll(fds.data(), fds.size(), left) <= 0)
+            break;
+        for(size_t i = 0; i < fds.size(); i++) {
+            if(fds[i].revents & POLLIN && fleet_rcv(i) > 0) {
+                pending--;
+                end = mono_ms() + wait;
+            }
+        }
+    }
+    for(const auto &send : fleetSent) {
+        if(!send.done)
+            fleet_dump(fleetTargets[send.target], send.cmd, "error",
+                json_str(stopSig ? "interrupted" : "timeout"));
+    }
+    json_flush();
+}
 static bool run_line(char *line)
 {
     char *save;
@@ -165,25 +579,49 @@ static bool run_line(char *line)
         return false;
     return call_data(msg, action, id, save);
 }
+static int fleet_run(const Options &opt, int argc, char *const argv[])
+{
+    if(!opt.have_more()) {
+        PMCERR("Fleet mode sends the commands of the command line");
+        return -1;
+    }
+    if(!fleet_open(opt, opt.val('F'))) {
+        PMCLERR;
+        json_flush();
+        return -1;
+    }
+    fleet = true;
+    show_sending = false;
+    fleetFirst = seq;
+    for(int index = opt.procces_next(); index < argc && !stopSig; index++)
+        run_line(argv[index]);
+    fleet_rcv_all();
+    fleetSocks.clear();
+    return 0;
+}
 void help(const std::string &app, const char *hmsg)
 {
     fprintf(stderr, "\nusage: %s [options] [commands]\n\n%s\n",
         app.c_str(), hmsg);
 }
-[[noreturn]] static void handle_sig(int)
+// Only async-signal-safe, the receive and read calls return with EINTR
+static void handle_sig(int sig)
 {
-    obj.close();
-    exit(0);
+    stopSig = sig;
 }
-[[noreturn]] static void handle_sig_ctrl(int)
+static bool set_sig(int sig)
 {
-    obj.close();
-    DUMPNL;
-    exit(0);
+    struct sigaction act = {};
+    act.sa_handler = handle_sig;
+    sigemptyset(&act.sa_mask);
+    // No SA_RESTART, a blocking read of the standard input returns
+    return sigaction(sig, &act, nullptr) == 0;
 }
 int main(int argc, char *const argv[])
 {
     Options opt;
+    opt.insert(fleetOption);
+    opt.insert(jsonOption);
     std::string app = basename(argv[0]);
     switch(opt.parse_options(argc, argv)) {
         case Options::OPT_ERR:
@@ -199,6 +637,23 @@ int main(int argc, char *const argv[])
         case Options::OPT_DONE:
             break;
     }
+    use_json = opt.have('j');
+    if(use_json)
+        show_sending = false;
+    // Normal Termination (by kill)
+    if(!set_sig(SIGTERM))
+        PMCERR("sig term fails %m");
+    // Control C, interrupt from keyboard
+    if(!set_sig(SIGINT))
+        PMCERR("sig init fails %m");
+    // quit from keyboard
+    if(!set_sig(SIGQUIT))
+        PMCERR("sig quit fails %m");
+    // Hangup detected
+    if(!set_sig(SIGHUP))
+        PMCERR("sig hup fails %m");
+    if(opt.have('F'))
+        return fleet_run(opt, argc, argv);
     int ret = obj.proccess(opt);
     if(ret) {
         PMCLERR;
@@ -215,35 +670,28 @@ int main(int argc, char *const argv[])
     if(!batch && !use_uds)
         prms.rcvSignaling = true;
     msg.updateParams(prms);
-    // Normal Termination (by kill)
-    if(signal(SIGTERM, handle_sig) == SIG_ERR)
-        PMCERR("sig term fails %m");
-    // Control C, interrupt from keyboard
-    if(signal(SIGINT, handle_sig_ctrl) == SIG_ERR)
-        PMCERR("sig init fails %m");
-    // quit from keyboard
-    if(signal(SIGQUIT, handle_sig) == SIG_ERR)
-        PMCERR("sig quit fails %m");
-    // Hangup detected
-    if(signal(SIGHUP, handle_sig) == SIG_ERR)
-        PMCERR("sig hup fails %m");
     if(batch) {
         // batch mode
-        int pkts = 0;
+        uint16_t first = seq;
         // First we send all the commands, then we receive them all
-        for(int index = opt.procces_next(); index < argc; index++) {
+        for(int index = opt.procces_next(); index < argc && !stopSig;
+            index++) {
             if(run_line(argv[index]))
-                pkts++;
+                batchSent.push_back({sent_cmd(), {}});
         }
-        for(; pkts > 0; pkts--)
-            rcv_timeout();
+        rcv_batch_all(first);
     } else {
         char lineBuf[bufSize];
         if(use_uds) {
+            pollfd in = { STDIN_FILENO, POLLIN, 0 };
             // We only receive after sending a command
-            while(fgets(lineBuf, bufSize, stdin) != nullptr)
+            while(!stopSig && fgets(lineBuf, bufSize, stdin) != nullptr) {
                 if(run_line(lineBuf))
                     rcv_timeout();
+                // Flush before we wait for the next command
+                if(poll(&in, 1, 0) == 0)
+                    json_flush();
+            }
         } else {
             pollfd fds[2];
             // standard input
@@ -253,7 +701,10 @@ int main(int argc, char *const argv[])
             fds[1].fd = sk->fileno();
             fds[1].events = POLLIN;
             // We receive except when we type a command
-            for(;;) {
+            while(!stopSig) {
+                // Flush when nothing is pending
+                if(poll(fds, 2, 0) == 0)
+                    json_flush();
                 if(poll(fds, 2, INFTIM) > 0) {
                     if(fds[1].revents & POLLIN)
                         rcv();
@@ -266,6 +717,9 @@ int main(int argc, char *const argv[])
             }
         }
     }
+    json_flush();
     obj.close();
+    if(stopSig == SIGINT && !use_json)
+        DUMPNL;
     return 0;
 }
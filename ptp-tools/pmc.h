@@ -15,6 +15,10 @@
 #include <signal.h>
 #include <unistd.h>
 #include <poll.h>
+#include <sys/uio.h>
+#include <map>
+#include <memory>
+#include <vector>
 #include "init.h"
 #include "msg.h"
 #include "msgCall.h"
@@ -60,6 +64,8 @@ bool call_dumpSig(const Message &msg, tlvType_e tlvType, const BaseSigTlv *tlv);
  * @return true on success
  */
 bool call_data(Message &msg, actionField_e action, mng_vals_e id, char *save);
+/** Print the commands sent, not in the JSON output modes */
+extern bool show_sending;
 /**
  * Send current management TLV
  * @return true on success
@@ -1215,7 +1215,7 @@ bool call_data(Message &msg, actionField_e action, mng_vals_e id, char *save)
     if(!d.buildTlv(action, id))
         return false;
     bool ret = sendAction();
-    if(ret)
+    if(ret && show_sending)
         DUMPS("sending: %s %s\n", msg.act2str_c(msg.getSendAction()),
             msg.mng2str_c(id));
     return ret;
@@ -0,0 +1,419 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Monitor the synchronization of ptp4l instances
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * Based on the checksync sample.
+ * The tool subscribes to the port state and time synchronization
+ * events of each instance and keeps counters of the port states.
+ * A push updates the counters and the instance verdict in constant time,
+ * the global verdict is the count of instances in sync.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <unordered_map>
+#include <memory>
+#include <vector>
+#include "msg.h"
+#include "sock.h"
+#include "err.h"
+#include "timeCvrt.h"
+
+using namespace ptpmgmt;
+
+static const size_t bufSize = 2000;
+static const uint16_t subscribeDuration = 180; // seconds
+static const int64_t renewInterval = 60 * MSEC_PER_SEC;
+// No message of ptp4l for the subscription duration, it lost our subscription
+static const int64_t staleSubscribe = subscribeDuration * MSEC_PER_SEC;
+// Subscribe again after a send failure or a stale subscription
+static const int64_t retryInterval = MSEC_PER_SEC;
+static const int64_t tickInterval = 100; // milliseconds
+static volatile bool run = true;
+
+// Requests sent to each instance, the subscription is the last
+static const mng_vals_e queried[] = { PORT_PROPERTIES_NP, PORT_DATA_SET,
+        TIME_STATUS_NP
+    };
+static std::vector<Binary> requests;
+
+struct Instance {
+    std::string path;
+    std::string name;
+    SockUnix sk;
+    Message msg;
+    bool up; // Instance replied since the last send failure
+    bool synced;
+    std::unordered_map<uint16_t, portState_e> ports;
+    size_t receivers; // Ports in time receiver state
+    size_t transmitters; // Ports in time transmitter state
+    uint16_t designated; // Port of the designated interface, 0 for none
+    bool haveTime;
+    int64_t offset;
+    bool gmPresent;
+    int64_t lastTime; // Last time status, monotonic milliseconds
+    int64_t lastRcv; // Last message of ptp4l, a reply or a push
+    int64_t lastSend;
+    std::string reason; // Out of sync reason
+};
+static std::vector<std::unique_ptr<Instance>> instances;
+static size_t syncedCnt;
+static int64_t threshold = 100;
+static int64_t staleTime = 3 * MSEC_PER_SEC;
+static std::string designatedIface;
+static bool allowGm; // Instance without time receivers is in sync
+static bool json;
+static bool monitor;
+
+static void handler(int)
+{
+    run = false;
+}
+static int64_t now_ms()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * MSEC_PER_SEC + ts.tv_nsec / NSEC_PER_MSEC;
+}
+static std::string escape(const std::string &str)
+{
+    std::string ret;
+    for(char c : str) {
+        if(c == '"' || c == '\\')
+            ret += '\\';
+        ret += c;
+    }
+    return ret;
+}
+static inline portState_e normalize_state(portState_e state)
+{
+    switch(state) {
+        case PRE_TIME_TRANSMITTER:
+        case TIME_TRANSMITTER:
+        case UNCALIBRATED:
+        case TIME_RECEIVER:
+            return state;
+        default:
+            return DISABLED;
+    }
+}
+static bool build_requests(uint8_t domain)
+{
+    Message msg;
+    MsgParams prms = msg.getParams();
+    prms.domainNumber = domain;
+    prms.boundaryHops = 0; // Only the local ptp4l
+    pid_t pid = getpid();
+    prms.self_id.clockIdentity.v[6] = (pid >> 24) & 0xff;
+    prms.self_id.clockIdentity.v[7] = (pid >> 16) & 0xff;
+    prms.self_id.portNumber = pid & 0xffff;
+    msg.updateParams(prms);
+    uint8_t buf[bufSize];
+    for(mng_vals_e id : queried) {
+        if(!msg.setAction(GET, id) || msg.build(buf, bufSize, 0) !=
+            MNG_PARSE_ERROR_OK) {
+            fprintf(stderr, "Fail to build %s\n", Message::mng2str_c(id));
+            return false;
+        }
+        requests.push_back(Binary(buf, msg.getMsgLen()));
+    }
+    SUBSCRIBE_EVENTS_NP_t d;
+    d.duration = subscribeDuration;
+    d.setEvent(NOTIFY_PORT_STATE);
+    d.setEvent(NOTIFY_TIME_SYNC);
+    if(!msg.setAction(SET, SUBSCRIBE_EVENTS_NP, &d) ||
+        msg.build(buf, bufSize, 0) != MNG_PARSE_ERROR_OK) {
+        fprintf(stderr, "Fail to build SUBSCRIBE_EVENTS_NP\n");
+        return false;
+    }
+    requests.push_back(Binary(buf, msg.getMsgLen()));
+    return true;
+}
+static bool add_instance(const std::string &arg)
+{
+    std::unique_ptr<Instance> t(new Instance);
+    size_t eq = arg.find('=');
+    t->path = arg.substr(0, eq);
+    t->name = eq == std::string::npos ? t->path : arg.substr(eq + 1);
+    std::string self = "ptp_checksync." + std::to_string(getpid()) + "." +
+        std::to_string(instances.size());
+    if(!t->sk.setSelfAddress(self, true) || !t->sk.init() ||
+        !t->sk.setPeerAddress(t->path)) {
+        fprintf(stderr, "Fail to open %s: %s\n", t->path.c_str(),
+            Error::getError().c_str());
+        return false;
+    }
+    t->up = false;
+    t->synced = false;
+    t->receivers = 0;
+    t->transmitters = 0;
+    t->designated = 0;
+    t->haveTime = false;
+    t->offset = 0;
+    t->gmPresent = false;
+    t->lastTime = 0;
+    t->lastRcv = 0;
+    t->lastSend = 0;
+    t->reason = "unknown";
+    instances.push_back(std::move(t));
+    return true;
+}
+static void report(const Instance &t)
+{
+    bool all = syncedCnt == instances.size();
+    if(json)
+        printf("{\"instance\":\"%s\",\"synced\":%s,\"up\":%s,\"offset\":%jd,"
+            "\"receivers\":%zu,\"reason\":\"%s\",\"allSynced\":%s,"
+            "\"syncedInstances\":%zu,\"instances\":%zu}\n",
+            escape(t.name).c_str(), t.synced ? "true" : "false",
+            t.up ? "true" : "false", (intmax_t)t.offset, t.receivers,
+            t.reason.c_str(), all ? "true" : "false", syncedCnt,
+            instances.size());
+    else {
+        if(t.synced)
+            printf("%s in sync, offset %jd\n", t.name.c_str(),
+                (intmax_t)t.offset);
+        else
+            printf("%s out of sync: %s, offset %jd\n", t.name.c_str(),
+                t.reason.c_str(), (intmax_t)t.offset);
+        printf("%zu of %zu instances in sync\n", syncedCnt, instances.size());
+    }
+    fflush(stdout);
+}
+// Recompute the instance verdict from its counters
+static void update(Instance &t, int64_t ms)
+{
+    char reason[100];
+    bool gm = allowGm && t.receivers == 0 && t.transmitters > 0;
+    if(!t.up)
+        strcpy(reason, "down");
+    else if(gm)
+        *reason = 0;
+    else if(t.designated != 0 && t.ports[t.designated] != TIME_RECEIVER)
+        snprintf(reason, sizeof reason, "designated port %u (%s) is not "
+            "a time receiver", t.designated, designatedIface.c_str());
+    else if(t.receivers == 0)
+        strcpy(reason, "no time receiver port");
+    else if(!t.haveTime || ms - t.lastTime > staleTime)
+        strcpy(reason, "no time status");
+    else if(!t.gmPresent)
+        strcpy(reason, "no grandmaster");
+    else if(llabs(t.offset) > threshold)
+        strcpy(reason, "offset over threshold");
+    else
+        *reason = 0;
+    bool synced = *reason == 0;
+    if(synced == t.synced && t.reason == reason)
+        return;
+    if(synced != t.synced) {
+        if(synced)
+            syncedCnt++;
+        else
+            syncedCnt--;
+    }
+    t.synced = synced;
+    t.reason = reason;
+    report(t);
+}
+static void set_state(Instance &t, uint16_t port, portState_e state)
+{
+    state = normalize_state(state);
+    auto it = t.ports.find(port);
+    portState_e old = DISABLED;
+    if(it == t.ports.end())
+        t.ports[port] = state;
+    else {
+        old = it->second;
+        it->second = state;
+    }
+    if(old == state)
+        return;
+    if(old == TIME_RECEIVER)
+        t.receivers--;
+    else if(old == TIME_TRANSMITTER)
+        t.transmitters--;
+    if(state == TIME_RECEIVER)
+        t.receivers++;
+    else if(state == TIME_TRANSMITTER)
+        t.transmitters++;
+}
+static void down(Instance &t)
+{
+    t.up = false;
+    t.ports.clear();
+    t.receivers = 0;
+    t.transmitters = 0;
+    t.designated = 0;
+    t.haveTime = false;
+}
+static void send_requests(Instance &t, int64_t ms)
+{
+    t.lastSend = ms;
+    for(auto &r : requests) {
+        if(!t.sk.send(r.get(), r.size())) {
+            down(t);
+            return;
+        }
+    }
+}
+static void receive(Instance &t, int64_t ms)
+{
+    uint8_t buf[bufSize];
+    for(;;) {
+        ssize_t cnt = t.sk.rcv(buf, bufSize);
+        if(cnt <= 0)
+            break;
+        if(t.msg.parse(buf, cnt) != MNG_PARSE_ERROR_OK)
+            continue;
+        const BaseMngTlv *data = t.msg.getData();
+        if(data == nullptr)
+            continue;
+        t.up = true;
+        t.lastRcv = ms;
+        switch(t.msg.getTlvId()) {
+            case PORT_PROPERTIES_NP: {
+                const PORT_PROPERTIES_NP_t *pp =
+                    dynamic_cast<const PORT_PROPERTIES_NP_t *>(data);
+                uint16_t port = pp->portIdentity.portNumber;
+                if(!designatedIface.empty() &&
+                    pp->interface.textField == designatedIface)
+                    t.designated = port;
+                set_state(t, port, pp->portState);
+                break;
+            }
+            case PORT_DATA_SET: {
+                const PORT_DATA_SET_t *pd =
+                    dynamic_cast<const PORT_DATA_SET_t *>(data);
+                set_state(t, pd->portIdentity.portNumber, pd->portState);
+                break;
+            }
+            case TIME_STATUS_NP: {
+                const TIME_STATUS_NP_t *ts =
+                    dynamic_cast<const TIME_STATUS_NP_t *>(data);
+                t.offset = ts->master_offset;
+                t.gmPresent = ts->gmPresent != 0;
+                t.haveTime = true;
+                t.lastTime = ms;
+                break;
+            }
+            default:
+                break;
+        }
+        update(t, ms);
+    }
+}
+static void help(const char *app)
+{
+    fprintf(stderr, "\nusage: %s [options] [path[=name] ...]\n\n"
+        " Monitor the synchronization of ptp4l instances\n"
+        " The default instance is /var/run/ptp4l\n"
+        " Exit with 0 when all instances are in sync and 1 when they are not,\n"
+        " on timeout or on a signal\n\n"
+        " Options\n"
+        " -d domain  PTP domain number, default 0\n"
+        " -g         Instance without time receiver ports is in sync\n"
+        " -h         Print help\n"
+        " -i iface   Designated interface, must be a time receiver\n"
+        " -j         Print JSON lines\n"
+        " -m         Monitor, do not exit when in sync\n"
+        " -s msec    Time status is stale after milliseconds, default 3000\n"
+        " -w sec     Give up after seconds, default wait for ever\n"
+        " -x num     Sync offset threshold in nanoseconds, default 100\n\n",
+        app);
+}
+int main(int argc, char *const argv[])
+{
+    uint8_t domain = 0;
+    int64_t wait = 0;
+    int c;
+    while((c = getopt(argc, argv, "d:ghi:jms:w:x:")) != -1) {
+        switch(c) {
+            case 'd':
+                domain = atoi(optarg);
+                break;
+            case 'g':
+                allowGm = true;
+                break;
+            case 'i':
+                designatedIface = optarg;
+                break;
+            case 'j':
+                json = true;
+                break;
+            case 'm':
+                monitor = true;
+                break;
+            case 's':
+                staleTime = atoll(optarg);
+                break;
+            case 'w':
+                wait = atoll(optarg) * MSEC_PER_SEC;
+                break;
+            case 'x':
+                threshold = atoll(optarg);
+                break;
+            case 'h':
+                help(argv[0]);
+                return 0;
+            default:
+                help(argv[0]);
+                return 2;
+        }
+    }
+    if(threshold < 0 || staleTime <= 0 || wait < 0) {
+        help(argv[0]);
+        return 2;
+    }
+    if(!build_requests(domain))
+        return 2;
+    if(optind == argc) {
+        if(!add_instance("/var/run/ptp4l"))
+            return 2;
+    }
+    for(int i = optind; i < argc; i++) {
+        if(!add_instance(argv[i]))
+            return 2;
+    }
+    struct sigaction act = {0};
+    act.sa_handler = handler;
+    sigaction(SIGINT, &act, nullptr);
+    sigaction(SIGTERM, &act, nullptr);
+    int64_t start = now_ms();
+    int64_t next = start;
+    std::vector<pollfd> fds;
+    for(auto &t : instances)
+        fds.push_back({t->sk.fileno(), POLLIN, 0});
+    while(run && (monitor || syncedCnt < instances.size())) {
+        int64_t ms = now_ms();
+        if(wait > 0 && ms - start >= wait)
+            break;
+        if(ms >= next) {
+            for(auto &t : instances) {
+                if(t->up && ms - t->lastRcv >= staleSubscribe)
+                    down(*t);
+                // Renew the subscription, the pushes drive the verdict
+                if(ms - t->lastSend >= (t->up ? renewInterval : retryInterval))
+                    send_requests(*t, ms);
+                // Stale time status or a send failure
+                update(*t, ms);
+            }
+            next = ms + tickInterval;
+            continue;
+        }
+        if(poll(fds.data(), fds.size(), next - ms) <= 0)
+            continue;
+        ms = now_ms();
+        for(size_t i = 0; i < instances.size(); i++) {
+            if(fds[i].revents != 0)
+                receive(*instances[i], ms);
+        }
+    }
+    // The last verdict, on timeout and on a signal as well
+    return syncedCnt == instances.size() ? 0 : 1;
+}
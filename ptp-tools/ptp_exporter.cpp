@@ -0,0 +1,648 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Export LinuxPTP statistics as OpenMetrics text
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * A single event loop polls the ptp4l instances and serves the scrapes.
+ * The requests are built once, each round only updates the sequence.
+ * The last parsed TLVs are cached per instance and port.
+ * The text of an instance is rendered again only after a round
+ * that changed a cached value, a scrape sends the last exposition as is.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <map>
+#include <memory>
+#include <vector>
+#include "msg.h"
+#include "sock.h"
+#include "err.h"
+#include "timeCvrt.h"
+
+using namespace ptpmgmt;
+
+static const size_t bufSize = 2000;
+static const size_t httpMax = 4096; // Largest request we read
+static const uint16_t defPort = 9809;
+// Sequence ID offset in the PTP header
+static const size_t seqOffset = 30;
+static volatile bool run = true;
+
+static const mng_vals_e polled[] = { TIME_STATUS_NP, CURRENT_DATA_SET,
+        PORT_DATA_SET, PORT_STATS_NP, PORT_SERVICE_STATS_NP
+    };
+// Requests with the sequence ID of the current round
+static std::vector<Binary> requests;
+
+// Metric families
+enum Family_e {
+    F_UP,
+    F_OFFSET,
+    F_GM_PRESENT,
+    F_SERVO,
+    F_STEPS,
+    F_CUR_OFFSET,
+    F_PATH_DELAY,
+    F_PORT_STATE,
+    F_PEER_DELAY,
+    F_RX,
+    F_TX,
+    F_TIMEOUTS,
+    F_MISMATCH,
+    F_LAST
+};
+static const struct {
+    const char *name;
+    const char *type;
+    const char *help;
+} families[F_LAST] = {
+    {"ptp_up", "gauge", "ptp4l replied in the last poll round"},
+    {"ptp_master_offset_nanoseconds", "gauge", "Offset from the time transmitter"},
+    {"ptp_gm_present", "gauge", "Grandmaster is present"},
+    {"ptp_servo_state", "gauge", "Servo state, 0 unlocked, 1 jump, 2 locked, 3 stable"},
+    {"ptp_steps_removed", "gauge", "Steps removed from the grandmaster"},
+    {"ptp_offset_from_master_nanoseconds", "gauge", "Current data set offset from the time transmitter"},
+    {"ptp_mean_path_delay_nanoseconds", "gauge", "Mean path delay to the time transmitter"},
+    {"ptp_port_state", "gauge", "Port state, IEEE 1588 values"},
+    {"ptp_port_peer_mean_path_delay_nanoseconds", "gauge", "Port mean path delay to peer"},
+    {"ptp_port_rx_messages", "counter", "Port received messages"},
+    {"ptp_port_tx_messages", "counter", "Port transmitted messages"},
+    {"ptp_port_timeouts", "counter", "Port service timeouts"},
+    {"ptp_port_mismatches", "counter", "Port sync and follow up mismatches"},
+};
+
+struct PortCache {
+    bool haveDs, haveStats, haveService;
+    PORT_DATA_SET_t ds;
+    PORT_STATS_NP_t stats;
+    PORT_SERVICE_STATS_NP_t service;
+    bool seen; // Port replied in the round
+};
+struct Target {
+    std::string path;
+    std::string label; // Escaped instance label
+    SockUnix sk;
+    Message msg;
+    bool up; // Replied in the last round
+    bool replied; // Replied in the current round
+    bool dirty; // Cache changed since the last render
+    bool haveTime, haveCur;
+    TIME_STATUS_NP_t time;
+    CURRENT_DATA_SET_t cur;
+    std::map<uint16_t, PortCache> ports;
+    std::string frag[F_LAST]; // Rendered samples per family
+};
+static std::vector<std::unique_ptr<Target>> targets;
+static uint16_t seq;
+// Last exposition, a scrape in progress keeps its copy
+static std::shared_ptr<const std::string> exposition;
+
+struct Conn {
+    int fd;
+    std::string in;
+    std::string head;
+    std::shared_ptr<const std::string> body;
+    size_t sent; // Octets sent of head and body
+    bool reply; // Request was read
+};
+static std::vector<Conn> conns;
+
+static void handler(int)
+{
+    run = false;
+}
+static std::string escape(const std::string &str)
+{
+    std::string ret;
+    for(char c : str) {
+        switch(c) {
+            case '\\':
+                ret += "\\\\";
+                break;
+            case '"':
+                ret += "\\\"";
+                break;
+            case '\n':
+                ret += "\\n";
+                break;
+            default:
+                ret += c;
+        }
+    }
+    return ret;
+}
+static bool build_requests(uint8_t domain)
+{
+    Message msg;
+    MsgParams prms = msg.getParams();
+    prms.domainNumber = domain;
+    pid_t pid = getpid();
+    prms.self_id.clockIdentity.v[6] = (pid >> 24) & 0xff;
+    prms.self_id.clockIdentity.v[7] = (pid >> 16) & 0xff;
+    prms.self_id.portNumber = pid & 0xffff;
+    msg.updateParams(prms);
+    uint8_t buf[bufSize];
+    for(mng_vals_e id : polled) {
+        if(!msg.setAction(GET, id) || msg.build(buf, bufSize, 0) !=
+            MNG_PARSE_ERROR_OK) {
+            fprintf(stderr, "Fail to build %s\n", Message::mng2str_c(id));
+            return false;
+        }
+        requests.push_back(Binary(buf, msg.getMsgLen()));
+    }
+    return true;
+}
+static bool add_target(const std::string &arg)
+{
+    std::unique_ptr<Target> t(new Target);
+    size_t eq = arg.find('=');
+    t->path = arg.substr(0, eq);
+    t->label = escape(eq == std::string::npos ? t->path : arg.substr(eq + 1));
+    // Abstract address, unique per socket and nothing to clean on exit
+    std::string self = "ptp_exporter." + std::to_string(getpid()) + "." +
+        std::to_string(targets.size());
+    if(!t->sk.setSelfAddress(self, true) || !t->sk.init() ||
+        !t->sk.setPeerAddress(t->path)) {
+        fprintf(stderr, "Fail to open %s: %s\n", t->path.c_str(),
+            Error::getError().c_str());
+        return false;
+    }
+    t->up = false;
+    t->replied = false;
+    t->dirty = true;
+    t->haveTime = false;
+    t->haveCur = false;
+    targets.push_back(std::move(t));
+    return true;
+}
+static void send_round()
+{
+    seq++;
+    for(auto &r : requests) {
+        r[seqOffset] = seq >> 8;
+        r[seqOffset + 1] = seq & 0xff;
+    }
+    for(auto &t : targets) {
+        t->replied = false;
+        for(auto &p : t->ports)
+            p.second.seen = false;
+        for(auto &r : requests)
+            // ptp4l may be down, the instance is reported down
+            t->sk.send(r.get(), r.size());
+    }
+}
+// Compare only the values we render
+static bool same(const TIME_STATUS_NP_t &a, const TIME_STATUS_NP_t &b)
+{
+    return a.master_offset == b.master_offset && a.gmPresent == b.gmPresent &&
+        a.servo_state == b.servo_state;
+}
+static bool same(const CURRENT_DATA_SET_t &a, const CURRENT_DATA_SET_t &b)
+{
+    return a.stepsRemoved == b.stepsRemoved &&
+        a.offsetFromMaster.scaledNanoseconds ==
+        b.offsetFromMaster.scaledNanoseconds &&
+        a.meanPathDelay.scaledNanoseconds == b.meanPathDelay.scaledNanoseconds;
+}
+static bool same(const PORT_DATA_SET_t &a, const PORT_DATA_SET_t &b)
+{
+    return a.portState == b.portState &&
+        a.peerMeanPathDelay.scaledNanoseconds ==
+        b.peerMeanPathDelay.scaledNanoseconds;
+}
+static bool same(const PORT_STATS_NP_t &a, const PORT_STATS_NP_t &b)
+{
+    return memcmp(a.rxMsgType, b.rxMsgType, sizeof a.rxMsgType) == 0 &&
+        memcmp(a.txMsgType, b.txMsgType, sizeof a.txMsgType) == 0;
+}
+static bool same(const PORT_SERVICE_STATS_NP_t &a,
+    const PORT_SERVICE_STATS_NP_t &b)
+{
+    return a.announce_timeout == b.announce_timeout &&
+        a.sync_timeout == b.sync_timeout &&
+        a.delay_timeout == b.delay_timeout &&
+        a.unicast_service_timeout == b.unicast_service_timeout &&
+        a.unicast_request_timeout == b.unicast_request_timeout &&
+        a.master_announce_timeout == b.master_announce_timeout &&
+        a.master_sync_timeout == b.master_sync_timeout &&
+        a.qualification_timeout == b.qualification_timeout &&
+        a.sync_mismatch == b.sync_mismatch &&
+        a.followup_mismatch == b.followup_mismatch;
+}
+// Store a reply, the instance is rendered again only if a value changed
+template<typename T> static void update(Target &t, T &cache, bool &have,
+    const BaseMngTlv *data)
+{
+    const T &val = *dynamic_cast<const T *>(data);
+    if(have && same(cache, val))
+        return;
+    cache = val;
+    have = true;
+    t.dirty = true;
+}
+static void receive(Target &t)
+{
+    uint8_t buf[bufSize];
+    for(;;) {
+        ssize_t cnt = t.sk.rcv(buf, bufSize);
+        if(cnt <= 0)
+            return;
+        // Skip replies of an old round
+        if(t.msg.parse(buf, cnt) != MNG_PARSE_ERROR_OK ||
+            t.msg.getSequence() != seq)
+            continue;
+        const BaseMngTlv *data = t.msg.getData();
+        if(data == nullptr)
+            continue;
+        t.replied = true;
+        PortCache *p = nullptr;
+        mng_vals_e id = t.msg.getTlvId();
+        if(id != TIME_STATUS_NP && id != CURRENT_DATA_SET) {
+            uint16_t port = t.msg.getPeer().portNumber;
+            auto it = t.ports.find(port);
+            if(it == t.ports.end()) {
+                p = &t.ports[port];
+                p->haveDs = false;
+                p->haveStats = false;
+                p->haveService = false;
+                t.dirty = true;
+            } else
+                p = &it->second;
+            p->seen = true;
+        }
+        switch(id) {
+            case TIME_STATUS_NP:
+                update(t, t.time, t.haveTime, data);
+                break;
+            case CURRENT_DATA_SET:
+                update(t, t.cur, t.haveCur, data);
+                break;
+            case PORT_DATA_SET:
+                update(t, p->ds, p->haveDs, data);
+                break;
+            case PORT_STATS_NP:
+                update(t, p->stats, p->haveStats, data);
+                break;
+            case PORT_SERVICE_STATS_NP:
+                update(t, p->service, p->haveService, data);
+                break;
+            default:
+                break;
+        }
+    }
+}
+static void sample(std::string &out, Family_e f, const std::string &labels,
+    int64_t value, const char *extra = nullptr)
+{
+    char buf[300];
+    snprintf(buf, sizeof buf, "%s%s{%s%s} %jd\n", families[f].name,
+        *families[f].type == 'c' ? "_total" : "", labels.c_str(),
+        extra == nullptr ? "" : extra, (intmax_t)value);
+    out += buf;
+}
+static void render(Target &t)
+{
+    for(auto &f : t.frag)
+        f.clear();
+    std::string lbl = "instance=\"" + t.label + "\"";
+    sample(t.frag[F_UP], F_UP, lbl, t.up ? 1 : 0);
+    if(!t.up)
+        return;
+    if(t.haveTime) {
+        sample(t.frag[F_OFFSET], F_OFFSET, lbl, t.time.master_offset);
+        sample(t.frag[F_GM_PRESENT], F_GM_PRESENT, lbl, t.time.gmPresent);
+        sample(t.frag[F_SERVO], F_SERVO, lbl, t.time.servo_state);
+    }
+    if(t.haveCur) {
+        sample(t.frag[F_STEPS], F_STEPS, lbl, t.cur.stepsRemoved);
+        sample(t.frag[F_CUR_OFFSET], F_CUR_OFFSET, lbl,
+            t.cur.offsetFromMaster.getIntervalInt());
+        sample(t.frag[F_PATH_DELAY], F_PATH_DELAY, lbl,
+            t.cur.meanPathDelay.getIntervalInt());
+    }
+    char extra[100];
+    for(auto &it : t.ports) {
+        const PortCache &p = it.second;
+        std::string plbl = lbl + ",port=\"" + std::to_string(it.first) + "\"";
+        if(p.haveDs) {
+            sample(t.frag[F_PORT_STATE], F_PORT_STATE, plbl, p.ds.portState);
+            sample(t.frag[F_PEER_DELAY], F_PEER_DELAY, plbl,
+                p.ds.peerMeanPathDelay.getIntervalInt());
+        }
+        if(p.haveStats) {
+            for(int i = 0; i < MAX_MESSAGE_TYPES; i++) {
+                const char *type = Message::type2str_c((msgType_e)i);
+                // Skip reserved message types
+                if(strncmp(type, "unknown", 7) == 0)
+                    continue;
+                snprintf(extra, sizeof extra, ",type=\"%s\"", type);
+                sample(t.frag[F_RX], F_RX, plbl, p.stats.rxMsgType[i], extra);
+                sample(t.frag[F_TX], F_TX, plbl, p.stats.txMsgType[i], extra);
+            }
+        }
+        if(p.haveService) {
+            const PORT_SERVICE_STATS_NP_t &s = p.service;
+            const std::pair<const char *, uint64_t> timeouts[] = {
+                {"announce", s.announce_timeout},
+                {"sync", s.sync_timeout},
+                {"delay", s.delay_timeout},
+                {"unicast_service", s.unicast_service_timeout},
+                {"unicast_request", s.unicast_request_timeout},
+                {"master_announce", s.master_announce_timeout},
+                {"master_sync", s.master_sync_timeout},
+                {"qualification", s.qualification_timeout},
+            };
+            for(auto &to : timeouts) {
+                snprintf(extra, sizeof extra, ",kind=\"%s\"", to.first);
+                sample(t.frag[F_TIMEOUTS], F_TIMEOUTS, plbl, to.second, extra);
+            }
+            sample(t.frag[F_MISMATCH], F_MISMATCH, plbl, s.sync_mismatch,
+                ",kind=\"sync\"");
+            sample(t.frag[F_MISMATCH], F_MISMATCH, plbl, s.followup_mismatch,
+                ",kind=\"followup\"");
+        }
+    }
+}
+// Close the round, render the instances that changed
+static void end_round()
+{
+    bool changed = exposition == nullptr;
+    for(auto &t : targets) {
+        if(t->up != t->replied) {
+            t->up = t->replied;
+            t->dirty = true;
+        }
+        // Drop ports that left
+        for(auto it = t->ports.begin(); it != t->ports.end();) {
+            if(t->up && !it->second.seen) {
+                it = t->ports.erase(it);
+                t->dirty = true;
+            } else
+                it++;
+        }
+        if(t->dirty) {
+            render(*t);
+            t->dirty = false;
+            changed = true;
+        }
+    }
+    if(!changed)
+        return;
+    size_t len = 6;
+    for(auto &t : targets)
+        for(auto &f : t->frag)
+            len += f.size();
+    std::unique_ptr<std::string> out(new std::string);
+    out->reserve(len + F_LAST * 150);
+    for(int f = 0; f < F_LAST; f++) {
+        *out += "# TYPE ";
+        *out += families[f].name;
+        *out += " ";
+        *out += families[f].type;
+        *out += "\n# HELP ";
+        *out += families[f].name;
+        *out += " ";
+        *out += families[f].help;
+        *out += "\n";
+        for(auto &t : targets)
+            *out += t->frag[f];
+    }
+    *out += "# EOF\n";
+    exposition.reset(out.release());
+}
+static int listen_tcp(const char *addr, uint16_t port)
+{
+    sockaddr_in sa = {0};
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    if(inet_pton(AF_INET, addr, &sa.sin_addr) != 1) {
+        fprintf(stderr, "Wrong listen address %s\n", addr);
+        return -1;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int on = 1;
+    if(fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) ||
+        bind(fd, (sockaddr *)&sa, sizeof sa) || listen(fd, 16)) {
+        fprintf(stderr, "Fail to listen on %s:%u: %m\n", addr, port);
+        if(fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+static int listen_unix(const char *path)
+{
+    sockaddr_un sa = {0};
+    sa.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof sa.sun_path) {
+        fprintf(stderr, "Listen path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(sa.sun_path, path);
+    unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0 || bind(fd, (sockaddr *)&sa, sizeof sa) || listen(fd, 16)) {
+        fprintf(stderr, "Fail to listen on %s: %m\n", path);
+        if(fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+static void prepare_reply(Conn &c)
+{
+    static const char fmt[] = "HTTP/1.1 %s\r\nContent-Type: %s\r\n"
+        "Content-Length: %zu\r\nConnection: close\r\n\r\n";
+    static const char notFound[] = "Not found\n";
+    char buf[300];
+    c.reply = true;
+    c.sent = 0;
+    static const char metrics[] = "GET /metrics";
+    static const size_t metricsLen = sizeof metrics - 1;
+    // The query string of the metrics path is ignored
+    bool get = c.in.compare(0, metricsLen, metrics) == 0 &&
+        c.in.size() > metricsLen &&
+        (c.in[metricsLen] == ' ' || c.in[metricsLen] == '?');
+    if(get || c.in.compare(0, 6, "GET / ") == 0) {
+        c.body = exposition;
+        snprintf(buf, sizeof buf, fmt, "200 OK",
+            "application/openmetrics-text; version=1.0.0; charset=utf-8",
+            c.body->size());
+    } else {
+        c.body.reset(new std::string(notFound));
+        snprintf(buf, sizeof buf, fmt, "404 Not Found",
+            "text/plain; charset=utf-8", c.body->size());
+    }
+    c.head = buf;
+}
+// Return false to close the connection
+static bool serve(Conn &c, short revents)
+{
+    if(!c.reply) {
+        char buf[httpMax];
+        ssize_t cnt = read(c.fd, buf, sizeof buf);
+        if(cnt <= 0)
+            return cnt < 0 && errno == EAGAIN;
+        c.in.append(buf, cnt);
+        if(c.in.find("\r\n\r\n") == std::string::npos &&
+            c.in.find("\n\n") == std::string::npos)
+            return c.in.size() < httpMax;
+        prepare_reply(c);
+    } else if((revents & POLLOUT) == 0)
+        return (revents & (POLLERR | POLLHUP)) == 0;
+    // Send the header and the exposition without copying
+    while(c.sent < c.head.size() + c.body->size()) {
+        iovec iov[2];
+        int n = 0;
+        if(c.sent < c.head.size()) {
+            iov[n].iov_base = (void *)(c.head.data() + c.sent);
+            iov[n++].iov_len = c.head.size() - c.sent;
+            iov[n].iov_base = (void *)c.body->data();
+            iov[n++].iov_len = c.body->size();
+        } else {
+            size_t off = c.sent - c.head.size();
+            iov[n].iov_base = (void *)(c.body->data() + off);
+            iov[n++].iov_len = c.body->size() - off;
+        }
+        ssize_t cnt = writev(c.fd, iov, n);
+        if(cnt < 0)
+            return errno == EAGAIN;
+        c.sent += cnt;
+    }
+    return false;
+}
+static void help(const char *app)
+{
+    fprintf(stderr, "\nusage: %s [options] [ptp4l-uds[=name]]...\n\n"
+        " Poll ptp4l instances and serve OpenMetrics text\n"
+        " The default instance is /var/run/ptp4l\n\n"
+        " Options\n"
+        " -a address Listen IPv4 address, default 127.0.0.1\n"
+        " -d domain  PTP domain number, default 0\n"
+        " -h         Print help\n"
+        " -i msec    Poll interval in milliseconds, default 1000\n"
+        " -p port    Listen TCP port, default %u\n"
+        " -s path    Listen on a Unix socket instead of TCP\n\n",
+        app, defPort);
+}
+int main(int argc, char *const argv[])
+{
+    const char *addr = "127.0.0.1";
+    const char *path = nullptr;
+    uint16_t port = defPort;
+    uint8_t domain = 0;
+    int interval = MSEC_PER_SEC;
+    int c;
+    while((c = getopt(argc, argv, "a:d:hi:p:s:")) != -1) {
+        switch(c) {
+            case 'a':
+                addr = optarg;
+                break;
+            case 'd':
+                domain = atoi(optarg);
+                break;
+            case 'i':
+                interval = atoi(optarg);
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 's':
+                path = optarg;
+                break;
+            case 'h':
+                help(argv[0]);
+                return 0;
+            default:
+                help(argv[0]);
+                return -1;
+        }
+    }
+    if(interval <= 0) {
+        fprintf(stderr, "Wrong poll interval %d\n", interval);
+        return -1;
+    }
+    if(!build_requests(domain))
+        return -1;
+    if(optind == argc) {
+        if(!add_target("/var/run/ptp4l"))
+            return -1;
+    }
+    for(int i = optind; i < argc; i++) {
+        if(!add_target(argv[i]))
+            return -1;
+    }
+    int lfd = path != nullptr ? listen_unix(path) : listen_tcp(addr, port);
+    if(lfd < 0)
+        return -1;
+    struct sigaction act = {0};
+    act.sa_handler = handler;
+    sigaction(SIGINT, &act, nullptr);
+    sigaction(SIGTERM, &act, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    // The first round renders an exposition with all instances down
+    end_round();
+    send_round();
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t next = (int64_t)now.tv_sec * MSEC_PER_SEC +
+        now.tv_nsec / NSEC_PER_MSEC + interval;
+    std::vector<pollfd> fds;
+    while(run) {
+        fds.clear();
+        fds.push_back({lfd, POLLIN, 0});
+        for(auto &cn : conns)
+            fds.push_back({cn.fd, (short)(cn.reply ? POLLOUT : POLLIN), 0});
+        for(auto &t : targets)
+            fds.push_back({t->sk.fileno(), POLLIN, 0});
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t ms = (int64_t)now.tv_sec * MSEC_PER_SEC +
+            now.tv_nsec / NSEC_PER_MSEC;
+        if(ms >= next) {
+            end_round();
+            send_round();
+            next += interval;
+            // Do not try to catch up after a long stop
+            if(next <= ms)
+                next = ms + interval;
+            continue;
+        }
+        if(poll(fds.data(), fds.size(), next - ms) < 0)
+            continue;
+        size_t i = 1;
+        std::vector<Conn> keep;
+        for(auto &cn : conns) {
+            if(fds[i++].revents == 0 || serve(cn, fds[i - 1].revents))
+                keep.push_back(std::move(cn));
+            else
+                close(cn.fd);
+        }
+        conns.swap(keep);
+        for(auto &t : targets) {
+            if(fds[i++].revents != 0)
+                receive(*t);
+        }
+        if(fds[0].revents & POLLIN) {
+            int fd;
+            while((fd = accept4(lfd, nullptr, nullptr,
+                            SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+                conns.push_back({fd, "", "", nullptr, 0, false});
+        }
+    }
+    for(auto &cn : conns)
+        close(cn.fd);
+    close(lfd);
+    if(path != nullptr)
+        unlink(path);
+    return 0;
+}
@@ -0,0 +1,250 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Decode PTP management and signaling messages from capture files
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * The capture file is split into chunks of frames.
+ * Worker threads decode the chunks, the main thread writes
+ * the decoded records in the capture order.
+ */
+
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "pcap.h"
+#include "msg.h"
+#include "json.h"
+#include "err.h"
+
+using namespace ptpmgmt;
+
+// Decoded chunks a worker may run ahead of the writer, per worker
+static const size_t ahead = 4;
+// Management message offsets
+static const size_t actionOffset = 46;
+static const size_t tlvOffset = 48;
+
+static PcapFile pcap;
+static bool csv;
+static bool all; // Output all PTP messages
+static FILE *out = stdout;
+// Chunks output ring
+static std::mutex lock;
+static std::condition_variable ready; // Chunk was decoded
+static std::condition_variable written; // Chunk was written
+static std::vector<std::string> outs;
+static std::vector<bool> done;
+static size_t writes; // Chunks written
+static std::atomic<size_t> nextChunk;
+static std::atomic<size_t> records;
+
+static inline uint16_t net16(const uint8_t *p)
+{
+    return (uint16_t)p[0] << 8 | p[1];
+}
+static std::string addr(const PcapFrame_t &frm, const uint8_t *a)
+{
+    if(a == nullptr)
+        return "";
+    if(frm.transport == IEEE_802_3)
+        return Binary::bufToId(a, frm.addrLen);
+    return Binary(a, frm.addrLen).toIp();
+}
+static void record(Message &msg, const PcapFrame_t &frm, std::string &buf)
+{
+    const uint8_t *p = frm.msg;
+    msgType_e type = (msgType_e)(p[0] & 0xf);
+    bool parsed = false;
+    MNG_PARSE_ERROR_e err = MNG_PARSE_ERROR_OK;
+    if(type == Management || type == Signaling) {
+        err = msg.parse(p, frm.size);
+        parsed = err == MNG_PARSE_ERROR_OK;
+    } else if(!all)
+        return;
+    records++;
+    std::string src = addr(frm, frm.src);
+    std::string dst = addr(frm, frm.dst);
+    const char *trans = Message::netProt2str_c(frm.transport);
+    const char *action = "";
+    char tlv[20] = "";
+    if(type == Management && frm.size >= tlvOffset + 6) {
+        action = Message::act2str_c((actionField_e)(p[actionOffset] & 0xf));
+        if(parsed)
+            snprintf(tlv, sizeof tlv, "%s", Message::mng2str_c(msg.getTlvId()));
+        else
+            // The library does not map the requests management ID
+            snprintf(tlv, sizeof tlv, "0x%04x", net16(p + tlvOffset + 4));
+    } else if(type == Signaling && frm.size >= tlvOffset + 2)
+        snprintf(tlv, sizeof tlv, "%s",
+            Message::tlv2str_c((tlvType_e)net16(p + tlvOffset)));
+    char line[600];
+    if(csv) {
+        snprintf(line, sizeof line, "%zu,%s,%s,%s,%s,%u,%u,%s,%u,%s,%s,%s\n",
+            frm.index, frm.ts.string().c_str(), trans, src.c_str(),
+            dst.c_str(), frm.srcPort, frm.dstPort, Message::type2str_c(type),
+            net16(p + 30), action, tlv,
+            type == Management || type == Signaling ?
+            Message::err2str_c(err) : "");
+        buf += line;
+        return;
+    }
+    snprintf(line, sizeof line, "{\"frame\":%zu,\"time\":%s,"
+        "\"transport\":\"%s\",\"src\":\"%s\",\"dst\":\"%s\"", frm.index,
+        frm.ts.string().c_str(), trans, src.c_str(), dst.c_str());
+    buf += line;
+    if(frm.transport != IEEE_802_3) {
+        snprintf(line, sizeof line, ",\"srcPort\":%u,\"dstPort\":%u",
+            frm.srcPort, frm.dstPort);
+        buf += line;
+    }
+    if(parsed) {
+        buf += ",\"message\":";
+        buf += msg2json(msg, -1);
+        buf += "}\n";
+        return;
+    }
+    snprintf(line, sizeof line, ",\"messageType\":\"%s\",\"sequenceId\":%u",
+        Message::type2str_c(type), net16(p + 30));
+    buf += line;
+    if(*action != 0) {
+        snprintf(line, sizeof line, ",\"actionField\":\"%s\"", action);
+        buf += line;
+    }
+    if(*tlv != 0) {
+        snprintf(line, sizeof line, ",\"%s\":\"%s\"",
+            type == Management ? "managementId" : "tlvType", tlv);
+        buf += line;
+    }
+    if(type == Management || type == Signaling) {
+        snprintf(line, sizeof line, ",\"error\":\"%s\"", Message::err2str_c(err));
+        buf += line;
+    }
+    buf += "}\n";
+}
+static void worker()
+{
+    Message msg;
+    MsgParams prms = msg.getParams();
+    prms.rcvSignaling = true;
+    prms.filterSignaling = false;
+    msg.updateParams(prms);
+    size_t window = outs.size();
+    for(;;) {
+        size_t chunk = nextChunk++;
+        if(chunk >= pcap.chunks())
+            return;
+        std::string buf;
+        pcap.traverse(chunk, [&](const PcapFrame_t &frm) {
+            record(msg, frm, buf);
+            return true;
+        });
+        std::unique_lock<std::mutex> lk(lock);
+        // Wait for the writer to free the slot
+        written.wait(lk, [&] { return chunk < writes + window; });
+        outs[chunk % window] = std::move(buf);
+        done[chunk % window] = true;
+        ready.notify_one();
+    }
+}
+static void help(const char *app)
+{
+    fprintf(stderr, "\nusage: %s [options] capture-file\n\n"
+        " Decode PTP management and signaling messages from a pcap or\n"
+        " pcapng capture file to JSON lines\n\n"
+        " Options\n"
+        " -a         Output all PTP messages, not only management and signaling\n"
+        " -c         Use CSV instead of JSON lines\n"
+        " -h         Print help\n"
+        " -n frames  Number of frames in a chunk, default 4096\n"
+        " -o file    Output file, default standard output\n"
+        " -t threads Number of worker threads, default number of CPUs\n\n",
+        app);
+}
+int main(int argc, char *const argv[])
+{
+    size_t threads = std::thread::hardware_concurrency();
+    const char *file = nullptr;
+    int c;
+    while((c = getopt(argc, argv, "acho:n:t:")) != -1) {
+        switch(c) {
+            case 'a':
+                all = true;
+                break;
+            case 'c':
+                csv = true;
+                break;
+            case 'o':
+                file = optarg;
+                break;
+            case 'n':
+                if(!pcap.setChunkFrames(strtoul(optarg, nullptr, 0))) {
+                    fprintf(stderr, "%s\n", Error::getError().c_str());
+                    return -1;
+                }
+                break;
+            case 't':
+                threads = strtoul(optarg, nullptr, 0);
+                break;
+            case 'h':
+                help(argv[0]);
+                return 0;
+            default:
+                help(argv[0]);
+                return -1;
+        }
+    }
+    if(optind + 1 != argc) {
+        help(argv[0]);
+        return -1;
+    }
+    if(threads == 0)
+        threads = 1;
+    if(!pcap.open(argv[optind])) {
+        fprintf(stderr, "%s\n", Error::getError().c_str());
+        return -1;
+    }
+    if(file != nullptr) {
+        out = fopen(file, "w");
+        if(out == nullptr) {
+            fprintf(stderr, "Fail to open %s: %s\n", file, strerror(errno));
+            return -1;
+        }
+    }
+    if(threads > pcap.chunks())
+        threads = std::max(pcap.chunks(), (size_t)1);
+    outs.resize(threads * ahead);
+    done.resize(threads * ahead);
+    if(csv)
+        fputs("frame,time,transport,src,dst,srcPort,dstPort,messageType,"
+            "sequenceId,actionField,tlv,error\n", out);
+    std::vector<std::thread> workers;
+    for(size_t i = 0; i < threads; i++)
+        workers.emplace_back(worker);
+    size_t window = outs.size();
+    for(size_t chunk = 0; chunk < pcap.chunks(); chunk++) {
+        std::string buf;
+        {
+            std::unique_lock<std::mutex> lk(lock);
+            ready.wait(lk, [&] { return done[chunk % window]; });
+            buf = std::move(outs[chunk % window]);
+            done[chunk % window] = false;
+            writes++;
+        }
+        written.notify_all();
+        fwrite(buf.data(), 1, buf.size(), out);
+    }
+    for(auto &w : workers)
+        w.join();
+    fprintf(stderr, "%zu frames, %zu records\n", pcap.frames(), records.load());
+    if(fclose(out) != 0) {
+        fprintf(stderr, "Fail to write output: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
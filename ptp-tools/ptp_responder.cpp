@@ -0,0 +1,686 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Simulated ptp4l management responder
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * Answer management requests from an in-memory data set,
+ * a stand in for ptp4l when benchmarking the management clients.
+ * Responses are built once and kept per management ID and port,
+ * a request only updates the sequence and the target in a copy.
+ * Subscribers get push notifications and signaling in fixed rates.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include "msg.h"
+#include "err.h"
+#include "timeCvrt.h"
+
+using namespace ptpmgmt;
+
+static const size_t bufSize = 8192;
+static const uint16_t defPort = 320;
+static const char defPath[] = "/var/run/ptp4l";
+// PTP header offsets
+static const size_t domainOffset = 4;
+static const size_t srcOffset = 20;
+static const size_t seqOffset = 30;
+static const size_t controlOffset = 32;
+static const size_t intervalOffset = 33;
+static const size_t targetOffset = 34;
+static const size_t actionOffset = 46;
+static const size_t tlvOffset = 48;
+static const size_t portIdSize = 10;
+// Signaling header, with the target port identity
+static const size_t sigHdrSize = targetOffset + portIdSize;
+static volatile bool run = true;
+
+// Response of a management ID and port
+struct Entry {
+    Binary msg; // Empty till used
+    uint64_t tick; // Event round of the dynamic values
+};
+struct Peer {
+    int fd;
+    sockaddr_storage addr;
+    socklen_t len;
+    std::string key() const {
+        return std::string((const char *)&addr, len);
+    }
+};
+struct Subscriber {
+    Peer peer;
+    uint8_t portId[portIdSize]; // Subscriber port identity
+    SUBSCRIBE_EVENTS_NP_t events;
+    uint64_t expire; // Monotonic nanoseconds
+};
+
+static ClockIdentity_t clockId = {{ 0xc4, 0x7d, 0x46, 0xff, 0xfe, 0x20, 0xac, 0xae }};
+static uint16_t ports = 1;
+static uint8_t domainNumber;
+// Per management ID, one entry of the clock or an entry per port
+static std::vector<std::vector<Entry>> data;
+static std::vector<portState_e> states;
+static std::map<std::string, Subscriber> subscribers;
+static Message bld; // Build the responses
+static uint64_t tick; // Event rounds
+static uint16_t pushSeq;
+static size_t nextPort; // Port to change state on next event round
+static uint8_t out[bufSize];
+static struct {
+    uint64_t requests;
+    uint64_t replies;
+    uint64_t errors;
+    uint64_t pushes;
+    uint64_t signaling;
+} cnt;
+
+static void sig_stop(int)
+{
+    run = false;
+}
+static uint64_t now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+static portState_e defState(uint16_t port)
+{
+    return port == 1 ? SLAVE : MASTER;
+}
+static int64_t offset()
+{
+    // Wander a few tens of nanoseconds
+    return (int64_t)(tick % 41) - 20;
+}
+static bool dynamicId(mng_vals_e id)
+{
+    switch(id) {
+        case TIME_STATUS_NP:
+        case CURRENT_DATA_SET:
+        case PORT_STATS_NP:
+        case PORT_SERVICE_STATS_NP:
+            return true;
+        default:
+            return false;
+    }
+}
+// Build a response with a dataField of zeros
+static bool buildZero(mng_vals_e id, Binary &msg)
+{
+    MsgParams prms = bld.getParams();
+    prms.useZeroGet = false;
+    Message m(prms);
+    if(!m.setAction(GET, id) || m.build(out, bufSize, 0) != MNG_PARSE_ERROR_OK)
+        return false;
+    out[actionOffset] = RESPONSE;
+    msg.setBin(out, m.getMsgLen());
+    return true;
+}
+static bool buildMsg(actionField_e action, mng_vals_e id,
+    const BaseMngTlv *tlv, Binary &msg)
+{
+    if(!bld.setAction(action, id, tlv) ||
+        bld.build(out, bufSize, 0) != MNG_PARSE_ERROR_OK)
+        return false;
+    msg.setBin(out, bld.getMsgLen());
+    return true;
+}
+static void setSelf(uint16_t port)
+{
+    MsgParams prms = bld.getParams();
+    prms.self_id.clockIdentity = clockId;
+    prms.self_id.portNumber = port;
+    bld.updateParams(prms);
+}
+// Build the initial values of a management ID
+static bool fill(mng_vals_e id, uint16_t port, Binary &msg)
+{
+    setSelf(port);
+    PortIdentity_t portId = { clockId, port };
+    ClockQuality_t quality = { 248, Accurate_Unknown, 0xffff };
+    switch(id) {
+        case DEFAULT_DATA_SET: {
+            DEFAULT_DATA_SET_t d;
+            d.flags = 1; // Two step
+            d.numberPorts = ports;
+            d.priority1 = 128;
+            d.clockQuality = quality;
+            d.priority2 = 128;
+            d.clockIdentity = clockId;
+            d.domainNumber = domainNumber;
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        case CURRENT_DATA_SET: {
+            CURRENT_DATA_SET_t d;
+            d.stepsRemoved = 1;
+            d.offsetFromMaster.scaledNanoseconds = offset() << 16;
+            d.meanPathDelay.scaledNanoseconds = INT64_C(500) << 16;
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        case PARENT_DATA_SET: {
+            PARENT_DATA_SET_t d;
+            d.parentPortIdentity = portId;
+            d.flags = 0;
+            d.observedParentOffsetScaledLogVariance = 0xffff;
+            d.observedParentClockPhaseChangeRate = 0x7fffffff;
+            d.grandmasterPriority1 = 128;
+            d.grandmasterClockQuality = quality;
+            d.grandmasterPriority2 = 128;
+            d.grandmasterIdentity = clockId;
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        case TIME_PROPERTIES_DATA_SET: {
+            TIME_PROPERTIES_DATA_SET_t d;
+            d.currentUtcOffset = 37;
+            d.flags = F_PTP;
+            d.timeSource = INTERNAL_OSCILLATOR;
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        case PORT_DATA_SET: {
+            PORT_DATA_SET_t d;
+            d.portIdentity = portId;
+            d.portState = states[port - 1];
+            d.logMinDelayReqInterval = 0;
+            d.peerMeanPathDelay.scaledNanoseconds = 0;
+            d.logAnnounceInterval = 1;
+            d.announceReceiptTimeout = 3;
+            d.logSyncInterval = 0;
+            d.delayMechanism = E2E;
+            d.logMinPdelayReqInterval = 0;
+            d.versionNumber = 2;
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        case TIME_STATUS_NP: {
+            TIME_STATUS_NP_t d;
+            d.master_offset = offset();
+            d.ingress_time = (int64_t)tick * NSEC_PER_SEC;
+            d.cumulativeScaledRateOffset = 0;
+            d.scaledLastGmPhaseChange = 0;
+            d.gmTimeBaseIndicator = 0;
+            d.nanoseconds_msb = 0;
+            d.nanoseconds_lsb = 0;
+            d.fractional_nanoseconds = 0;
+            d.gmPresent = 1;
+            d.gmIdentity = clockId;
+            d.servo_state = SERVO_LOCKED;
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        case PORT_PROPERTIES_NP: {
+            PORT_PROPERTIES_NP_t d;
+            d.portIdentity = portId;
+            d.portState = states[port - 1];
+            d.timestamping = TS_HARDWARE;
+            d.interface.textField = "eth" + std::to_string(port - 1);
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        case PORT_STATS_NP: {
+            PORT_STATS_NP_t d;
+            d.portIdentity = portId;
+            for(int i = 0; i < MAX_MESSAGE_TYPES; i++) {
+                d.rxMsgType[i] = 0;
+                d.txMsgType[i] = 0;
+            }
+            d.rxMsgType[Sync] = tick;
+            d.rxMsgType[Announce] = tick / 2;
+            d.txMsgType[Delay_Req] = tick;
+            return buildMsg(RESPONSE, id, &d, msg);
+        }
+        default:
+            return buildZero(id, msg);
+    }
+}
+// The clock entry is used for port 0
+static Entry &slot(mng_vals_e id, uint16_t port)
+{
+    return data[id][port > 0 && Message::isPortScope(id) ? port - 1 : 0];
+}
+static Entry *entry(mng_vals_e id, uint16_t port)
+{
+    Entry &e = slot(id, port);
+    if(e.msg.empty() || (dynamicId(id) && e.tick != tick)) {
+        if(!fill(id, port, e.msg)) {
+            e.msg.resize(0);
+            return nullptr;
+        }
+        e.tick = tick;
+    }
+    return &e;
+}
+static void invalidate(mng_vals_e id, uint16_t port)
+{
+    slot(id, port).msg.resize(0);
+}
+static bool sendPeer(const Peer &peer, const void *buf, size_t len)
+{
+    return sendto(peer.fd, buf, len, 0, (const sockaddr *)&peer.addr,
+            peer.len) == (ssize_t)len;
+}
+// Send a response copy to the requester
+static bool reply(const Peer &peer, const uint8_t *req, const Binary &msg)
+{
+    size_t len = msg.size();
+    memcpy(out, msg.get(), len);
+    out[domainOffset] = req[domainOffset];
+    memcpy(out + seqOffset, req + seqOffset, 2);
+    memcpy(out + targetOffset, req + srcOffset, portIdSize);
+    cnt.replies++;
+    return sendPeer(peer, out, len);
+}
+// ptp4l replies with an error status TLV
+static void replyError(const Peer &peer, const uint8_t *req, uint16_t port,
+    managementErrorId_e err)
+{
+    memcpy(out, req, tlvOffset);
+    out[2] = 0;
+    out[3] = tlvOffset + 14;
+    memcpy(out + srcOffset, clockId.v, ClockIdentity_t::size());
+    out[srcOffset + 8] = port >> 8;
+    out[srcOffset + 9] = port & 0xff;
+    memcpy(out + targetOffset, req + srcOffset, portIdSize);
+    out[actionOffset] = (req[actionOffset] & 0xf) == COMMAND ?
+        ACKNOWLEDGE : RESPONSE;
+    uint8_t *p = out + tlvOffset;
+    *p++ = 0;
+    *p++ = MANAGEMENT_ERROR_STATUS;
+    *p++ = 0;
+    *p++ = 10; // Error TLV with an empty display text
+    *p++ = err >> 8;
+    *p++ = err & 0xff;
+    // managementId
+    *p++ = req[tlvOffset + 4];
+    *p++ = req[tlvOffset + 5];
+    memset(p, 0, 6);
+    cnt.errors++;
+    sendPeer(peer, out, tlvOffset + 14);
+}
+static void subscribe(const Peer &peer, const uint8_t *req,
+    const SUBSCRIBE_EVENTS_NP_t &events)
+{
+    Subscriber &s = subscribers[peer.key()];
+    s.peer = peer;
+    memcpy(s.portId, req + srcOffset, portIdSize);
+    s.events.duration = events.duration;
+    memcpy(s.events.bitmask, events.bitmask, EVENT_BITMASK_CNT);
+    s.expire = now() + (uint64_t)events.duration * NSEC_PER_SEC;
+}
+static void setPortState(uint16_t port, portState_e state)
+{
+    states[port - 1] = state;
+    invalidate(PORT_DATA_SET, port);
+    invalidate(PORT_PROPERTIES_NP, port);
+}
+static void handle(const Peer &peer, Message &req, const uint8_t *buf,
+    ssize_t len)
+{
+    if(len < (ssize_t)tlvOffset || (buf[0] & 0xf) != Management)
+        return;
+    cnt.requests++;
+    // Requests of other clocks and domains
+    if(buf[domainOffset] != domainNumber)
+        return;
+    bool allClocks = true;
+    for(size_t i = 0; i < ClockIdentity_t::size(); i++)
+        allClocks = allClocks && buf[targetOffset + i] == 0xff;
+    if(!allClocks &&
+        memcmp(buf + targetOffset, clockId.v, ClockIdentity_t::size()) != 0)
+        return;
+    uint8_t action = buf[actionOffset] & 0xf;
+    if(action != GET && action != SET && action != COMMAND)
+        return;
+    MNG_PARSE_ERROR_e err = req.parse(buf, len);
+    if(err != MNG_PARSE_ERROR_OK) {
+        // Drop wrong headers, as ptp4l does
+        if(err != MNG_PARSE_ERROR_HEADER && len >= (ssize_t)tlvOffset + 6)
+            replyError(peer, buf, 0, err == MNG_PARSE_ERROR_INVALID_ID ||
+                err == MNG_PARSE_ERROR_ACTION ? NOT_SUPPORTED : WRONG_LENGTH);
+        return;
+    }
+    mng_vals_e id = req.getTlvId();
+    const BaseMngTlv *tlv = req.getData();
+    uint16_t target = req.getTarget().portNumber;
+    uint16_t first = 0, last = 0;
+    if(Message::isPortScope(id) && id != NULL_PTP_MANAGEMENT) {
+        if(target == UINT16_MAX) {
+            first = 1;
+            last = ports;
+        } else if(target > 0 && target <= ports)
+            first = last = target;
+        else
+            return; // No such port
+    }
+    for(uint16_t port = first; port <= last; port++) {
+        Binary msg;
+        const Binary *send = &msg;
+        setSelf(port);
+        switch(action) {
+            case GET:
+                if(id == SUBSCRIBE_EVENTS_NP) {
+                    // Each client has its own subscription
+                    SUBSCRIBE_EVENTS_NP_t d;
+                    auto it = subscribers.find(peer.key());
+                    if(it != subscribers.end()) {
+                        d.duration = it->second.events.duration;
+                        memcpy(d.bitmask, it->second.events.bitmask,
+                            EVENT_BITMASK_CNT);
+                    } else
+                        d.duration = 0;
+                    buildMsg(RESPONSE, id, &d, msg);
+                } else {
+                    Entry *e = entry(id, port);
+                    if(e != nullptr)
+                        send = &e->msg;
+                }
+                break;
+            case SET:
+                if(!buildMsg(RESPONSE, id, tlv, msg))
+                    break;
+                if(id == SUBSCRIBE_EVENTS_NP)
+                    subscribe(peer, buf, *(const SUBSCRIBE_EVENTS_NP_t *)tlv);
+                else if(!Message::isEmpty(id)) {
+                    // Keep the new value for the following GET
+                    Entry &e = slot(id, port);
+                    e.msg = msg;
+                    e.tick = tick;
+                }
+                break;
+            case COMMAND:
+                if(!buildMsg(ACKNOWLEDGE, id, tlv, msg))
+                    break;
+                if(id == ENABLE_PORT)
+                    setPortState(port, defState(port));
+                else if(id == DISABLE_PORT)
+                    setPortState(port, DISABLED);
+                break;
+        }
+        if(send->empty())
+            replyError(peer, buf, port, WRONG_VALUE);
+        else if(!reply(peer, buf, *send))
+            return; // Client is gone
+    }
+}
+static void push(Subscriber &s, const Binary &msg)
+{
+    size_t len = msg.size();
+    memcpy(out, msg.get(), len);
+    out[seqOffset] = pushSeq >> 8;
+    out[seqOffset + 1] = pushSeq & 0xff;
+    memcpy(out + targetOffset, s.portId, portIdSize);
+    cnt.pushes++;
+    sendPeer(s.peer, out, len);
+}
+// linuxptp pushes the TLVs of the subscribed events
+static void event_round()
+{
+    tick++;
+    pushSeq++;
+    uint64_t ts = now();
+    for(auto it = subscribers.begin(); it != subscribers.end();) {
+        if(it->second.expire < ts)
+            it = subscribers.erase(it);
+        else
+            it++;
+    }
+    // Flip the state of one port per round
+    uint16_t port = nextPort + 1;
+    nextPort = (nextPort + 1) % ports;
+    if(port > 1)
+        setPortState(port, states[port - 1] == MASTER ? PASSIVE : MASTER);
+    if(subscribers.empty())
+        return;
+    Entry *time = entry(TIME_STATUS_NP, 0);
+    Entry *state = entry(PORT_DATA_SET, port);
+    for(auto &it : subscribers) {
+        Subscriber &s = it.second;
+        if(time != nullptr && s.events.getEvent(NOTIFY_TIME_SYNC))
+            push(s, time->msg);
+        if(state != nullptr && s.events.getEvent(NOTIFY_PORT_STATE))
+            push(s, state->msg);
+    }
+}
+// Signaling with the time status management TLV
+static void signaling_round()
+{
+    if(subscribers.empty())
+        return;
+    Entry *time = entry(TIME_STATUS_NP, 0);
+    if(time == nullptr)
+        return;
+    const uint8_t *m = time->msg.get();
+    size_t tlvLen = time->msg.size() - tlvOffset;
+    size_t len = sigHdrSize + tlvLen;
+    memcpy(out, m, targetOffset);
+    out[0] = (m[0] & 0xf0) | Signaling;
+    out[2] = len >> 8;
+    out[3] = len & 0xff;
+    out[controlOffset] = 5; // Other messages
+    out[intervalOffset] = 0x7f;
+    memcpy(out + sigHdrSize, m + tlvOffset, tlvLen);
+    for(auto &it : subscribers) {
+        Subscriber &s = it.second;
+        memcpy(out + targetOffset, s.portId, portIdSize);
+        out[seqOffset] = pushSeq >> 8;
+        out[seqOffset + 1] = pushSeq & 0xff;
+        cnt.signaling++;
+        sendPeer(s.peer, out, len);
+    }
+}
+static int open_unix(const char *path)
+{
+    sockaddr_un addr = {0};
+    if(strlen(path) >= sizeof addr.sun_path) {
+        fprintf(stderr, "Unix socket path is too long: %s\n", path);
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    // As ptp4l, remove the stale socket
+    unlink(path);
+    if(bind(fd, (sockaddr *)&addr, sizeof addr) < 0) {
+        fprintf(stderr, "Fail to bind %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+static int open_udp(const char *ip, uint16_t port)
+{
+    sockaddr_storage addr = {0};
+    socklen_t len;
+    sockaddr_in *a4 = (sockaddr_in *)&addr;
+    sockaddr_in6 *a6 = (sockaddr_in6 *)&addr;
+    if(inet_pton(AF_INET, ip, &a4->sin_addr) == 1) {
+        a4->sin_family = AF_INET;
+        a4->sin_port = htons(port);
+        len = sizeof *a4;
+    } else if(inet_pton(AF_INET6, ip, &a6->sin6_addr) == 1) {
+        a6->sin6_family = AF_INET6;
+        a6->sin6_port = htons(port);
+        len = sizeof *a6;
+    } else {
+        fprintf(stderr, "Wrong IP address: %s\n", ip);
+        return -1;
+    }
+    int fd = socket(addr.ss_family, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+    if(bind(fd, (sockaddr *)&addr, len) < 0) {
+        fprintf(stderr, "Fail to bind %s port %u: %s\n", ip, port,
+            strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+static void help(const char *app)
+{
+    fprintf(stderr, "\nusage: %s [options]\n\n"
+        " Answer PTP management requests as ptp4l does,\n"
+        " from an in-memory data set\n\n"
+        " Options\n"
+        " -d domain  Domain number, default 0\n"
+        " -e rate    Event rounds per second, default 1, 0 to stop events\n"
+        " -g rate    Signaling messages per second, default 0\n"
+        " -h         Print help\n"
+        " -n ports   Number of ports, default 1\n"
+        " -P port    UDP port, default %u\n"
+        " -s path    Unix socket path, default %s\n"
+        " -u address Serve also UDP on IPv4 or IPv6 address\n\n",
+        app, defPort, defPath);
+}
+int main(int argc, char *const argv[])
+{
+    const char *path = defPath;
+    const char *udp = nullptr;
+    uint16_t udpPort = defPort;
+    double eventRate = 1, sigRate = 0;
+    unsigned long val;
+    int c;
+    while((c = getopt(argc, argv, "d:e:g:hn:P:s:u:")) != -1) {
+        switch(c) {
+            case 'd':
+                domainNumber = strtoul(optarg, nullptr, 0);
+                break;
+            case 'e':
+                eventRate = strtod(optarg, nullptr);
+                break;
+            case 'g':
+                sigRate = strtod(optarg, nullptr);
+                break;
+            case 'n':
+                val = strtoul(optarg, nullptr, 0);
+                if(val == 0 || val >= UINT16_MAX) {
+                    fprintf(stderr, "Number of ports must be 1 to %u\n",
+                        UINT16_MAX - 1);
+                    return -1;
+                }
+                ports = val;
+                break;
+            case 'P':
+                udpPort = strtoul(optarg, nullptr, 0);
+                break;
+            case 's':
+                path = optarg;
+                break;
+            case 'u':
+                udp = optarg;
+                break;
+            case 'h':
+                help(argv[0]);
+                return 0;
+            default:
+                help(argv[0]);
+                return -1;
+        }
+    }
+    if(optind != argc || eventRate < 0 || sigRate < 0) {
+        help(argv[0]);
+        return -1;
+    }
+    MsgParams prms = bld.getParams();
+    prms.domainNumber = domainNumber;
+    prms.isUnicast = true;
+    bld.updateParams(prms);
+    prms.rcvRequests = true;
+    Message req(prms);
+    data.resize(LAST_MNG_ID);
+    for(int id = FIRST_MNG_ID; id < LAST_MNG_ID; id++)
+        data[id].resize(Message::isPortScope((mng_vals_e)id) ? ports : 1);
+    states.resize(ports);
+    for(uint16_t port = 1; port <= ports; port++)
+        states[port - 1] = defState(port);
+    std::vector<pollfd> fds;
+    int fd = open_unix(path);
+    if(fd < 0)
+        return -1;
+    fds.push_back({ fd, POLLIN, 0 });
+    if(udp != nullptr) {
+        fd = open_udp(udp, udpPort);
+        if(fd < 0) {
+            unlink(path);
+            return -1;
+        }
+        fds.push_back({ fd, POLLIN, 0 });
+    }
+    signal(SIGINT, sig_stop);
+    signal(SIGTERM, sig_stop);
+    uint64_t eventPeriod = 0, sigPeriod = 0;
+    if(eventRate > 0)
+        eventPeriod = std::max((uint64_t)(NSEC_PER_SEC / eventRate), (uint64_t)1);
+    if(sigRate > 0)
+        sigPeriod = std::max((uint64_t)(NSEC_PER_SEC / sigRate), (uint64_t)1);
+    uint64_t nextEvent = now() + eventPeriod;
+    uint64_t nextSig = now() + sigPeriod;
+    uint8_t buf[bufSize];
+    while(run) {
+        uint64_t ts = now();
+        if(eventRate > 0 && nextEvent <= ts) {
+            event_round();
+            nextEvent += eventPeriod;
+            // Skip the rounds we are late for
+            if(nextEvent < ts)
+                nextEvent = ts + eventPeriod;
+        }
+        if(sigRate > 0 && nextSig <= ts) {
+            signaling_round();
+            nextSig += sigPeriod;
+            if(nextSig < ts)
+                nextSig = ts + sigPeriod;
+        }
+        // Wake for the next round, or at least every second
+        uint64_t next = ts + NSEC_PER_SEC;
+        if(eventRate > 0 && nextEvent < next)
+            next = nextEvent;
+        if(sigRate > 0 && nextSig < next)
+            next = nextSig;
+        timespec wait = { (time_t)((next - ts) / NSEC_PER_SEC),
+                (long)((next - ts) % NSEC_PER_SEC)
+            };
+        if(ppoll(fds.data(), fds.size(), &wait, nullptr) <= 0)
+            continue;
+        for(auto &p : fds) {
+            if((p.revents & POLLIN) == 0)
+                continue;
+            // Drain the socket, bounded to keep the rounds on time
+            for(int i = 0; i < 64; i++) {
+                Peer peer;
+                peer.fd = p.fd;
+                peer.len = sizeof peer.addr;
+                ssize_t len = recvfrom(p.fd, buf, bufSize, MSG_DONTWAIT,
+                        (sockaddr *)&peer.addr, &peer.len);
+                if(len < 0)
+                    break;
+                handle(peer, req, buf, len);
+            }
+        }
+    }
+    for(auto &p : fds)
+        close(p.fd);
+    unlink(path);
+    fprintf(stderr, "%ju requests, %ju replies, %ju errors, %ju pushes, "
+        "%ju signaling\n", (uintmax_t)cnt.requests, (uintmax_t)cnt.replies,
+        (uintmax_t)cnt.errors, (uintmax_t)cnt.pushes, (uintmax_t)cnt.signaling);
+    return 0;
+}
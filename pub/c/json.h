@@ -23,7 +23,8 @@ typedef const struct ptpmgmt_json_t *const_ptpmgmt_json;
 /**
  * Convert Message to JSON string
  * @param[in] message received from PTP entity
- * @param[in] indent base indent for the JSON string
+ * @param[in] indent base indent for the JSON string,
+ *            negative for a compact string in a single line
  * @return JSON string
  * @note The caller @b MUST free the string after use!
  */
@@ -33,7 +34,8 @@ char *ptpmgmt_json_msg2json(const_ptpmgmt_msg message, int indent);
  * Convert PTP managment TLV to JSON string
  * @param[in] managementId PTP managment TLV id
  * @param[in] tlv PTP managment TLV
- * @param[in] indent base indent for the JSON string
+ * @param[in] indent base indent for the JSON string,
+ *            negative for a compact string in a single line
  * @return JSON string
  * @note The caller @b MUST free the string after use!
  */
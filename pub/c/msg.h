@@ -279,6 +279,7 @@ struct ptpmgmt_msg_t {
      * @param[in] id management TLV id
      * @return true if management TLV is valid
      * @note function also check implement specific TLVs!
+     * @note function also check the TLV is part of the library build!
      */
     bool (*isValidId)(const_ptpmgmt_msg m, enum ptpmgmt_mng_vals_e id);
     /**
@@ -508,6 +509,12 @@ struct ptpmgmt_msg_t {
      * @note You @b should not try to free this TLV object
      */
     const void *(*getSigMngTlv)(ptpmgmt_msg m, size_t position);
+    /**
+     * Check management TLV id applies to a port
+     * @param[in] id management TLV id
+     * @return true if the TLV applies to a port, false for the clock
+     */
+    bool (*isPortScope)(enum ptpmgmt_mng_vals_e id);
 };
 
 /**
@@ -691,6 +698,12 @@ bool ptpmgmt_msg_is_FTRA(uint8_t flags);
  * @return true if dataField is empty
  */
 bool ptpmgmt_msg_isEmpty(enum ptpmgmt_mng_vals_e id);
+/**
+ * Check management TLV id applies to a port
+ * @param[in] id management TLV id
+ * @return true if the TLV applies to a port, false for the clock
+ */
+bool ptpmgmt_msg_isPortScope(enum ptpmgmt_mng_vals_e id);
 
 /**
  * Alocate new message structure
@@ -20,7 +20,8 @@ __PTPMGMT_NAMESPACE_BEGIN
 /**
  * Convert Message to JSON string
  * @param[in] message received from PTP entity
- * @param[in] indent base indent for the JSON string
+ * @param[in] indent base indent for the JSON string,
+ *            negative for a compact string in a single line
  * @return JSON string
  */
 std::string msg2json(const Message &message, int indent = 0);
@@ -29,7 +30,8 @@ std::string msg2json(const Message &message, int indent = 0);
  * Convert PTP managment TLV to JSON string
  * @param[in] managementId PTP managment TLV id
  * @param[in] tlv PTP managment TLV
- * @param[in] indent base indent for the JSON string
+ * @param[in] indent base indent for the JSON string,
+ *            negative for a compact string in a single line
  * @return JSON string
  */
 std::string tlv2json(mng_vals_e managementId, const BaseMngTlv *tlv,
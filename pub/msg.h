@@ -334,11 +334,18 @@ class Message
      * @return true if dataField is empty
      */
     static bool isEmpty(mng_vals_e id);
+    /**
+     * Check management TLV id applies to a port
+     * @param[in] id management TLV id
+     * @return true if the TLV applies to a port, false for the clock
+     */
+    static bool isPortScope(mng_vals_e id);
     /**
      * Check if management TLV is valid for use
      * @param[in] id management TLV id
      * @return true if management TLV is valid
      * @note function also check implement specific TLVs!
+     * @note function also check the TLV is part of the library build!
      */
     bool isValidId(mng_vals_e id);
     /**
@@ -348,6 +355,8 @@ class Message
      * @param[in] dataSend pointer to TLV object
      * @return true if setting is correct
      * @note the setting is valid for send only
+     * @note a responder may use RESPONSE and ACKNOWLEDGE
+     *       with the target set to the requester
      * @attention
      *  The caller must use the proper structure with the TLV id!
      *  Mismatch will probably cause a crash to your application.
@@ -424,6 +433,7 @@ class Message
      * Get last reply management action
      * @return reply management action
      * @note set on parse
+     * @note with rcvRequests parameter, may be the request action
      */
     actionField_e getReplyAction() const { return m_replyAction; }
     /**
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Read PTP messages from capture files
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * @details
+ *  Map a pcap or pcapng capture file into memory and locate
+ *  the PTP messages in the captured frames.
+ *  The Ethernet, VLAN, Linux cooked, IPv4, IPv6 and UDP headers are
+ *  stripped, the PTP message can be passed to Message::parse().
+ *  The frames are split into chunks, so threads can walk
+ *  the chunks in parallel.
+ */
+
+#ifndef __PTPMGMT_PCAP_H
+#define __PTPMGMT_PCAP_H
+
+#include <vector>
+#include <functional>
+#include "types.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+/**
+ * PTP message in a captured frame
+ */
+struct PcapFrame_t {
+    size_t index; /**< Frame number in the capture file, start with 1 */
+    Timestamp_t ts; /**< Capture time */
+    /** Transport, layer 2 or UDP over IP version 4 or 6 */
+    networkProtocol_e transport;
+    /** Source address, MAC or IP address, or null if unknown */
+    const uint8_t *src;
+    /** Destination address, MAC or IP address, or null if unknown */
+    const uint8_t *dst;
+    size_t addrLen; /**< Addresses length */
+    uint16_t srcPort; /**< UDP source port, zero for layer 2 */
+    uint16_t dstPort; /**< UDP destination port, zero for layer 2 */
+    const uint8_t *msg; /**< PTP message */
+    size_t size; /**< PTP message size */
+};
+
+/**
+ * @brief Capture file with PTP traffic
+ * @details
+ *  The object maps the file read only.
+ *  Opening the file walks the frames headers only and
+ *  records the start of each chunk.
+ *  Walking a chunk does not change the object,
+ *  so multiple threads may walk different chunks at the same time.
+ */
+class PcapFile
+{
+  private:
+    struct Iface;
+    struct Section;
+    struct Chunk {
+        size_t offset; /* file offset of first block */
+        size_t frame; /* first frame index */
+        size_t section; /* pcapng section of first block */
+    };
+    const uint8_t *m_map;
+    size_t m_size;
+    size_t m_frames;
+    size_t m_chunkFrames;
+    bool m_ng; /* pcapng file */
+    bool m_swap; /* pcap file byte order differ from host */
+    bool m_nsec; /* pcap time stamps use nanoseconds */
+    uint32_t m_link; /* pcap link type */
+    std::vector<Chunk> m_chunks;
+    std::vector<Section> m_sections;
+    bool indexPcap();
+    bool indexNg();
+    bool frame(uint32_t link, const uint8_t *data, size_t len,
+        PcapFrame_t &frame) const;
+    bool walkPcap(const Chunk &chk, size_t last,
+        const std::function<bool (const PcapFrame_t &frame)> &cb) const;
+    bool walkNg(const Chunk &chk, size_t last,
+        const std::function<bool (const PcapFrame_t &frame)> &cb) const;
+
+  public:
+    PcapFile();
+    ~PcapFile();
+    PcapFile(const PcapFile &) = delete;
+    PcapFile &operator=(const PcapFile &) = delete;
+    /**
+     * Set number of frames in a chunk
+     * @param[in] frames number of frames
+     * @return true for success
+     * @note Call before open, default is 4096 frames
+     */
+    bool setChunkFrames(size_t frames);
+    /**
+     * Map and index a capture file
+     * @param[in] file capture file name
+     * @return true for success
+     * @note Support pcap with micro or nanoseconds and pcapng
+     */
+    bool open(const std::string &file);
+    /**
+     * Unmap the capture file
+     */
+    void close();
+    /**
+     * Query if a capture file is mapped
+     * @return true if mapped
+     */
+    bool isOpen() const { return m_map != nullptr; }
+    /**
+     * Get number of frames in the capture file
+     * @return number of frames
+     */
+    size_t frames() const { return m_frames; }
+    /**
+     * Get number of chunks
+     * @return number of chunks
+     */
+    size_t chunks() const { return m_chunks.size(); }
+    /**
+     * Walk the PTP messages of a chunk
+     * @param[in] chunk chunk index
+     * @param[in] callback function to call with each PTP message
+     * @return true if the whole chunk was walked
+     * @note Stop the walk if the callback returns false
+     * @note The frame pointers are valid while the file is mapped
+     */
+    bool traverse(size_t chunk,
+        const std::function<bool (const PcapFrame_t &frame)> &callback) const;
+};
+
+__PTPMGMT_NAMESPACE_END
+
+#endif /* __PTPMGMT_PCAP_H */
@@ -0,0 +1,323 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Sample multiple PHCs in parallel
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * @details
+ *  Sample all PTP hardware clocks on the host at the same moment
+ *  and provide the offsets between them.
+ *  Each PHC is sampled by a dedicated thread, pinned to its own CPU core.
+ *  The threads are released together using a barrier,
+ *  so the cross-clock offsets do not suffer from a serial sampling skew.
+ */
+
+#ifndef __PTPMGMT_PHC_SAMPLER_H
+#define __PTPMGMT_PHC_SAMPLER_H
+
+#include <memory>
+#include "ptp.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+/**
+ * Single PHC result of a sampling round
+ */
+struct PhcClockSample_t {
+    bool valid; /**< Clock was sampled successfully in this round */
+    Timestamp_t sysClk; /**< System clock sample, middle of the window */
+    Timestamp_t phcClk; /**< PHC clock sample */
+    /** PHC offset from the system clock in nanoseconds */
+    int64_t offset;
+    /**
+     * System clock read window in nanoseconds,
+     * zero if the kernel does not provide it.
+     */
+    int64_t delay;
+};
+
+/**
+ * Sampling round result
+ */
+struct PhcRound_t {
+    uint64_t sequence; /**< Round sequence number, start with 1 */
+    std::vector<PhcClockSample_t> clocks; /**< Per PHC sample */
+    /**
+     * Cross clock offset matrix in nanoseconds
+     * Row major order, use offset() to access.
+     */
+    std::vector<int64_t> matrix;
+    /**
+     * Get number of clocks in the round
+     * @return number of clocks
+     */
+    size_t size() const { return clocks.size(); }
+    /**
+     * Query if offset between two clocks is valid
+     * @param[in] i first clock index
+     * @param[in] j second clock index
+     * @return true if both clocks have a valid sample
+     */
+    bool valid(size_t i, size_t j) const {
+        return i < clocks.size() && j < clocks.size() &&
+            clocks[i].valid && clocks[j].valid;
+    }
+    /**
+     * Get offset between two clocks
+     * @param[in] i first clock index
+     * @param[in] j second clock index
+     * @return offset of clock i from clock j in nanoseconds
+     * @note return zero if the offset is not valid
+     */
+    int64_t offset(size_t i, size_t j) const {
+        return valid(i, j) ? matrix[i * clocks.size() + j] : 0;
+    }
+};
+
+/**
+ * Cross time stamp method
+ */
+enum PhcCrossMethod_e {
+    PHC_CROSS_AUTO, /**< Probe and use the best method */
+    /** Driver samples the PHC and the system clock at the same moment */
+    PHC_CROSS_PRECISE,
+    /** System clock is read before and after each PHC read */
+    PHC_CROSS_EXT,
+    /** System clock reads are interleaved with the PHC reads */
+    PHC_CROSS_BASIC,
+};
+
+/**
+ * Cross time stamp method statistics
+ * @note The smoothed values use a 1/16 gain, like RFC 3550 jitter.
+ */
+struct PhcCrossStats_t {
+    uint64_t samples; /**< Number of successful samples */
+    uint64_t failures; /**< Number of failed samples */
+    int64_t latency; /**< Last sample call duration in nanoseconds */
+    int64_t avgLatency; /**< Smoothed sample call duration in nanoseconds */
+    /**
+     * Smoothed system clock window in nanoseconds,
+     * zero with the precise method
+     */
+    int64_t window;
+    /**
+     * Smoothed absolute change of the offset between consecutive samples
+     * in nanoseconds
+     * @note Include the clocks frequency difference between the samples.
+     */
+    int64_t jitter;
+};
+
+/**
+ * @brief Sample a PHC against the system clock using the best method
+ * @details
+ *  The first sample probes the methods the driver supports, from
+ *  the precise cross time stamp, through the extended sampling,
+ *  to the basic sampling. The selected method is cached per device
+ *  for the whole process.
+ *  The object measures the latency and jitter of each method it uses.
+ */
+class PhcCrossTs
+{
+  private:
+    const PtpClock *m_clk;
+    size_t m_samples;
+    PhcCrossMethod_e m_method; /* method in use, auto if not probed */
+    bool m_forced;
+    size_t m_fails; /* consecutive failures of the method in use */
+    PhcCrossStats_t m_stats[PHC_CROSS_BASIC + 1];
+    int64_t m_last[PHC_CROSS_BASIC + 1];
+    bool sampleBy(PhcCrossMethod_e method, PhcClockSample_t &res);
+    bool probe(PhcClockSample_t &res);
+    void select(PhcCrossMethod_e method);
+
+  public:
+    PhcCrossTs();
+    /**
+     * Set the PHC to sample
+     * @param[in] clk PHC
+     * @return true for success
+     * @note The object does not own the clock,
+     *       the caller must keep it while the object uses it.
+     */
+    bool setClock(const PtpClock *clk);
+    /**
+     * Get the PHC
+     * @return pointer to clock or null if not set
+     */
+    const PtpClock *getClock() const { return m_clk; }
+    /**
+     * Set number of samples to take with the extended and basic methods
+     * @param[in] samples number of samples, up to 25
+     * @return true for success
+     * @note The best sample is the one with the smallest system window
+     */
+    bool setSamples(size_t samples);
+    /**
+     * Get number of samples
+     * @return number of samples
+     */
+    size_t getSamples() const { return m_samples; }
+    /**
+     * Force a method
+     * @param[in] method to use, auto to probe
+     * @return true for success
+     */
+    bool setMethod(PhcCrossMethod_e method);
+    /**
+     * Get method in use
+     * @return method in use or auto if not probed yet
+     */
+    PhcCrossMethod_e getMethod() const { return m_method; }
+    /**
+     * Sample the PHC against the system clock
+     * @param[out] res sample result
+     * @return true for success
+     * @note With auto method, a failed sample falls back to the next method.
+     *       After repeated failures the next method is used for the device.
+     */
+    bool sample(PhcClockSample_t &res);
+    /**
+     * Measure all methods the driver supports and select the best
+     * @param[in] rounds number of samples to take with each method
+     * @return true if any method succeeded
+     * @note With auto method, use the precise method if supported,
+     *       otherwise the method with the smallest system clock window.
+     */
+    bool calibrate(size_t rounds);
+    /**
+     * Get method statistics
+     * @param[in] method cross time stamp method, auto for method in use
+     * @return statistics
+     */
+    const PhcCrossStats_t &getStats(PhcCrossMethod_e method) const;
+    /**
+     * Convert method to string
+     * @param[in] method cross time stamp method
+     * @return method name
+     */
+    static const char *method2str(PhcCrossMethod_e method);
+    /**
+     * Clear the cache of the methods selected per device
+     */
+    static void clearCache();
+};
+
+/**
+ * @brief Sample multiple PHCs in parallel
+ * @details
+ *  The sampler opens the PHCs, create a sampling thread per PHC
+ *  and pin each thread to a separate CPU core.
+ *  On each round, all threads pass a barrier and sample their PHC
+ *  against the system clock.
+ *  As all PHCs are compared with the same system clock at the same time,
+ *  the sampler can provide the offset between any two PHCs.
+ * @note Each thread uses PhcCrossTs to sample its PHC.
+ * @note Only a single thread should call the sampler methods.
+ */
+class PhcSampler
+{
+  private:
+    class Worker;
+    class Sync;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::unique_ptr<Sync> m_sync;
+    std::vector<int> m_cpus;
+    size_t m_samples;
+    bool m_running;
+    bool addWorker(std::unique_ptr<Worker> &wrk);
+
+  public:
+    PhcSampler();
+    ~PhcSampler();
+    /**
+     * Add a PHC using its PTP index
+     * @param[in] ptpIndex clock PTP index
+     * @param[in] readonly open clock to read only
+     * @return true for success
+     * @note can not add clocks while the sampler is running
+     */
+    bool addClock(int ptpIndex, bool readonly = true);
+    /**
+     * Add a PHC using its device name
+     * @param[in] device name
+     * @param[in] readonly open clock to read only
+     * @return true for success
+     * @note can not add clocks while the sampler is running
+     */
+    bool addClock(const std::string &device, bool readonly = true);
+    /**
+     * Add all PHCs found in the system
+     * @param[in] readonly open clocks to read only
+     * @return number of clocks added
+     * @note the function scan the /dev folder for ptpN devices
+     */
+    size_t addAllClocks(bool readonly = true);
+    /**
+     * Get number of clocks
+     * @return number of clocks
+     */
+    size_t size() const { return m_workers.size(); }
+    /**
+     * Get clock
+     * @param[in] index clock index in sampler
+     * @return pointer to clock or null if index is out of range
+     */
+    const PtpClock *getClock(size_t index) const;
+    /**
+     * Get clock cross time stamp
+     * @param[in] index clock index in sampler
+     * @return pointer to cross time stamp or null if index is out of range
+     * @note Do not use while a round is in progress
+     */
+    const PhcCrossTs *getCrossTs(size_t index) const;
+    /**
+     * Set number of samples each thread takes in a round
+     * @param[in] samples number of samples, up to 25
+     * @return true for success
+     * @note The best sample is the one with the smallest system window
+     */
+    bool setSamples(size_t samples);
+    /**
+     * Get number of samples each thread takes in a round
+     * @return number of samples
+     */
+    size_t getSamples() const { return m_samples; }
+    /**
+     * Set the CPU cores to pin the sampling threads on
+     * @param[in] cpus list of CPU cores, thread per core
+     * @return true for success
+     * @note By default the sampler uses the CPU cores the process may run on.
+     * @note If there are more clocks than cores, the cores are reused.
+     */
+    bool setCpus(const std::vector<int> &cpus);
+    /**
+     * Start sampling threads
+     * @return true for success
+     */
+    bool start();
+    /**
+     * Stop sampling threads
+     */
+    void stop();
+    /**
+     * Query if sampling threads are running
+     * @return true if running
+     */
+    bool isRunning() const { return m_running; }
+    /**
+     * Perform a sampling round
+     * @param[out] round result
+     * @return true if at least one clock was sampled
+     * @note Start the sampling threads, if they are not running.
+     */
+    bool sampleRound(PhcRound_t &round);
+};
+
+__PTPMGMT_NAMESPACE_END
+
+#endif /* __PTPMGMT_PHC_SAMPLER_H */
@@ -0,0 +1,210 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Discipline a PHC using a pulse per second input
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * @details
+ *  Configure a PHC pin to time stamp an external pulse per second,
+ *  like a GNSS receiver 1PPS output, and synchronize the PHC to it.
+ */
+
+#ifndef __PTPMGMT_PPS_H
+#define __PTPMGMT_PPS_H
+
+#include "servo.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+/**
+ * Pulse per second discipline status
+ */
+struct PpsStatus_t {
+    servoState_e servo; /**< Last servo state */
+    /** Last phase error from the second boundary in nanoseconds */
+    int64_t offset;
+    float_freq freq; /**< Frequency set on the clock in ppb */
+    Timestamp_t time; /**< PHC time of the last accepted edge */
+    /** PHC time from the last accepted edge to the clock adjustment */
+    int64_t latency;
+    uint64_t events; /**< Number of edges read from the PHC */
+    uint64_t rejected; /**< Number of edges rejected as outliers */
+};
+
+/**
+ * @brief Pulse per second discipline call-back
+ * @note Called from the discipline thread
+ */
+class PpsCallback
+{
+  public:
+    virtual ~PpsCallback() {}
+    /**
+     * Called after each accepted edge
+     * @param[in] status current status
+     */
+    virtual void update(const PpsStatus_t &status) {}
+};
+
+/**
+ * @brief Synchronize a PHC to a pulse per second input
+ * @details
+ *  The pipeline configures the pin to external time stamp,
+ *  enables the time stamp channel and waits for the edges.
+ *  Each edge time stamp is checked and the phase error from the
+ *  nearest second boundary is provided to the servo.
+ *  An edge is rejected if its distance from the previous edge is
+ *  not a whole number of seconds, or if its phase error is far
+ *  from the median of the recent phase errors.
+ *  The thread waits on the PHC file with poll(), the clock is adjusted
+ *  as soon as the kernel queues the edge time stamp.
+ * @note The PHC must be opened for write.
+ */
+class PpsDiscipline
+{
+  private:
+    class Loop;
+    std::unique_ptr<Loop> m_loop;
+    std::unique_ptr<Servo> m_servo;
+    const PtpClock *m_clk;
+    PpsCallback *m_cb;
+    PpsStatus_t m_status;
+    std::vector<int64_t> m_window; /* recent accepted phase errors */
+    Timestamp_t m_last; /* last accepted edge */
+    int64_t m_outlier;
+    int64_t m_tolerance;
+    size_t m_filterSize;
+    size_t m_rejects; /* consecutive rejected edges */
+    int m_pin;
+    unsigned int m_channel;
+    uint8_t m_edges;
+    int m_priority;
+    int m_cpu;
+    bool m_haveLast;
+    bool m_primed;
+    bool accept(const Timestamp_t &time, int64_t offset);
+    void restart();
+
+  public:
+    PpsDiscipline();
+    ~PpsDiscipline();
+    /**
+     * Set the PHC to discipline
+     * @param[in] clk PHC, opened for write
+     * @return true for success
+     * @note The discipline does not own the clock,
+     *       the caller must keep it while the discipline uses it.
+     */
+    bool setClock(const PtpClock *clk);
+    /**
+     * Set the pin and the external time stamp channel
+     * @param[in] pin pin index, negative to keep the pin configuration
+     * @param[in] channel external time stamp channel
+     * @return true for success
+     * @note Drivers with fixed pin functions do not support the pin
+     *       configuration, use a negative pin index with them.
+     */
+    bool setPin(int pin, unsigned int channel);
+    /**
+     * Set the time stamped edges
+     * @param[in] edges PTP_EXTERN_TS_RISING_EDGE or PTP_EXTERN_TS_FALLING_EDGE
+     * @return true for success
+     * @note Default is the rising edge
+     */
+    bool setEdge(uint8_t edges);
+    /**
+     * Set servo
+     * @param[in] servo to use
+     * @return true for success
+     * @note The discipline takes ownership of the servo object.
+     * @note Default servo is the PI servo
+     */
+    bool setServo(Servo *servo);
+    /**
+     * Get servo
+     * @return servo in use
+     */
+    Servo &getServo() { return *m_servo; }
+    /**
+     * Set outlier filter
+     * @param[in] size number of recent phase errors to use for the median,
+     *            zero disable the filter
+     * @param[in] threshold maximum distance from the median in nanoseconds
+     * @return true for success
+     * @note The filter is used while the servo is locked.
+     *       After a full window of consecutive rejected edges,
+     *       the discipline assumes the source moved and starts over.
+     */
+    bool setFilter(size_t size, int64_t threshold);
+    /**
+     * Set the tolerance of the distance between two edges
+     * @param[in] tolerance in nanoseconds
+     * @return true for success
+     * @note The distance between two edges should be a whole number
+     *       of seconds, default tolerance is 1 millisecond.
+     */
+    bool setTolerance(int64_t tolerance);
+    /**
+     * Set the discipline thread real-time priority
+     * @param[in] priority SCHED_FIFO priority, zero for normal thread
+     * @return true for success
+     */
+    bool setPriority(int priority);
+    /**
+     * Set the CPU core to pin the discipline thread on
+     * @param[in] cpu CPU core, negative for no pinning
+     * @return true for success
+     */
+    bool setCpu(int cpu);
+    /**
+     * Set call-back
+     * @param[in] cb call-back object or null to remove
+     */
+    void setCallback(PpsCallback *cb) { m_cb = cb; }
+    /**
+     * Configure the pin and enable the external time stamp channel
+     * @return true for success
+     * @note start() calls it
+     */
+    bool enable();
+    /**
+     * Disable the external time stamp channel
+     * @return true for success
+     * @note stop() calls it
+     */
+    bool disable();
+    /**
+     * Process an edge
+     * @param[in] event external time stamp event
+     * @return true if the edge was accepted and the clock adjusted
+     * @note Use it with PtpClock::readEvents() from the application loop.
+     *       Do not call while the discipline thread is running.
+     */
+    bool process(const PtpEvent_t &event);
+    /**
+     * Enable the channel and start the discipline thread
+     * @return true for success
+     */
+    bool start();
+    /**
+     * Stop discipline thread and disable the channel
+     */
+    void stop();
+    /**
+     * Query if discipline thread is running
+     * @return true if running
+     */
+    bool isRunning() const;
+    /**
+     * Get discipline status
+     * @return status
+     */
+    PpsStatus_t getStatus() const;
+};
+
+__PTPMGMT_NAMESPACE_END
+
+#endif /* __PTPMGMT_PPS_H */
@@ -38,6 +38,10 @@ typedef long double float_freq;
 
 /**
  * @brief Network interface information
+ * @note The information is taken from a process wide interfaces cache,
+ *       populated using rtnetlink and kept current by the kernel link
+ *       notifications. If the cache is not available, the class
+ *       uses the interface ioctls.
  */
 class IfInfo
 {
@@ -0,0 +1,413 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Clock servos and in-process clock discipline
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * @details
+ *  Servos calculate the frequency adjustment of a clock
+ *  from the measured offsets to a source clock.
+ *  The clock discipline uses a servo to synchronize a clock
+ *  to a source clock from a dedicated thread in the application process.
+ */
+
+#ifndef __PTPMGMT_SERVO_H
+#define __PTPMGMT_SERVO_H
+
+#include <memory>
+#include "ptp.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+/**
+ * @brief Base class for clock servos
+ * @details
+ *  The servo follows the LinuxPTP servo states.
+ *  Offset is the clock time minus the source clock time.
+ *  On SERVO_JUMP state, the caller should step the clock by
+ *  the minus of the offset.
+ */
+class Servo
+{
+  private:
+    int64_t m_stepThreshold;
+    int64_t m_firstStepThreshold;
+    int64_t m_stableThreshold;
+    size_t m_stableNum;
+    size_t m_stableCount;
+    bool m_firstUpdate;
+
+  protected:
+    /** @cond internal */
+    float_freq m_maxFreq; /**< Maximum frequency adjustment in ppb */
+    float_seconds m_interval; /**< Sync interval in seconds */
+    /**
+     * Check if offset need a clock step
+     * @param[in] offset clock offset in nanoseconds
+     * @return true if clock need a step
+     */
+    bool needStep(int64_t offset) const;
+    /**
+     * Check if servo should discard its history, as offset is too big
+     * @param[in] offset clock offset in nanoseconds
+     * @return true if offset pass step threshold
+     */
+    bool passStep(int64_t offset) const;
+    /**
+     * Limit frequency to maximum frequency adjustment
+     * @param[in] freq frequency in ppb
+     * @return limited frequency
+     */
+    float_freq clamp(float_freq freq) const;
+    /**
+     * Servo algorithm
+     * @param[in] offset clock offset in nanoseconds
+     * @param[in] localTs local time stamp in nanoseconds
+     * @param[out] state servo state
+     * @return frequency to set on clock in ppb
+     */
+    virtual float_freq doSample(int64_t offset, uint64_t localTs,
+        servoState_e &state) = 0;
+    /**
+     * Servo reset algorithm
+     */
+    virtual void doReset() = 0;
+    /**
+     * Called when sync interval is changed
+     */
+    virtual void doSyncInterval() {}
+    Servo();
+    /**< @endcond */
+
+  public:
+    virtual ~Servo() {}
+    /**
+     * Provide a new offset sample to the servo
+     * @param[in] offset clock offset in nanoseconds
+     * @param[in] localTs local time stamp of the sample in nanoseconds
+     * @param[out] state servo state
+     * @return frequency to set on the clock in ppb
+     */
+    float_freq sample(int64_t offset, uint64_t localTs, servoState_e &state);
+    /**
+     * Reset the servo, drop all samples
+     */
+    void reset();
+    /**
+     * Set frequency the clock currently uses
+     * @param[in] freq frequency in ppb
+     * @note Call before the first sample
+     */
+    virtual void setFreq(float_freq freq) = 0;
+    /**
+     * Set sync interval
+     * @param[in] interval in seconds
+     * @return true for success
+     */
+    bool syncInterval(float_seconds interval);
+    /**
+     * Get sync interval
+     * @return interval in seconds
+     */
+    float_seconds getSyncInterval() const { return m_interval; }
+    /**
+     * Set maximum frequency adjustment
+     * @param[in] maxFreq maximum frequency in ppb
+     * @return true for success
+     */
+    bool setMaxFreq(float_freq maxFreq);
+    /**
+     * Get maximum frequency adjustment
+     * @return maximum frequency in ppb
+     */
+    float_freq getMaxFreq() const { return m_maxFreq; }
+    /**
+     * Set step threshold
+     * @param[in] threshold in nanoseconds, zero disable steps
+     */
+    void setStepThreshold(int64_t threshold) { m_stepThreshold = threshold; }
+    /**
+     * Set first step threshold
+     * @param[in] threshold in nanoseconds, zero disable first step
+     * @note default is 20 microseconds, like LinuxPTP
+     */
+    void setFirstStepThreshold(int64_t threshold) {
+        m_firstStepThreshold = threshold;
+    }
+    /**
+     * Set stable threshold
+     * @param[in] threshold in nanoseconds
+     * @param[in] num number of consecutive offsets
+     * @note servo state is SERVO_LOCKED_STABLE, when the last num offsets
+     *       are lower than threshold. Zero num disable.
+     */
+    void setStableThreshold(int64_t threshold, size_t num);
+};
+
+/**
+ * @brief Proportional integral servo
+ * @details Follow LinuxPTP PI servo
+ */
+class PiServo : public Servo
+{
+  private:
+    int64_t m_offset[2];
+    uint64_t m_local[2];
+    float_freq m_drift;
+    float_freq m_kp, m_ki;
+    float_freq m_kpConst, m_kiConst;
+    int m_count;
+
+  protected:
+    /** @cond internal */
+    float_freq doSample(int64_t offset, uint64_t localTs,
+        servoState_e &state) override;
+    void doReset() override;
+    void doSyncInterval() override;
+    /**< @endcond */
+
+  public:
+    PiServo();
+    void setFreq(float_freq freq) override;
+    /**
+     * Set constant proportional and integral constants
+     * @param[in] kp proportional constant
+     * @param[in] ki integral constant
+     * @return true for success
+     * @note Use zero to calculate constants from the sync interval,
+     *       using LinuxPTP hardware time stamps default
+     */
+    bool setConstants(float_freq kp, float_freq ki);
+    /**
+     * Get proportional constant in use
+     * @return proportional constant
+     */
+    float_freq getKp() const { return m_kp; }
+    /**
+     * Get integral constant in use
+     * @return integral constant
+     */
+    float_freq getKi() const { return m_ki; }
+};
+
+/**
+ * @brief Linear regression servo
+ * @details
+ *  The servo estimates the clock drift and offset, using an ordinary
+ *  least squares linear regression of the clock free running offset.
+ *  The servo chooses the regression size with the smallest prediction error.
+ */
+class LinRegServo : public Servo
+{
+  private:
+    struct point_t {
+        float_seconds x; /* local time from base */
+        float_nanoseconds y; /* free running offset */
+    };
+    static const size_t MAX_POINTS = 64;
+    static const size_t NUM_SIZES = 5; /* 4, 8, 16, 32, 64 */
+    point_t m_points[MAX_POINTS];
+    size_t m_numPoints, m_lastPoint;
+    long double m_err[NUM_SIZES];
+    uint64_t m_base, m_last;
+    float_nanoseconds m_corr; /* Phase we correct by frequency */
+    float_freq m_freq;
+    size_t m_horizon;
+    int m_count;
+    bool regress(size_t size, float_freq &slope, float_nanoseconds &yhat,
+        float_seconds x) const;
+    void clearPoints();
+
+  protected:
+    /** @cond internal */
+    float_freq doSample(int64_t offset, uint64_t localTs,
+        servoState_e &state) override;
+    void doReset() override;
+    /**< @endcond */
+
+  public:
+    LinRegServo();
+    void setFreq(float_freq freq) override;
+    /**
+     * Set correction horizon
+     * @param[in] intervals number of sync intervals to correct the offset
+     * @return true for success
+     */
+    bool setHorizon(size_t intervals);
+};
+
+/**
+ * Clock discipline state
+ */
+enum DisciplineState_e {
+    DISCIPLINE_UNLOCKED, /**< Clock is not synchronized */
+    DISCIPLINE_LOCKED, /**< Servo tracks the source clock */
+    /** Source clock measurement fails, clock keeps last frequency */
+    DISCIPLINE_HOLDOVER,
+};
+
+/**
+ * Clock discipline status
+ */
+struct DisciplineStatus_t {
+    DisciplineState_e state; /**< Discipline state */
+    servoState_e servo; /**< Last servo state */
+    int64_t offset; /**< Last measured offset in nanoseconds */
+    int64_t delay; /**< Last measurement delay in nanoseconds */
+    float_freq freq; /**< Frequency set on the clock in ppb */
+    uint64_t updates; /**< Number of successful updates */
+    Timestamp_t time; /**< System time of the last measurement */
+};
+
+/**
+ * @brief Clock discipline call-back
+ * @note Called from the discipline thread
+ */
+class DisciplineCallback
+{
+  public:
+    virtual ~DisciplineCallback() {}
+    /**
+     * Discipline state changed
+     * @param[in] status current status
+     */
+    virtual void stateChange(const DisciplineStatus_t &status) {}
+    /**
+     * Called after each update
+     * @param[in] status current status
+     */
+    virtual void update(const DisciplineStatus_t &status) {}
+};
+
+/**
+ * @brief Synchronize a clock to a source clock
+ * @details
+ *  Measure the offset between the clocks, using the PHC system offset
+ *  sampling, and steer the clock with the servo.
+ *  When both clocks are PHCs, the offset is measured through the
+ *  system clock.
+ *  The discipline can run on a dedicated real-time thread or
+ *  the application can call update() from its own loop.
+ */
+class ClockDiscipline
+{
+  private:
+    class Loop;
+    std::unique_ptr<Loop> m_loop;
+    std::unique_ptr<Servo> m_servo;
+    SysClock m_sys;
+    const PtpClock *m_target;
+    const PtpClock *m_source;
+    DisciplineCallback *m_cb;
+    DisciplineStatus_t m_status;
+    float_seconds m_interval;
+    float_seconds m_holdover;
+    size_t m_samples;
+    int m_priority;
+    int m_cpu;
+    bool m_init;
+    bool measure(int64_t &offset, int64_t &delay, Timestamp_t &ts);
+    const BaseClock &target() const;
+    void setState(DisciplineState_e state);
+
+  public:
+    ClockDiscipline();
+    ~ClockDiscipline();
+    /**
+     * Set clocks
+     * @param[in] target clock to synchronize, null for the system clock
+     * @param[in] source clock to synchronize to, null for the system clock
+     * @return true for success
+     * @note The discipline do not own the clocks,
+     *       the caller must keep them while the discipline uses them.
+     */
+    bool setClocks(const PtpClock *target, const PtpClock *source);
+    /**
+     * Set servo
+     * @param[in] servo to use
+     * @return true for success
+     * @note The discipline takes ownership of the servo object.
+     * @note Default servo is the PI servo
+     */
+    bool setServo(Servo *servo);
+    /**
+     * Get servo
+     * @return servo in use
+     */
+    Servo &getServo() { return *m_servo; }
+    /**
+     * Set update interval
+     * @param[in] interval in seconds
+     * @return true for success
+     */
+    bool setInterval(float_seconds interval);
+    /**
+     * Get update interval
+     * @return interval in seconds
+     */
+    float_seconds getInterval() const { return m_interval; }
+    /**
+     * Set maximum holdover time
+     * @param[in] holdover in seconds
+     * @return true for success
+     * @note After holdover, the discipline state is unlocked
+     *       and the servo is reset.
+     */
+    bool setHoldover(float_seconds holdover);
+    /**
+     * Set number of PHC samples per measurement
+     * @param[in] samples number of samples, up to 25
+     * @return true for success
+     */
+    bool setSamples(size_t samples);
+    /**
+     * Set the discipline thread real-time priority
+     * @param[in] priority SCHED_FIFO priority, zero for normal thread
+     * @return true for success
+     */
+    bool setPriority(int priority);
+    /**
+     * Set the CPU core to pin the discipline thread on
+     * @param[in] cpu CPU core, negative for no pinning
+     * @return true for success
+     */
+    bool setCpu(int cpu);
+    /**
+     * Set call-back
+     * @param[in] cb call-back object or null to remove
+     */
+    void setCallback(DisciplineCallback *cb) { m_cb = cb; }
+    /**
+     * Perform a single update
+     * @return true if the clock was measured and updated
+     * @note Do not call while the discipline thread is running
+     */
+    bool update();
+    /**
+     * Start discipline thread
+     * @return true for success
+     */
+    bool start();
+    /**
+     * Stop discipline thread
+     */
+    void stop();
+    /**
+     * Query if discipline thread is running
+     * @return true if running
+     */
+    bool isRunning() const;
+    /**
+     * Get discipline status
+     * @return status
+     * @note The status is updated by the discipline thread
+     */
+    DisciplineStatus_t getStatus() const;
+};
+
+__PTPMGMT_NAMESPACE_END
+
+#endif /* __PTPMGMT_SERVO_H */
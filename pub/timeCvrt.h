@@ -7,15 +7,25 @@
  * @author Erez Geva <ErezGeva2@@gmail.com>
  * @copyright © 2021 Erez Geva
  *
+ * @details
+ *  Time conversion constants and batch conversion of clock times
+ *  to nanoseconds.
  */
 
 #ifndef __PTPMGMT_TIME_COMVERT_H
 #define __PTPMGMT_TIME_COMVERT_H
 
+#include <cstddef>
+#include <cstdint>
 #include "name.h"
 
+/* Linux kernel PTP clock time structure, see linux/ptp_clock.h */
+struct ptp_clock_time;
+
 __PTPMGMT_NAMESPACE_BEGIN
 
+struct Timestamp_t;
+
 /** Number of nanoseconds in a microsecond */
 const int32_t NSEC_PER_USEC = 1000;
 /** Number of nanoseconds in a millisecond */
@@ -29,6 +39,45 @@ const int32_t USEC_PER_SEC = 1000000;
 /** Number of millisecond in a second */
 const int32_t MSEC_PER_SEC = 1000;
 
+#ifndef SWIG /* Scripts use the Timestamp_t methods */
+/**
+ * Convert clock times to nanoseconds
+ * @param[in] ts array of clock times
+ * @param[out] ns array of nanoseconds
+ * @param[in] num number of elements in the arrays
+ * @note The batch functions use integer arithmetic only and
+ *       are built for the compiler to vectorize the loops.
+ */
+void timeToNanoseconds(const Timestamp_t *ts, int64_t *ns, size_t num);
+/**
+ * Convert Linux PTP clock times to nanoseconds
+ * @param[in] ts array of clock times
+ * @param[out] ns array of nanoseconds
+ * @param[in] num number of elements in the arrays
+ */
+void timeToNanoseconds(const ptp_clock_time *ts, int64_t *ns, size_t num);
+/**
+ * Calculate differences between clock times in nanoseconds
+ * @param[in] a array of clock times
+ * @param[in] b array of clock times to subtract
+ * @param[out] diff array of a minus b in nanoseconds
+ * @param[in] num number of elements in the arrays
+ */
+void timeDiffNanoseconds(const Timestamp_t *a, const Timestamp_t *b,
+    int64_t *diff, size_t num);
+/**
+ * Calculate differences between Linux PTP clock times in nanoseconds
+ * @param[in] a array of clock times
+ * @param[in] b array of clock times to subtract
+ * @param[out] diff array of a minus b in nanoseconds
+ * @param[in] num number of elements in the arrays
+ * @note PTP_SYS_OFFSET interleaves the system and the PHC times,
+ *       use timeToNanoseconds() and subtract the elements.
+ */
+void timeDiffNanoseconds(const ptp_clock_time *a, const ptp_clock_time *b,
+    int64_t *diff, size_t num);
+#endif /* SWIG */
+
 __PTPMGMT_NAMESPACE_END
 
 #endif /* __PTPMGMT_TIME_COMVERT_H */
@@ -191,6 +191,14 @@ autoconf
 %files -n pmc-%{bname}
 %{_sbindir}/pmc-%{bname}
 %{_mandir}/man8/pmc-%{bname}.8*
+%{_sbindir}/ptp_pcap-%{bname}
+%{_mandir}/man8/ptp_pcap-%{bname}.8*
+%{_sbindir}/ptp_exporter-%{bname}
+%{_mandir}/man8/ptp_exporter-%{bname}.8*
+%{_sbindir}/ptp_responder-%{bname}
+%{_mandir}/man8/ptp_responder-%{bname}.8*
+%{_sbindir}/ptp_checksync-%{bname}
+%{_mandir}/man8/ptp_checksync-%{bname}.8*
 
 %files -n phc-ctl-%{bname}
 %{_sbindir}/phc_ctl-%{bname}
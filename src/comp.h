@@ -213,9 +213,12 @@ struct MsgProc {
     MNG_PARSE_ERROR_e call_tlv_data(mng_vals_e id, BaseMngTlv *&tlv);
     MNG_PARSE_ERROR_e parseSig();
 
-#define _ptpmCaseUF(n) bool n##_f(n##_t &data);
+#define _ptpmCaseUF(n) template<typename T = void> bool n##_f(n##_t &data);
+#define _ptpmCaseTUF(n) _ptpmCaseUF(n)
 #define A(n, v, sc, a, sz, f) _ptpmCase##f(n)
-    /* Per tlv ID call-back for parse or build or both */
+    /* Per tlv ID call-back for parse or build or both
+     * Call-backs are templates, so only IDs that are part of the build
+     *  are instantiated */
 #include "ids.h"
     /* Parse functions for signalling messages */
 #define _ptpmParseFunc(n) bool n##_f(n##_t &data)
@@ -44,6 +44,21 @@ dnl
 #ifndef _ptpmCaseUFBS
 #define _ptpmCaseUFBS(n) _ptpmCaseUFB(n)
 #endif
+#ifndef _ptpmCaseTNA
+#define _ptpmCaseTNA(n)
+#endif
+#ifndef _ptpmCaseTUF
+#define _ptpmCaseTUF(n)
+#endif
+#ifndef _ptpmCaseTUFS
+#define _ptpmCaseTUFS(n) _ptpmCaseTUF(n)
+#endif
+#ifndef _ptpmCaseTUFB
+#define _ptpmCaseTUFB(n) _ptpmCaseTUF(n)
+#endif
+#ifndef _ptpmCaseTUFBS
+#define _ptpmCaseTUFBS(n) _ptpmCaseTUFB(n)
+#endif
 /*
  * For functions use
  * #define _ptpmCaseXX(n)    <macro text>
@@ -52,17 +67,33 @@ dnl
  * UFS  - function for parsing having variable size
  * UFB  - function for parsing and build
  * UFBS - function for parsing and build having variable size
+ * TXX  - ID is left out of this build, XX is the original function type
  */
 /*
  * size: > 0  fixed size dataField
  *         0  No dataField (with NA)
+ *        -1  TLV is not part of this build
  *        -2  Variable length dataField, need calculation
  */
-/*Name                                 value scope  allow       size   func*/
-include(ids_base.m4)dnl
+dnl Build with a subset of the management IDs:
+dnl  m4 -D mng_ids -D mng_id_<ID> ...
+dnl IDs not in the list are marked with no allowed actions, size -1
+dnl  and a 'T' prefix on the function type.
+dnl NULL_PTP_MANAGEMENT is always part of the build.
+define(`_ptpmKeep', `ifelse(ifdef(`mng_ids', `1'), `', `1',
+  $1, `NULL_PTP_MANAGEMENT', `1', `ifdef(`mng_id_$1', `1')')')dnl
+define(`A', `ifelse(_ptpmKeep($1), `1', ``A'($1, $2, $3, $4, $5, $6)',
+  ``A'($1, $2, $3, 0, -1, T$6)')')dnl
+/*Name, value, scope, allow, size, func*/
+include(ids_base.m4)undefine(`A')dnl
 #undef A
 #undef _ptpmCaseNA
 #undef _ptpmCaseUF
 #undef _ptpmCaseUFS
 #undef _ptpmCaseUFB
 #undef _ptpmCaseUFBS
+#undef _ptpmCaseTNA
+#undef _ptpmCaseTUF
+#undef _ptpmCaseTUFS
+#undef _ptpmCaseTUFB
+#undef _ptpmCaseTUFBS
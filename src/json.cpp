@@ -533,28 +533,43 @@ struct JsonProcToJson : public JsonProc {
     std::stack<bool> m_first_vals;
     int m_base_indent;
     bool m_first;
+    bool m_compact; // Negative indent, single line without spaces
     JsonProcToJson(const Message &msg, int indent);
     JsonProcToJson(mng_vals_e managementId, const BaseMngTlv *data, int indent);
     bool data2json(mng_vals_e managementId, const BaseMngTlv *data,
         bool header = true);
     bool smpte2json(SMPTE_ORGANIZATION_EXTENSION_t *data);
     void sig2json(tlvType_e tlvType, const BaseSigTlv *tlv);
+    void newLine() {
+        if(!m_compact)
+            m_result += '\n';
+    }
     void close() {
         if(!m_first)
             m_result += ',';
-        m_result += '\n';
+        newLine();
         m_first = false;
     }
     void indent() {
-        m_result += std::string(m_first_vals.size() * 2 + m_base_indent, ' ');
+        if(!m_compact)
+            m_result += std::string(m_first_vals.size() * 2 + m_base_indent, ' ');
     }
     void startName(const char *name, const char *end) {
         close();
         indent();
         m_result += '"';
         m_result += name;
-        m_result += "\" :";
-        m_result += end;
+        if(m_compact) {
+            m_result += "\":";
+            // Drop the spaces and the line end, keep the string quote
+            for(; *end != 0; end++) {
+                if(*end == '"')
+                    m_result += '"';
+            }
+        } else {
+            m_result += "\" :";
+            m_result += end;
+        }
     }
     void startObject() {
         indent();
@@ -563,7 +578,7 @@ struct JsonProcToJson : public JsonProc {
         m_first = true;
     }
     void closeObject() {
-        m_result += '\n';
+        newLine();
         m_first = m_first_vals.top();
         m_first_vals.pop();
         indent();
@@ -580,7 +595,7 @@ struct JsonProcToJson : public JsonProc {
         m_first = true;
     }
     void closeArray() {
-        m_result += '\n';
+        newLine();
         m_first = m_first_vals.top();
         m_first_vals.pop();
         indent();
@@ -979,7 +994,7 @@ bool JsonProcToJson::smpte2json(SMPTE_ORGANIZATION_EXTENSION_t *data)
 }
 
 JsonProcToJson::JsonProcToJson(const Message &msg, int indent) :
-    m_base_indent(indent), m_first(false)
+    m_base_indent(indent), m_first(false), m_compact(indent < 0)
 {
     startObject();
     procValue("sequenceId", msg.getSequence());
@@ -1034,7 +1049,7 @@ JsonProcToJson::JsonProcToJson(const Message &msg, int indent) :
 }
 
 JsonProcToJson::JsonProcToJson(mng_vals_e managementId, const BaseMngTlv *tlv,
-    int indent) : m_base_indent(indent), m_first(false)
+    int indent) : m_base_indent(indent), m_first(false), m_compact(indent < 0)
 {
     data2json(managementId, tlv, false);
 }
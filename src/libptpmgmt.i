@@ -212,6 +212,7 @@ _ptpmMkRecVec(SigDelay, SLAVE_DELAY_TIMING_DATA_NP);
  *  Doxygen generated documents
  */
 #define _ptpmCaseUF(n) %pointer_cast(BaseMngTlv*, n##_t*, conv_##n);
+#define _ptpmCaseTUF(n) _ptpmCaseUF(n)
 #define A(n, v, sc, a, sz, f) _ptpmCase##f(n)
 %include "ids.h"
 /* convert base signaling tlv to a specific signaling tlv structure
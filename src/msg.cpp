@@ -156,12 +156,19 @@ bool Message::checkReplyAction(uint8_t actionField)
 }
 bool Message::allowedAction(mng_vals_e id, actionField_e action)
 {
+    uint8_t mask;
     switch(action) {
         case GET:
-            break;
         case SET:
-            break;
         case COMMAND:
+            mask = 1 << action;
+            break;
+        // A responder replies to the requests
+        case RESPONSE:
+            mask = A_GET | A_SET;
+            break;
+        case ACKNOWLEDGE:
+            mask = A_COMMAND;
             break;
         default:
             return false;
@@ -171,7 +178,7 @@ bool Message::allowedAction(mng_vals_e id, actionField_e action)
     if(m_prms.implementSpecific != linuxptp &&
         mng_all_vals[id].allowed & A_USE_LINUXPTP)
         return false;
-    return mng_all_vals[id].allowed & (1 << action);
+    return mng_all_vals[id].allowed & mask;
 }
 Message::Message() :
     m_sendAction(GET),
@@ -239,10 +246,18 @@ bool Message::isEmpty(mng_vals_e id)
 {
     return id >= FIRST_MNG_ID && id < LAST_MNG_ID && mng_all_vals[id].size == 0;
 }
+bool Message::isPortScope(mng_vals_e id)
+{
+    return id >= FIRST_MNG_ID && id < LAST_MNG_ID &&
+        mng_all_vals[id].scope == s_port;
+}
 bool Message::isValidId(mng_vals_e id)
 {
     if(id < FIRST_MNG_ID || id >= LAST_MNG_ID)
         return false;
+    // ID is not part of this build
+    if(mng_all_vals[id].size == -1)
+        return false;
     if(m_prms.implementSpecific != linuxptp &&
         mng_all_vals[id].allowed & A_USE_LINUXPTP)
         return false;
@@ -412,8 +427,10 @@ MNG_PARSE_ERROR_e Message::parse(const void *buf, ssize_t msgSize)
     }
     // Management message part
     uint8_t actionField = 0xf & msg->actionField;
+    bool request = actionField == GET || actionField == SET ||
+        actionField == COMMAND;
     if(actionField != RESPONSE && actionField != ACKNOWLEDGE &&
-        actionField != COMMAND)
+        actionField != COMMAND && !(request && m_prms.rcvRequests))
         return MNG_PARSE_ERROR_ACTION;
     uint16_t *cur = (uint16_t *)(msg + 1);
     uint16_t tlvType = net_to_cpu16(*cur++);
@@ -451,7 +468,10 @@ MNG_PARSE_ERROR_e Message::parse(const void *buf, ssize_t msgSize)
                 return MNG_PARSE_ERROR_TOO_SMALL;
             return MNG_PARSE_ERROR_MSG;
         case MANAGEMENT:
-            if(actionField != RESPONSE && actionField != ACKNOWLEDGE)
+            if(request) {
+                if(!m_prms.rcvRequests)
+                    return MNG_PARSE_ERROR_ACTION;
+            } else if(actionField != RESPONSE && actionField != ACKNOWLEDGE)
                 return MNG_PARSE_ERROR_ACTION;
             m_replyAction = (actionField_e)actionField;
             if(size < (ssize_t)sizeof tlvType)
@@ -460,12 +480,18 @@ MNG_PARSE_ERROR_e Message::parse(const void *buf, ssize_t msgSize)
             // managementId
             if(!findTlvId(*cur++, m_replayTlv_id, m_prms.implementSpecific))
                 return MNG_PARSE_ERROR_INVALID_ID;
-            if(!checkReplyAction(actionField))
+            if(request ? !allowedAction(m_replayTlv_id,
+                    (actionField_e)actionField) : !checkReplyAction(actionField))
                 return MNG_PARSE_ERROR_ACTION;
             // Check minimum size and even
             if(mp.m_left < lengthFieldMngBase || mp.m_left & 1)
                 return MNG_PARSE_ERROR_TOO_SMALL;
             mp.m_left -= lengthFieldMngBase;
+            // The dataField of a GET request is empty or zero
+            if(actionField == GET) {
+                m_dataGet.reset();
+                return MNG_PARSE_ERROR_OK;
+            }
             if(mp.m_left == 0)
                 return MNG_PARSE_ERROR_OK;
             mp.m_cur = (uint8_t *)cur;
@@ -1117,13 +1143,15 @@ float_seconds Timestamp_t::toFloat() const
 }
 void Timestamp_t::fromNanoseconds(uint64_t nanoseconds)
 {
-    lldiv_t d = lldiv((long long)nanoseconds, (long long)NSEC_PER_SEC);
-    while(d.rem < 0) {
-        d.quot--;
-        d.rem += NSEC_PER_SEC;
-    };
-    secondsField = d.quot;
-    nanosecondsField = d.rem;
+    int64_t ns = (int64_t)nanoseconds;
+    int64_t secs = ns / NSEC_PER_SEC;
+    ns %= NSEC_PER_SEC;
+    if(ns < 0) {
+        ns += NSEC_PER_SEC;
+        secs--;
+    }
+    secondsField = secs;
+    nanosecondsField = ns;
 }
 uint64_t Timestamp_t::toNanoseconds() const
 {
@@ -1157,17 +1185,19 @@ bool Timestamp_t::less(float_seconds seconds) const
 }
 Timestamp_t &normNano(Timestamp_t *ts)
 {
-    while(ts->nanosecondsField >= NSEC_PER_SEC) {
-        ts->nanosecondsField -= NSEC_PER_SEC;
-        ts->secondsField++;
+    if(ts->nanosecondsField >= NSEC_PER_SEC) {
+        ts->secondsField += ts->nanosecondsField / NSEC_PER_SEC;
+        ts->nanosecondsField %= NSEC_PER_SEC;
     }
     return *ts;
 }
 Timestamp_t &Timestamp_t::add(const Timestamp_t &ts)
 {
-    secondsField += ts.secondsField;
-    nanosecondsField += ts.nanosecondsField;
-    return normNano(this);
+    // Use 64 bits, so the nanoseconds sum can not overflow
+    uint64_t nsec = (uint64_t)nanosecondsField + ts.nanosecondsField;
+    secondsField += ts.secondsField + nsec / NSEC_PER_SEC;
+    nanosecondsField = nsec % NSEC_PER_SEC;
+    return *this;
 }
 Timestamp_t &Timestamp_t::add(float_seconds seconds)
 {
@@ -1178,13 +1208,34 @@ Timestamp_t &Timestamp_t::add(float_seconds seconds)
 }
 Timestamp_t &Timestamp_t::subt(const Timestamp_t &ts)
 {
-    secondsField -= ts.secondsField;
-    while(nanosecondsField < ts.nanosecondsField) {
-        nanosecondsField += NSEC_PER_SEC;
-        secondsField--;
-    }
-    nanosecondsField -= ts.nanosecondsField;
-    return normNano(this);
+    int64_t nsec = (int64_t)nanosecondsField - (int64_t)ts.nanosecondsField;
+    int64_t secs = nsec / NSEC_PER_SEC;
+    nsec %= NSEC_PER_SEC;
+    if(nsec < 0) {
+        nsec += NSEC_PER_SEC;
+        secs--;
+    }
+    secondsField += secs - ts.secondsField;
+    nanosecondsField = nsec;
+    return *this;
+}
+Timestamp_t &Timestamp_t::addNanoseconds(int64_t nanoseconds)
+{
+    int64_t secs = nanoseconds / NSEC_PER_SEC;
+    int64_t nsec = nanoseconds % NSEC_PER_SEC +
+        nanosecondsField % NSEC_PER_SEC;
+    secs += nanosecondsField / NSEC_PER_SEC;
+    // nsec is in range (-NSEC_PER_SEC, 2 * NSEC_PER_SEC)
+    if(nsec < 0) {
+        nsec += NSEC_PER_SEC;
+        secs--;
+    } else if(nsec >= NSEC_PER_SEC) {
+        nsec -= NSEC_PER_SEC;
+        secs++;
+    }
+    secondsField += secs;
+    nanosecondsField = nsec;
+    return *this;
 }
 std::string ClockIdentity_t::string() const
 {
@@ -1239,7 +1290,8 @@ MsgParams::MsgParams() :
     useZeroGet(true),
     rcvSignaling(false),
     filterSignaling(true),
-    rcvSMPTEOrg(true)
+    rcvSMPTEOrg(true),
+    rcvRequests(false)
 {
 }
 
@@ -1276,6 +1328,7 @@ extern "C" {
         r.rcvSignaling = p->rcvSignaling;
         r.filterSignaling = p->filterSignaling;
         r.rcvSMPTEOrg = p->rcvSMPTEOrg;
+        r.rcvRequests = p->rcvRequests;
         r.implementSpecific = (implementSpecific_e)p->implementSpecific;
         memcpy(r.target.clockIdentity.v, p->target.clockIdentity.v,
             ClockIdentity_t::size());
@@ -1296,6 +1349,7 @@ extern "C" {
         p->rcvSignaling = r.rcvSignaling;
         p->filterSignaling = r.filterSignaling;
         p->rcvSMPTEOrg = r.rcvSMPTEOrg;
+        p->rcvRequests = r.rcvRequests;
         p->implementSpecific = (ptpmgmt_implementSpecific_e)r.implementSpecific;
         memcpy(p->target.clockIdentity.v, r.target.clockIdentity.v,
             ClockIdentity_t::size());
@@ -1572,6 +1626,10 @@ extern "C" {
     {
         C2CPP_ret_c1(isEmpty, mng_vals_e, id);
     }
+    bool ptpmgmt_msg_isPortScope(ptpmgmt_mng_vals_e id)
+    {
+        C2CPP_ret_c1(isPortScope, mng_vals_e, id);
+    }
     static bool ptpmgmt_msg_isValidId(const_ptpmgmt_msg m, ptpmgmt_mng_vals_e id)
     {
         if(m != nullptr && m->_this != nullptr)
@@ -1817,6 +1875,7 @@ extern "C" {
         m->is_TTRA = ptpmgmt_msg_is_TTRA;
         m->is_FTRA = ptpmgmt_msg_is_FTRA;
         m->isEmpty = ptpmgmt_msg_isEmpty;
+        m->isPortScope = ptpmgmt_msg_isPortScope;
         m->isValidId = ptpmgmt_msg_isValidId;
         m->setAction = ptpmgmt_msg_setAction;
         m->clearData = ptpmgmt_msg_clearData;
@@ -0,0 +1,547 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Read PTP messages from capture files
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pcap.h"
+#include "comp.h"
+#include "timeCvrt.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+const size_t PCAP_DEF_CHUNK = 4096;
+// pcap file format
+const uint32_t PCAP_MAGIC_USEC = 0xa1b2c3d4;
+const uint32_t PCAP_MAGIC_NSEC = 0xa1b23c4d;
+const size_t PCAP_HDR_LEN = 24;
+const size_t PCAP_REC_LEN = 16;
+// pcapng file format
+const uint32_t NG_SHB = 0x0a0d0d0a;
+const uint32_t NG_IDB = 1;
+const uint32_t NG_PB = 2; // Obsolete packet block
+const uint32_t NG_SPB = 3;
+const uint32_t NG_EPB = 6;
+const uint32_t NG_BYTE_ORDER = 0x1a2b3c4d;
+const size_t NG_BLK_MIN = 12; // Block type, block length twice
+const uint16_t NG_OPT_TSRESOL = 9;
+const uint16_t NG_OPT_TSOFFSET = 14;
+// Link types
+const uint32_t LINK_ETHERNET = 1;
+const uint32_t LINK_RAW = 101;
+const uint32_t LINK_LINUX_SLL = 113;
+const uint32_t LINK_IPV4 = 228;
+const uint32_t LINK_IPV6 = 229;
+const uint32_t LINK_LINUX_SLL2 = 276;
+// Ether types
+const uint16_t ETH_P_IPV4 = 0x0800;
+const uint16_t ETH_P_IPV6 = 0x86dd;
+const uint16_t ETH_P_PTP = 0x88f7;
+const uint16_t ETH_P_VLAN = 0x8100;
+const uint16_t ETH_P_QINQ = 0x88a8;
+const uint16_t ETH_P_QINQ_OLD = 0x9100;
+// IP protocols and IPv6 extension headers
+const uint8_t IP_UDP = 17;
+const uint8_t IP6_HOP_OPTS = 0;
+const uint8_t IP6_ROUTING = 43;
+const uint8_t IP6_DST_OPTS = 60;
+// UDP ports
+const uint16_t PTP_EVENT_PORT = 319;
+const uint16_t PTP_GENERAL_PORT = 320;
+const size_t PTP_HDR_LEN = 34;
+
+struct PcapFile::Iface {
+    uint32_t link;
+    uint64_t units; // Time stamp units per second
+    int64_t offset; // Time stamp offset in seconds
+};
+struct PcapFile::Section {
+    bool swap;
+    std::vector<Iface> ifaces;
+};
+
+static inline uint16_t get16(const uint8_t *p, bool swap)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof v);
+    return swap ? __builtin_bswap16(v) : v;
+}
+static inline uint32_t get32(const uint8_t *p, bool swap)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return swap ? __builtin_bswap32(v) : v;
+}
+static inline uint16_t net16(const uint8_t *p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof v);
+    return net_to_cpu16(v);
+}
+static inline bool isPtpPort(uint16_t port)
+{
+    return port == PTP_EVENT_PORT || port == PTP_GENERAL_PORT;
+}
+static Timestamp_t unitsToTs(uint64_t val, uint64_t units, int64_t offset)
+{
+    uint64_t frac = val % units;
+    uint32_t nsec;
+    if(units >= NSEC_PER_SEC && units % NSEC_PER_SEC == 0)
+        nsec = frac / (units / NSEC_PER_SEC);
+    else {
+        // Keep the multiplication in 64 bits
+        uint64_t u = units;
+        while(u > (UINT64_C(1) << 34)) {
+            u >>= 1;
+            frac >>= 1;
+        }
+        nsec = frac * NSEC_PER_SEC / u;
+    }
+    return Timestamp_t(val / units + offset, nsec);
+}
+
+PcapFile::PcapFile() : m_map(nullptr), m_size(0), m_frames(0),
+    m_chunkFrames(PCAP_DEF_CHUNK), m_ng(false), m_swap(false), m_nsec(false),
+    m_link(0)
+{
+}
+PcapFile::~PcapFile()
+{
+    close();
+}
+bool PcapFile::setChunkFrames(size_t frames)
+{
+    if(frames == 0) {
+        PTPMGMT_ERROR("Wrong number of frames in chunk %zu", frames);
+        return false;
+    }
+    m_chunkFrames = frames;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PcapFile::open(const std::string &file)
+{
+    close();
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+        PTPMGMT_ERROR_P("Fail to open %s", file.c_str());
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        PTPMGMT_ERROR_P("Fail to stat %s", file.c_str());
+        ::close(fd);
+        return false;
+    }
+    if((size_t)st.st_size < PCAP_HDR_LEN) {
+        PTPMGMT_ERROR("File %s is too short", file.c_str());
+        ::close(fd);
+        return false;
+    }
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(addr == MAP_FAILED) {
+        PTPMGMT_ERROR_P("Fail to map %s", file.c_str());
+        return false;
+    }
+    m_map = (const uint8_t *)addr;
+    m_size = st.st_size;
+    uint32_t magic = get32(m_map, false);
+    bool ret;
+    if(magic == NG_SHB)
+        ret = indexNg();
+    else
+        ret = indexPcap();
+    if(!ret) {
+        close();
+        return false;
+    }
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+void PcapFile::close()
+{
+    if(m_map != nullptr)
+        munmap((void *)m_map, m_size);
+    m_map = nullptr;
+    m_size = 0;
+    m_frames = 0;
+    m_chunks.clear();
+    m_sections.clear();
+}
+bool PcapFile::indexPcap()
+{
+    uint32_t magic = get32(m_map, false);
+    m_ng = false;
+    if(magic == PCAP_MAGIC_USEC || magic == PCAP_MAGIC_NSEC)
+        m_swap = false;
+    else if(__builtin_bswap32(magic) == PCAP_MAGIC_USEC ||
+        __builtin_bswap32(magic) == PCAP_MAGIC_NSEC) {
+        m_swap = true;
+        magic = __builtin_bswap32(magic);
+    } else {
+        PTPMGMT_ERROR("Unknown capture file format");
+        return false;
+    }
+    m_nsec = magic == PCAP_MAGIC_NSEC;
+    // The upper bits hold the FCS length
+    m_link = get32(m_map + 20, m_swap) & 0xffff;
+    // A capture that was cut in the middle of a record ends at the record
+    for(size_t off = PCAP_HDR_LEN; off + PCAP_REC_LEN <= m_size;) {
+        size_t len = get32(m_map + off + 8, m_swap);
+        if(len > m_size - off - PCAP_REC_LEN)
+            break;
+        if(m_frames % m_chunkFrames == 0)
+            m_chunks.push_back({off, m_frames + 1, 0});
+        m_frames++;
+        off += PCAP_REC_LEN + len;
+    }
+    return true;
+}
+bool PcapFile::indexNg()
+{
+    m_ng = true;
+    for(size_t off = 0; off + NG_BLK_MIN <= m_size;) {
+        const uint8_t *blk = m_map + off;
+        uint32_t type;
+        if(get32(blk, false) == NG_SHB) {
+            // The byte order magic follows the block type and length
+            if(off + NG_BLK_MIN + 4 > m_size)
+                break;
+            uint32_t order = get32(blk + 8, false);
+            bool swap;
+            if(order == NG_BYTE_ORDER)
+                swap = false;
+            else if(__builtin_bswap32(order) == NG_BYTE_ORDER)
+                swap = true;
+            else {
+                PTPMGMT_ERROR("Wrong pcapng byte order at %zu", off);
+                return false;
+            }
+            m_sections.push_back({swap, {}});
+            type = NG_SHB;
+        } else if(m_sections.empty()) {
+            PTPMGMT_ERROR("Unknown capture file format");
+            return false;
+        } else
+            type = get32(blk, m_sections.back().swap);
+        Section &sec = m_sections.back();
+        size_t len = get32(blk + 4, sec.swap);
+        if(len < NG_BLK_MIN || len % 4 != 0 || len > m_size - off)
+            break;
+        switch(type) {
+            case NG_IDB: {
+                // Keep the interfaces numbering with a broken block
+                Iface ifc = {0, USEC_PER_SEC, 0};
+                if(len < NG_BLK_MIN + 8) {
+                    sec.ifaces.push_back(ifc);
+                    break;
+                }
+                ifc.link = get16(blk + 8, sec.swap);
+                const uint8_t *opt = blk + 16;
+                const uint8_t *end = blk + len - 4;
+                while(opt + 4 <= end) {
+                    uint16_t code = get16(opt, sec.swap);
+                    uint16_t olen = get16(opt + 2, sec.swap);
+                    const uint8_t *val = opt + 4;
+                    if(code == 0 || val + olen > end)
+                        break;
+                    if(code == NG_OPT_TSRESOL && olen >= 1) {
+                        uint8_t res = *val;
+                        uint8_t exp = res & 0x7f;
+                        if(res & 0x80) {
+                            if(exp < 64)
+                                ifc.units = UINT64_C(1) << exp;
+                        } else if(exp < 20) {
+                            ifc.units = 1;
+                            for(uint8_t i = 0; i < exp; i++)
+                                ifc.units *= 10;
+                        }
+                    } else if(code == NG_OPT_TSOFFSET && olen >= 8) {
+                        uint64_t v;
+                        memcpy(&v, val, sizeof v);
+                        ifc.offset = sec.swap ? __builtin_bswap64(v) : v;
+                    }
+                    opt = val + ((olen + 3) & ~3);
+                }
+                sec.ifaces.push_back(ifc);
+                break;
+            }
+            case NG_PB:
+            case NG_SPB:
+            case NG_EPB:
+                if(m_frames % m_chunkFrames == 0)
+                    m_chunks.push_back({off, m_frames + 1, m_sections.size() - 1});
+                m_frames++;
+                break;
+            default:
+                break;
+        }
+        off += len;
+    }
+    return true;
+}
+bool PcapFile::frame(uint32_t link, const uint8_t *p, size_t len,
+    PcapFrame_t &frame) const
+{
+    uint16_t proto;
+    frame.src = nullptr;
+    frame.dst = nullptr;
+    switch(link) {
+        case LINK_ETHERNET:
+            if(len < 14)
+                return false;
+            frame.dst = p;
+            frame.src = p + 6;
+            proto = net16(p + 12);
+            p += 14;
+            len -= 14;
+            break;
+        case LINK_LINUX_SLL:
+            if(len < 16)
+                return false;
+            if(net16(p + 4) == 6)
+                frame.src = p + 6;
+            proto = net16(p + 14);
+            p += 16;
+            len -= 16;
+            break;
+        case LINK_LINUX_SLL2:
+            if(len < 20)
+                return false;
+            proto = net16(p);
+            if(p[11] == 6)
+                frame.src = p + 12;
+            p += 20;
+            len -= 20;
+            break;
+        case LINK_RAW:
+        case LINK_IPV4:
+        case LINK_IPV6:
+            if(len < 1)
+                return false;
+            switch(p[0] >> 4) {
+                case 4:
+                    proto = ETH_P_IPV4;
+                    break;
+                case 6:
+                    proto = ETH_P_IPV6;
+                    break;
+                default:
+                    return false;
+            }
+            break;
+        default:
+            return false;
+    }
+    while(proto == ETH_P_VLAN || proto == ETH_P_QINQ ||
+        proto == ETH_P_QINQ_OLD) {
+        if(len < 4)
+            return false;
+        proto = net16(p + 2);
+        p += 4;
+        len -= 4;
+    }
+    switch(proto) {
+        case ETH_P_PTP:
+            frame.transport = IEEE_802_3;
+            frame.addrLen = 6;
+            frame.srcPort = 0;
+            frame.dstPort = 0;
+            break;
+        case ETH_P_IPV4: {
+            if(len < 20 || p[0] >> 4 != 4)
+                return false;
+            size_t ihl = (p[0] & 0xf) * 4;
+            size_t total = net16(p + 2);
+            // Skip fragments, PTP messages are never fragmented
+            if(ihl < 20 || total < ihl || len < ihl ||
+                (net16(p + 6) & 0x3fff) != 0 || p[9] != IP_UDP)
+                return false;
+            // Remove Ethernet padding
+            if(total < len)
+                len = total;
+            frame.transport = UDP_IPv4;
+            frame.src = p + 12;
+            frame.dst = p + 16;
+            frame.addrLen = 4;
+            p += ihl;
+            len -= ihl;
+            break;
+        }
+        case ETH_P_IPV6: {
+            if(len < 40 || p[0] >> 4 != 6)
+                return false;
+            size_t total = net16(p + 4) + 40;
+            if(total < len)
+                len = total;
+            uint8_t next = p[6];
+            frame.transport = UDP_IPv6;
+            frame.src = p + 8;
+            frame.dst = p + 24;
+            frame.addrLen = 16;
+            p += 40;
+            len -= 40;
+            while(next == IP6_HOP_OPTS || next == IP6_ROUTING ||
+                next == IP6_DST_OPTS) {
+                if(len < 8)
+                    return false;
+                size_t hlen = (p[1] + 1) * 8;
+                if(len < hlen)
+                    return false;
+                next = p[0];
+                p += hlen;
+                len -= hlen;
+            }
+            // Fragment header is skipped here as well
+            if(next != IP_UDP)
+                return false;
+            break;
+        }
+        default:
+            return false;
+    }
+    if(frame.transport != IEEE_802_3) {
+        if(len < 8)
+            return false;
+        frame.srcPort = net16(p);
+        frame.dstPort = net16(p + 2);
+        size_t ulen = net16(p + 4);
+        if(ulen < 8 || !(isPtpPort(frame.srcPort) || isPtpPort(frame.dstPort)))
+            return false;
+        if(ulen < len)
+            len = ulen;
+        p += 8;
+        len -= 8;
+    }
+    if(len < PTP_HDR_LEN)
+        return false;
+    // Remove padding after the PTP message
+    size_t msgLen = net16(p + 2);
+    if(msgLen >= PTP_HDR_LEN && msgLen < len)
+        len = msgLen;
+    frame.msg = p;
+    frame.size = len;
+    return true;
+}
+bool PcapFile::walkPcap(const Chunk &chk, size_t last,
+    const std::function<bool (const PcapFrame_t &frame)> &cb) const
+{
+    PcapFrame_t frm;
+    size_t off = chk.offset;
+    for(frm.index = chk.frame; frm.index < last; frm.index++) {
+        const uint8_t *rec = m_map + off;
+        size_t len = get32(rec + 8, m_swap);
+        off += PCAP_REC_LEN + len;
+        if(frame(m_link, rec + PCAP_REC_LEN, len, frm)) {
+            uint32_t frac = get32(rec + 4, m_swap);
+            frm.ts = Timestamp_t(get32(rec, m_swap),
+                    m_nsec ? frac : frac * NSEC_PER_USEC);
+            if(!cb(frm))
+                return false;
+        }
+    }
+    return true;
+}
+bool PcapFile::walkNg(const Chunk &chk, size_t last,
+    const std::function<bool (const PcapFrame_t &frame)> &cb) const
+{
+    PcapFrame_t frm;
+    size_t off = chk.offset;
+    size_t sec = chk.section;
+    frm.index = chk.frame;
+    // The index pass verified the blocks up to the last frame
+    while(frm.index < last) {
+        const uint8_t *blk = m_map + off;
+        uint32_t type = get32(blk, false);
+        if(type == NG_SHB && off != chk.offset)
+            sec++;
+        const Section &s = m_sections[sec];
+        type = get32(blk, s.swap);
+        size_t len = get32(blk + 4, s.swap);
+        off += len;
+        uint32_t ifc;
+        uint64_t ts = 0;
+        const uint8_t *data;
+        size_t caplen;
+        switch(type) {
+            case NG_EPB:
+                if(len < NG_BLK_MIN + 20)
+                    break;
+                ifc = get32(blk + 8, s.swap);
+                ts = (uint64_t)get32(blk + 12, s.swap) << 32 |
+                    get32(blk + 16, s.swap);
+                caplen = get32(blk + 20, s.swap);
+                data = blk + 28;
+                if(caplen > len - NG_BLK_MIN - 20)
+                    break;
+                if(ifc < s.ifaces.size() &&
+                    frame(s.ifaces[ifc].link, data, caplen, frm)) {
+                    frm.ts = unitsToTs(ts, s.ifaces[ifc].units,
+                            s.ifaces[ifc].offset);
+                    if(!cb(frm))
+                        return false;
+                }
+                break;
+            case NG_PB:
+                if(len < NG_BLK_MIN + 20)
+                    break;
+                ifc = get16(blk + 8, s.swap);
+                ts = (uint64_t)get32(blk + 12, s.swap) << 32 |
+                    get32(blk + 16, s.swap);
+                caplen = get32(blk + 20, s.swap);
+                data = blk + 28;
+                if(caplen > len - NG_BLK_MIN - 20)
+                    break;
+                if(ifc < s.ifaces.size() &&
+                    frame(s.ifaces[ifc].link, data, caplen, frm)) {
+                    frm.ts = unitsToTs(ts, s.ifaces[ifc].units,
+                            s.ifaces[ifc].offset);
+                    if(!cb(frm))
+                        return false;
+                }
+                break;
+            case NG_SPB:
+                // Simple packet block has no time stamp
+                if(len < NG_BLK_MIN + 4 || s.ifaces.empty())
+                    break;
+                caplen = get32(blk + 8, s.swap);
+                if(caplen > len - NG_BLK_MIN - 4)
+                    caplen = len - NG_BLK_MIN - 4;
+                if(frame(s.ifaces[0].link, blk + 12, caplen, frm)) {
+                    frm.ts = Timestamp_t();
+                    if(!cb(frm))
+                        return false;
+                }
+                break;
+            default:
+                continue;
+        }
+        frm.index++;
+    }
+    return true;
+}
+bool PcapFile::traverse(size_t chunk,
+    const std::function<bool (const PcapFrame_t &frame)> &callback) const
+{
+    if(chunk >= m_chunks.size()) {
+        PTPMGMT_ERROR("Wrong chunk %zu", chunk);
+        return false;
+    }
+    size_t last = chunk + 1 < m_chunks.size() ?
+        m_chunks[chunk + 1].frame : m_frames + 1;
+    if(m_ng)
+        return walkNg(m_chunks[chunk], last, callback);
+    return walkPcap(m_chunks[chunk], last, callback);
+}
+
+__PTPMGMT_NAMESPACE_END
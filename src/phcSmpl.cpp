@@ -0,0 +1,574 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Sample multiple PHCs in parallel
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <condition_variable>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include "phcSmpl.h"
+#include "comp.h"
+#include "timeCvrt.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+// From kernel include/uapi/linux/ptp_clock.h
+const size_t PHC_MAX_SAMPLES = 25;
+const size_t PHC_DEF_SAMPLES = 5;
+// Consecutive failures before moving to the next method
+const size_t PHC_MAX_FAILS = 3;
+
+// Method selected per device
+static std::mutex cacheLock;
+static std::map<std::string, PhcCrossMethod_e> methodCache;
+
+class PhcSampler::Sync
+{
+  public:
+    std::mutex lock;
+    std::condition_variable start; // Workers wait for a new round
+    std::condition_variable done; // Sampler wait for workers
+    uint64_t round; // Last round the sampler issued
+    size_t pending; // Workers that did not finish the current round
+    size_t parties; // Number of workers on the barrier
+    std::atomic<size_t> arrived; // Workers that pass the barrier
+    bool quit;
+    Sync() : round(0), pending(0), parties(0), arrived(0), quit(false) {}
+};
+
+class PhcSampler::Worker
+{
+  public:
+    PtpClock clk;
+    PhcCrossTs xts;
+    std::thread thread;
+    PhcClockSample_t res;
+    Worker() : res{0} {}
+    void run(Sync &sync);
+};
+
+static inline void setBest(PhcClockSample_t &res, const Timestamp_t &before,
+    const Timestamp_t &phc, int64_t delay)
+{
+    res.sysClk = before;
+    res.sysClk.addNanoseconds(delay / 2);
+    res.phcClk = phc;
+    res.offset = phc.diffNanoseconds(res.sysClk);
+    res.delay = delay;
+    res.valid = true;
+}
+static bool sampleExt(const PtpClock &clk, size_t samples,
+    PhcClockSample_t &res)
+{
+    std::vector<PtpSampleExt_t> vec;
+    if(!clk.extSamplePtpSys(samples, vec))
+        return false;
+    for(const auto &s : vec) {
+        int64_t delay = s.after.diffNanoseconds(s.before);
+        // Ignore samples where system clock jumps
+        if(delay >= 0 && (!res.valid || delay < res.delay))
+            setBest(res, s.before, s.phcClk, delay);
+    }
+    return true;
+}
+static bool sampleBasic(const PtpClock &clk, size_t samples,
+    PhcClockSample_t &res)
+{
+    std::vector<PtpSample_t> vec;
+    if(!clk.samplePtpSys(samples, vec))
+        return false;
+    size_t num = vec.size();
+    if(num == 1) {
+        // No window, use the system clock sample as is
+        setBest(res, vec[0].sysClk, vec[0].phcClk, 0);
+        return true;
+    }
+    // The kernel reads the system clock before and after each PHC read
+    for(size_t i = 0; i + 1 < num; i++) {
+        int64_t delay = vec[i + 1].sysClk.diffNanoseconds(vec[i].sysClk);
+        if(delay >= 0 && (!res.valid || delay < res.delay))
+            setBest(res, vec[i].sysClk, vec[i].phcClk, delay);
+    }
+    return true;
+}
+static bool samplePrecise(const PtpClock &clk, PhcClockSample_t &res)
+{
+    PtpSamplePrecise_t s;
+    if(!clk.preciseSamplePtpSys(s))
+        return false;
+    // Driver provides both clocks at the same moment
+    setBest(res, s.sysClk, s.phcClk, 0);
+    return true;
+}
+static inline void smooth(int64_t &avg, int64_t val, bool first)
+{
+    if(first)
+        avg = val;
+    else
+        avg += (val - avg) / 16;
+}
+PhcCrossTs::PhcCrossTs() : m_clk(nullptr), m_samples(PHC_DEF_SAMPLES),
+    m_method(PHC_CROSS_AUTO), m_forced(false), m_fails(0), m_stats{},
+    m_last{}
+{
+}
+bool PhcCrossTs::setClock(const PtpClock *clk)
+{
+    if(clk == nullptr || !clk->isInit()) {
+        PTPMGMT_ERROR("Clock is not initialized");
+        return false;
+    }
+    m_clk = clk;
+    if(!m_forced)
+        m_method = PHC_CROSS_AUTO;
+    m_fails = 0;
+    for(auto &st : m_stats)
+        st = {0};
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PhcCrossTs::setSamples(size_t samples)
+{
+    if(samples == 0 || samples > PHC_MAX_SAMPLES) {
+        PTPMGMT_ERROR("Wrong number of samples %zu", samples);
+        return false;
+    }
+    m_samples = samples;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PhcCrossTs::setMethod(PhcCrossMethod_e method)
+{
+    if(method < PHC_CROSS_AUTO || method > PHC_CROSS_BASIC) {
+        PTPMGMT_ERROR("Wrong method %d", method);
+        return false;
+    }
+    m_method = method;
+    m_forced = method != PHC_CROSS_AUTO;
+    m_fails = 0;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PhcCrossTs::sampleBy(PhcCrossMethod_e method, PhcClockSample_t &res)
+{
+    res = {0};
+    auto begin = std::chrono::steady_clock::now();
+    bool ret;
+    switch(method) {
+        case PHC_CROSS_PRECISE:
+            ret = samplePrecise(*m_clk, res);
+            break;
+        case PHC_CROSS_EXT:
+            ret = sampleExt(*m_clk, m_samples, res);
+            break;
+        case PHC_CROSS_BASIC:
+            ret = sampleBasic(*m_clk, m_samples, res);
+            break;
+        default:
+            return false;
+    }
+    PhcCrossStats_t &st = m_stats[method];
+    st.latency = std::chrono::duration_cast<std::chrono::nanoseconds>
+        (std::chrono::steady_clock::now() - begin).count();
+    if(!ret || !res.valid) {
+        st.failures++;
+        return false;
+    }
+    bool first = st.samples == 0;
+    smooth(st.avgLatency, st.latency, first);
+    smooth(st.window, res.delay, first);
+    if(!first)
+        smooth(st.jitter, llabs(res.offset - m_last[method]), st.samples == 1);
+    m_last[method] = res.offset;
+    st.samples++;
+    return true;
+}
+void PhcCrossTs::select(PhcCrossMethod_e method)
+{
+    m_method = method;
+    m_fails = 0;
+    if(m_forced)
+        return;
+    std::lock_guard<std::mutex> lk(cacheLock);
+    methodCache[m_clk->device()] = method;
+}
+bool PhcCrossTs::probe(PhcClockSample_t &res)
+{
+    {
+        std::lock_guard<std::mutex> lk(cacheLock);
+        auto it = methodCache.find(m_clk->device());
+        if(it != methodCache.end())
+            m_method = it->second;
+    }
+    if(m_method != PHC_CROSS_AUTO)
+        return sample(res);
+    PtpCaps_t caps;
+    int first = m_clk->fetchCaps(caps) && caps.cross_timestamping ?
+        PHC_CROSS_PRECISE : PHC_CROSS_EXT;
+    for(int m = first; m <= PHC_CROSS_BASIC; m++) {
+        PhcCrossMethod_e method = (PhcCrossMethod_e)m;
+        if(sampleBy(method, res)) {
+            select(method);
+            PTPMGMT_ERROR_CLR;
+            return true;
+        }
+    }
+    PTPMGMT_ERROR("Fail to sample clock %s", m_clk->device_c());
+    return false;
+}
+bool PhcCrossTs::sample(PhcClockSample_t &res)
+{
+    if(m_clk == nullptr) {
+        PTPMGMT_ERROR("Clock is not set");
+        return false;
+    }
+    if(m_method == PHC_CROSS_AUTO)
+        return probe(res);
+    if(sampleBy(m_method, res)) {
+        m_fails = 0;
+        PTPMGMT_ERROR_CLR;
+        return true;
+    }
+    if(m_forced)
+        return false;
+    m_fails++;
+    // Fall back to the next methods
+    for(int m = m_method + 1; m <= PHC_CROSS_BASIC; m++) {
+        PhcCrossMethod_e method = (PhcCrossMethod_e)m;
+        if(sampleBy(method, res)) {
+            if(m_fails >= PHC_MAX_FAILS)
+                select(method);
+            PTPMGMT_ERROR_CLR;
+            return true;
+        }
+    }
+    return false;
+}
+bool PhcCrossTs::calibrate(size_t rounds)
+{
+    if(m_clk == nullptr) {
+        PTPMGMT_ERROR("Clock is not set");
+        return false;
+    }
+    if(rounds == 0) {
+        PTPMGMT_ERROR("Wrong number of rounds");
+        return false;
+    }
+    PtpCaps_t caps;
+    int first = m_clk->fetchCaps(caps) && caps.cross_timestamping ?
+        PHC_CROSS_PRECISE : PHC_CROSS_EXT;
+    PhcCrossMethod_e best = PHC_CROSS_AUTO;
+    PhcClockSample_t res;
+    for(int m = first; m <= PHC_CROSS_BASIC; m++) {
+        PhcCrossMethod_e method = (PhcCrossMethod_e)m;
+        size_t good = 0;
+        for(size_t i = 0; i < rounds; i++) {
+            if(sampleBy(method, res))
+                good++;
+        }
+        if(good == 0)
+            continue;
+        const PhcCrossStats_t &st = m_stats[method];
+        if(best == PHC_CROSS_AUTO)
+            best = method;
+        else if(best != PHC_CROSS_PRECISE) {
+            const PhcCrossStats_t &b = m_stats[best];
+            if(st.window < b.window ||
+                (st.window == b.window && st.avgLatency < b.avgLatency))
+                best = method;
+        }
+    }
+    if(best == PHC_CROSS_AUTO) {
+        PTPMGMT_ERROR("Fail to sample clock %s", m_clk->device_c());
+        return false;
+    }
+    if(!m_forced)
+        select(best);
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+const PhcCrossStats_t &PhcCrossTs::getStats(PhcCrossMethod_e method) const
+{
+    if(method < PHC_CROSS_AUTO || method > PHC_CROSS_BASIC)
+        return m_stats[PHC_CROSS_AUTO];
+    if(method == PHC_CROSS_AUTO)
+        return m_stats[m_method];
+    return m_stats[method];
+}
+const char *PhcCrossTs::method2str(PhcCrossMethod_e method)
+{
+    switch(method) {
+        case PHC_CROSS_AUTO:
+            return "auto";
+        case PHC_CROSS_PRECISE:
+            return "precise";
+        case PHC_CROSS_EXT:
+            return "extended";
+        case PHC_CROSS_BASIC:
+            return "basic";
+        default:
+            return "unknown";
+    }
+}
+void PhcCrossTs::clearCache()
+{
+    std::lock_guard<std::mutex> lk(cacheLock);
+    methodCache.clear();
+}
+void PhcSampler::Worker::run(Sync &sync)
+{
+    uint64_t seen = 0;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lk(sync.lock);
+            sync.start.wait(lk, [&] { return sync.quit || sync.round != seen; });
+            if(sync.quit)
+                return;
+            seen = sync.round;
+        }
+        // Barrier, all workers sample at the same moment
+        sync.arrived.fetch_add(1);
+        while(sync.arrived.load() < sync.parties)
+            std::this_thread::yield();
+        xts.sample(res);
+        std::lock_guard<std::mutex> lk(sync.lock);
+        if(--sync.pending == 0)
+            sync.done.notify_one();
+    }
+}
+PhcSampler::PhcSampler() : m_sync(new Sync), m_samples(PHC_DEF_SAMPLES),
+    m_running(false)
+{
+}
+PhcSampler::~PhcSampler()
+{
+    stop();
+}
+bool PhcSampler::addWorker(std::unique_ptr<Worker> &wrk)
+{
+    if(!wrk->xts.setClock(&wrk->clk))
+        return false;
+    m_workers.push_back(std::move(wrk));
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PhcSampler::addClock(int ptpIndex, bool readonly)
+{
+    if(m_running) {
+        PTPMGMT_ERROR("Sampler is running");
+        return false;
+    }
+    for(const auto &w : m_workers) {
+        if(w->clk.ptpIndex() == ptpIndex) {
+            PTPMGMT_ERROR("Clock %d is already used", ptpIndex);
+            return false;
+        }
+    }
+    std::unique_ptr<Worker> wrk(new Worker);
+    if(!wrk->clk.initUsingIndex(ptpIndex, readonly))
+        return false;
+    return addWorker(wrk);
+}
+bool PhcSampler::addClock(const std::string &device, bool readonly)
+{
+    if(m_running) {
+        PTPMGMT_ERROR("Sampler is running");
+        return false;
+    }
+    std::unique_ptr<Worker> wrk(new Worker);
+    if(!wrk->clk.initUsingDevice(device, readonly))
+        return false;
+    for(const auto &w : m_workers) {
+        if(w->clk.device() == wrk->clk.device()) {
+            PTPMGMT_ERROR("Clock %s is already used", device.c_str());
+            return false;
+        }
+    }
+    return addWorker(wrk);
+}
+size_t PhcSampler::addAllClocks(bool readonly)
+{
+    DIR *dir = opendir("/dev");
+    if(dir == nullptr) {
+        PTPMGMT_ERROR_P("opendir");
+        return 0;
+    }
+    std::vector<int> indexes;
+    dirent *ent;
+    while((ent = readdir(dir)) != nullptr) {
+        if(strncmp(ent->d_name, "ptp", 3) != 0 || ent->d_name[3] == 0)
+            continue;
+        char *endptr;
+        long ret = strtol(ent->d_name + 3, &endptr, 10);
+        if(*endptr == 0 && ret >= 0 && ret < INT32_MAX)
+            indexes.push_back(ret);
+    }
+    closedir(dir);
+    std::sort(indexes.begin(), indexes.end());
+    size_t num = 0;
+    for(int idx : indexes) {
+        if(addClock(idx, readonly))
+            num++;
+    }
+    return num;
+}
+const PtpClock *PhcSampler::getClock(size_t index) const
+{
+    if(index >= m_workers.size())
+        return nullptr;
+    return &m_workers[index]->clk;
+}
+const PhcCrossTs *PhcSampler::getCrossTs(size_t index) const
+{
+    if(index >= m_workers.size())
+        return nullptr;
+    return &m_workers[index]->xts;
+}
+bool PhcSampler::setSamples(size_t samples)
+{
+    if(samples == 0 || samples > PHC_MAX_SAMPLES) {
+        PTPMGMT_ERROR("Wrong number of samples %zu", samples);
+        return false;
+    }
+    if(m_running) {
+        PTPMGMT_ERROR("Sampler is running");
+        return false;
+    }
+    m_samples = samples;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PhcSampler::setCpus(const std::vector<int> &cpus)
+{
+    if(m_running) {
+        PTPMGMT_ERROR("Sampler is running");
+        return false;
+    }
+    for(int cpu : cpus) {
+        if(cpu < 0 || cpu >= CPU_SETSIZE) {
+            PTPMGMT_ERROR("Wrong CPU %d", cpu);
+            return false;
+        }
+    }
+    m_cpus = cpus;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PhcSampler::start()
+{
+    if(m_running) {
+        PTPMGMT_ERROR_CLR;
+        return true;
+    }
+    if(m_workers.empty()) {
+        PTPMGMT_ERROR("No clocks to sample");
+        return false;
+    }
+    std::vector<int> cpus = m_cpus;
+    if(cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if(sched_getaffinity(0, sizeof set, &set) == 0) {
+            for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if(CPU_ISSET(cpu, &set))
+                    cpus.push_back(cpu);
+            }
+        }
+    }
+    Sync &sync = *m_sync;
+    sync.round = 0;
+    sync.pending = 0;
+    sync.parties = m_workers.size();
+    sync.quit = false;
+    m_running = true;
+    for(size_t i = 0; i < m_workers.size(); i++) {
+        Worker *wrk = m_workers[i].get();
+        wrk->xts.setSamples(m_samples);
+        wrk->thread = std::thread(&Worker::run, wrk, std::ref(sync));
+        if(cpus.empty())
+            continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[i % cpus.size()], &set);
+        int err = pthread_setaffinity_np(wrk->thread.native_handle(),
+                sizeof set, &set);
+        if(err != 0) {
+            stop();
+            errno = err;
+            PTPMGMT_ERROR_P("pthread_setaffinity_np");
+            return false;
+        }
+    }
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+void PhcSampler::stop()
+{
+    if(!m_running)
+        return;
+    {
+        std::lock_guard<std::mutex> lk(m_sync->lock);
+        m_sync->quit = true;
+    }
+    m_sync->start.notify_all();
+    for(auto &w : m_workers) {
+        if(w->thread.joinable())
+            w->thread.join();
+    }
+    m_running = false;
+}
+bool PhcSampler::sampleRound(PhcRound_t &round)
+{
+    if(!m_running && !start())
+        return false;
+    Sync &sync = *m_sync;
+    {
+        std::unique_lock<std::mutex> lk(sync.lock);
+        // All workers passed the barrier of the previous round
+        sync.arrived.store(0);
+        sync.pending = m_workers.size();
+        sync.round++;
+        sync.start.notify_all();
+        sync.done.wait(lk, [&] { return sync.pending == 0; });
+        round.sequence = sync.round;
+    }
+    size_t num = m_workers.size();
+    round.clocks.resize(num);
+    round.matrix.assign(num * num, 0);
+    size_t valid = 0;
+    for(size_t i = 0; i < num; i++) {
+        round.clocks[i] = m_workers[i]->res;
+        if(round.clocks[i].valid)
+            valid++;
+    }
+    for(size_t i = 0; i < num; i++) {
+        const PhcClockSample_t &a = round.clocks[i];
+        for(size_t j = 0; j < num; j++) {
+            const PhcClockSample_t &b = round.clocks[j];
+            // Both compared with the same system clock, it cancels out
+            if(a.valid && b.valid)
+                round.matrix[i * num + j] = a.offset - b.offset;
+        }
+    }
+    if(valid == 0) {
+        PTPMGMT_ERROR("Fail to sample clocks");
+        return false;
+    }
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+
+__PTPMGMT_NAMESPACE_END
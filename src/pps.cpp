@@ -0,0 +1,376 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Discipline a PHC using a pulse per second input
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include "pps.h"
+#include "comp.h"
+#include "timeCvrt.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+const size_t PPS_DEF_FILTER_SIZE = 5;
+const int64_t PPS_DEF_OUTLIER = 10000; // 10 microseconds
+const int64_t PPS_DEF_TOLERANCE = 1000000; // 1 millisecond
+
+class PpsDiscipline::Loop
+{
+  public:
+    std::thread thread;
+    mutable std::mutex lock; // Protect status
+    int evfd; // Wake the thread on stop
+    bool running;
+    Loop() : evfd(-1), running(false) {}
+    void run(PpsDiscipline &pps);
+};
+
+void PpsDiscipline::Loop::run(PpsDiscipline &pps)
+{
+    pollfd fds[2] = {
+        { .fd = pps.m_clk->fileno(), .events = POLLIN },
+        { .fd = evfd, .events = POLLIN },
+    };
+    std::vector<PtpEvent_t> events;
+    for(;;) {
+        if(poll(fds, 2, -1) < 0) {
+            if(errno == EINTR)
+                continue;
+            return;
+        }
+        if(fds[1].revents != 0)
+            return;
+        if((fds[0].revents & POLLIN) != 0) {
+            events.clear();
+            if(pps.m_clk->readEvents(events)) {
+                for(const auto &event : events)
+                    pps.process(event);
+            }
+        } else if(fds[0].revents != 0)
+            return;
+    }
+}
+PpsDiscipline::PpsDiscipline() : m_loop(new Loop), m_servo(new PiServo),
+    m_clk(nullptr), m_cb(nullptr), m_status{}, m_outlier(PPS_DEF_OUTLIER),
+    m_tolerance(PPS_DEF_TOLERANCE), m_filterSize(PPS_DEF_FILTER_SIZE),
+    m_rejects(0), m_pin(-1), m_channel(0), m_edges(PTP_EXTERN_TS_RISING_EDGE),
+    m_priority(0), m_cpu(-1), m_haveLast(false), m_primed(false)
+{
+}
+PpsDiscipline::~PpsDiscipline()
+{
+    stop();
+}
+#define CHECK_RUNNING do {\
+        if(isRunning()) {\
+            PTPMGMT_ERROR("Discipline is running");\
+            return false;\
+        } } while(0)
+bool PpsDiscipline::setClock(const PtpClock *clk)
+{
+    CHECK_RUNNING;
+    if(clk == nullptr || !clk->isInit()) {
+        PTPMGMT_ERROR("Clock is not initialized");
+        return false;
+    }
+    m_clk = clk;
+    m_primed = false;
+    m_servo->reset();
+    restart();
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::setPin(int pin, unsigned int channel)
+{
+    CHECK_RUNNING;
+    m_pin = pin;
+    m_channel = channel;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::setEdge(uint8_t edges)
+{
+    CHECK_RUNNING;
+    if(edges != PTP_EXTERN_TS_RISING_EDGE &&
+        edges != PTP_EXTERN_TS_FALLING_EDGE) {
+        PTPMGMT_ERROR("Use a single edge");
+        return false;
+    }
+    m_edges = edges;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::setServo(Servo *servo)
+{
+    if(servo == nullptr) {
+        PTPMGMT_ERROR("Missing servo");
+        return false;
+    }
+    if(isRunning()) {
+        delete servo;
+        PTPMGMT_ERROR("Discipline is running");
+        return false;
+    }
+    m_servo.reset(servo);
+    m_primed = false;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::setFilter(size_t size, int64_t threshold)
+{
+    CHECK_RUNNING;
+    if(size > 0 && threshold <= 0) {
+        PTPMGMT_ERROR("Wrong outlier threshold");
+        return false;
+    }
+    m_filterSize = size;
+    m_outlier = threshold;
+    restart();
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::setTolerance(int64_t tolerance)
+{
+    CHECK_RUNNING;
+    if(tolerance <= 0 || tolerance >= NSEC_PER_SEC / 2) {
+        PTPMGMT_ERROR("Wrong tolerance");
+        return false;
+    }
+    m_tolerance = tolerance;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::setPriority(int priority)
+{
+    CHECK_RUNNING;
+    if(priority < 0 || priority > sched_get_priority_max(SCHED_FIFO)) {
+        PTPMGMT_ERROR("Wrong priority %d", priority);
+        return false;
+    }
+    m_priority = priority;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::setCpu(int cpu)
+{
+    CHECK_RUNNING;
+    if(cpu >= CPU_SETSIZE) {
+        PTPMGMT_ERROR("Wrong CPU %d", cpu);
+        return false;
+    }
+    m_cpu = cpu;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool PpsDiscipline::enable()
+{
+    if(m_clk == nullptr) {
+        PTPMGMT_ERROR("Clock is not set");
+        return false;
+    }
+    if(m_pin >= 0) {
+        PtpPin_t pin;
+        pin.index = m_pin;
+        pin.functional = PTP_PIN_EXTERNAL_TS;
+        pin.channel = m_channel;
+        if(!m_clk->writePin(pin))
+            return false;
+    }
+    return m_clk->ExternTSEbable(m_channel, m_edges);
+}
+bool PpsDiscipline::disable()
+{
+    if(m_clk == nullptr) {
+        PTPMGMT_ERROR("Clock is not set");
+        return false;
+    }
+    return m_clk->ExternTSDisable(m_channel);
+}
+void PpsDiscipline::restart()
+{
+    m_window.clear();
+    m_haveLast = false;
+    m_rejects = 0;
+}
+bool PpsDiscipline::accept(const Timestamp_t &time, int64_t offset)
+{
+    if(m_haveLast) {
+        // Edges are a whole number of seconds apart
+        int64_t dist = time.diffNanoseconds(m_last);
+        int64_t secs = (dist + NSEC_PER_SEC / 2) / NSEC_PER_SEC;
+        if(dist <= 0 || secs == 0 || llabs(dist - secs * NSEC_PER_SEC) > m_tolerance)
+            return false;
+    }
+    if(m_filterSize == 0 || m_window.size() < m_filterSize ||
+        (m_status.servo != SERVO_LOCKED && m_status.servo != SERVO_LOCKED_STABLE))
+        return true;
+    std::vector<int64_t> w(m_window);
+    auto mid = w.begin() + w.size() / 2;
+    std::nth_element(w.begin(), mid, w.end());
+    return llabs(offset - *mid) <= m_outlier;
+}
+bool PpsDiscipline::process(const PtpEvent_t &event)
+{
+    if(m_clk == nullptr) {
+        PTPMGMT_ERROR("Clock is not set");
+        return false;
+    }
+    if(event.index != m_channel) {
+        PTPMGMT_ERROR("Event of channel %u", event.index);
+        return false;
+    }
+    if(!m_primed) {
+        m_servo->syncInterval(1);
+        PtpCaps_t caps;
+        if(m_clk->fetchCaps(caps) && caps.max_ppb > 0)
+            m_servo->setMaxFreq(caps.max_ppb);
+        m_servo->setFreq(m_clk->getFreq());
+        m_primed = true;
+    }
+    // Phase error from the nearest second boundary
+    int64_t offset = event.time.nanosecondsField % NSEC_PER_SEC;
+    if(offset >= NSEC_PER_SEC / 2)
+        offset -= NSEC_PER_SEC;
+    {
+        std::lock_guard<std::mutex> lk(m_loop->lock);
+        m_status.events++;
+    }
+    if(!accept(event.time, offset)) {
+        {
+            std::lock_guard<std::mutex> lk(m_loop->lock);
+            m_status.rejected++;
+        }
+        size_t limit = m_filterSize > 0 ? m_filterSize : PPS_DEF_FILTER_SIZE;
+        if(++m_rejects < limit) {
+            PTPMGMT_ERROR("Edge rejected as outlier");
+            return false;
+        }
+        // The source moved, start over with this edge
+        restart();
+    }
+    m_rejects = 0;
+    servoState_e state;
+    float_freq freq = m_servo->sample(offset, event.time.toNanoseconds(),
+            state);
+    bool ret = true;
+    switch(state) {
+        case SERVO_JUMP:
+            ret = m_clk->setFreq(freq) && m_clk->offsetClock(-offset);
+            // Previous edges are from before the step
+            restart();
+            break;
+        case SERVO_LOCKED:
+        case SERVO_LOCKED_STABLE:
+            ret = m_clk->setFreq(freq);
+            m_window.push_back(offset);
+            if(m_window.size() > m_filterSize)
+                m_window.erase(m_window.begin());
+        // Fall through
+        default:
+            m_last = event.time;
+            m_haveLast = true;
+            break;
+    }
+    int64_t latency = 0;
+    if(ret && state != SERVO_UNLOCKED)
+        latency = m_clk->getTime().diffNanoseconds(event.time);
+    PpsStatus_t status;
+    {
+        std::lock_guard<std::mutex> lk(m_loop->lock);
+        m_status.servo = state;
+        m_status.offset = offset;
+        if(ret && state != SERVO_UNLOCKED)
+            m_status.freq = freq;
+        m_status.time = event.time;
+        m_status.latency = latency;
+        status = m_status;
+    }
+    if(m_cb != nullptr)
+        m_cb->update(status);
+    if(ret)
+        PTPMGMT_ERROR_CLR;
+    return ret;
+}
+bool PpsDiscipline::start()
+{
+    if(isRunning()) {
+        PTPMGMT_ERROR_CLR;
+        return true;
+    }
+    if(!enable())
+        return false;
+    Loop &loop = *m_loop;
+    loop.evfd = eventfd(0, EFD_CLOEXEC);
+    if(loop.evfd < 0) {
+        PTPMGMT_ERROR_P("eventfd");
+        disable();
+        return false;
+    }
+    loop.running = true;
+    loop.thread = std::thread(&Loop::run, &loop, std::ref(*this));
+    pthread_t thread = loop.thread.native_handle();
+    if(m_cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(m_cpu, &set);
+        int err = pthread_setaffinity_np(thread, sizeof set, &set);
+        if(err != 0) {
+            stop();
+            errno = err;
+            PTPMGMT_ERROR_P("pthread_setaffinity_np");
+            return false;
+        }
+    }
+    if(m_priority > 0) {
+        sched_param param = {};
+        param.sched_priority = m_priority;
+        int err = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if(err != 0) {
+            stop();
+            errno = err;
+            PTPMGMT_ERROR_P("pthread_setschedparam");
+            return false;
+        }
+    }
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+void PpsDiscipline::stop()
+{
+    Loop &loop = *m_loop;
+    if(!loop.running)
+        return;
+    uint64_t one = 1;
+    if(write(loop.evfd, &one, sizeof one) < 0)
+        PTPMGMT_ERROR_P("write");
+    if(loop.thread.joinable())
+        loop.thread.join();
+    close(loop.evfd);
+    loop.evfd = -1;
+    loop.running = false;
+    disable();
+}
+bool PpsDiscipline::isRunning() const
+{
+    return m_loop->running;
+}
+PpsStatus_t PpsDiscipline::getStatus() const
+{
+    std::lock_guard<std::mutex> lk(m_loop->lock);
+    return m_status;
+}
+
+__PTPMGMT_NAMESPACE_END
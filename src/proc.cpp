@@ -588,7 +588,7 @@ ssize_t Message::dataFieldSize(const BaseMngTlv *data) const
  * The main build function will add a pad at the end to make size even
  */
 
-#define A(n) bool MsgProc::n##_##f(n##_t &d)
+#define A(n) template<typename T> bool MsgProc::n##_##f(n##_t &d)
 
 A(CLOCK_DESCRIPTION)
 {
@@ -9,12 +9,17 @@
  *
  */
 
+#include <map>
 #include <cmath>
+#include <mutex>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
 #include <linux/sockios.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <linux/ptp_clock.h>
 #include <linux/version.h>
 #include "ptp.h"
@@ -170,6 +175,269 @@ static bool setTimeFromTime(bool isInit, clockid_t from, clockid_t to)
     PTPMGMT_ERROR_CLR;
     return true;
 }
+static bool fetchPtpIndex(int fd, ifreq &ifr, int &ptpIndex)
+{
+    ethtool_ts_info info = { .cmd = ETHTOOL_GET_TS_INFO };
+    info.phc_index = NO_SUCH_PTP;
+    ifr.ifr_data = (char *)&info;
+    if(ioctl(fd, SIOCETHTOOL, &ifr) == -1)
+        return false;
+    ptpIndex = info.phc_index;
+    return true;
+}
+
+/*
+ * Process wide network interfaces cache
+ * The cache is populated with a rtnetlink dump of the links.
+ * The same netlink socket subscribes to the link group,
+ *  we drain the link notifications before each lookup.
+ * If the kernel drops notifications, we dump the links again.
+ * The PTP index is not part of the link information,
+ *  we fetch it once per interface.
+ * On any failure the caller falls back to the interface ioctls.
+ * If netlink is not available, we do not try to open it again.
+ */
+class IfCache
+{
+  private:
+    struct ifEntry_t {
+        std::string name;
+        Binary mac;
+        int ptpIndex;
+        bool havePtp;
+    };
+    std::mutex m_lock;
+    std::map<int, ifEntry_t> m_ifs; // Interfaces by index
+    std::map<std::string, int> m_names; // Interface index by name
+    int m_fd;
+    uint32_t m_seq;
+    bool m_failed; // Netlink is not available
+    // Link dump messages with statistics take about 1.5 KB
+    alignas(nlmsghdr) char m_buf[32 * 1024];
+    bool open();
+    void closeSock();
+    bool dump();
+    void drain();
+    bool parse(size_t len, bool &done);
+    void update(nlmsghdr *nlh);
+    void remove(int ifIndex);
+    bool get(ifEntry_t &entry, Binary &mac, int &ptpIndex);
+
+  public:
+    IfCache() : m_fd(-1), m_seq(0), m_failed(false) {}
+    ~IfCache() { closeSock(); }
+    bool findName(const std::string &ifName, int &ifIndex, Binary &mac,
+        int &ptpIndex);
+    bool findIndex(int ifIndex, std::string &ifName, Binary &mac,
+        int &ptpIndex);
+};
+static IfCache ifCache;
+
+bool IfCache::open()
+{
+    if(m_fd >= 0)
+        return true;
+    if(m_failed)
+        return false;
+    m_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(m_fd < 0) {
+        m_failed = true;
+        return false;
+    }
+    sockaddr_nl addr = { .nl_family = AF_NETLINK };
+    addr.nl_groups = RTMGRP_LINK;
+    if(bind(m_fd, (sockaddr *)&addr, sizeof addr) != 0 || !dump()) {
+        closeSock();
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+void IfCache::closeSock()
+{
+    if(m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_ifs.clear();
+    m_names.clear();
+}
+bool IfCache::dump()
+{
+    struct {
+        nlmsghdr nlh;
+        ifinfomsg ifi;
+    } req = {};
+    req.nlh.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+    req.nlh.nlmsg_type = RTM_GETLINK;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    req.nlh.nlmsg_seq = ++m_seq;
+    req.ifi.ifi_family = AF_UNSPEC;
+    sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    m_ifs.clear();
+    m_names.clear();
+    if(sendto(m_fd, &req, req.nlh.nlmsg_len, 0, (sockaddr *)&kernel,
+            sizeof kernel) < 0)
+        return false;
+    for(bool done = false; !done;) {
+        ssize_t len = recv(m_fd, m_buf, sizeof m_buf, 0);
+        if(len < 0) {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        if(!parse(len, done))
+            return false;
+    }
+    return true;
+}
+void IfCache::drain()
+{
+    for(;;) {
+        ssize_t len = recv(m_fd, m_buf, sizeof m_buf, MSG_DONTWAIT);
+        if(len > 0) {
+            bool done = false;
+            if(parse(len, done))
+                continue;
+        } else if(len == 0)
+            return;
+        else if(errno == EINTR)
+            continue;
+        else if(errno == EAGAIN || errno == EWOULDBLOCK)
+            return;
+        else if(errno != ENOBUFS) {
+            closeSock();
+            return;
+        }
+        // We lost notifications, dump again
+        if(!dump())
+            closeSock();
+        return;
+    }
+}
+bool IfCache::parse(size_t len, bool &done)
+{
+    for(nlmsghdr *nlh = (nlmsghdr *)m_buf; NLMSG_OK(nlh, len);
+        nlh = NLMSG_NEXT(nlh, len)) {
+        // Notifications do not use our sequence
+        bool reply = nlh->nlmsg_seq == m_seq;
+        switch(nlh->nlmsg_type) {
+            case NLMSG_DONE:
+                done = done || reply;
+                break;
+            case NLMSG_ERROR:
+                if(reply)
+                    return false;
+                break;
+            case RTM_NEWLINK:
+                #ifdef NLM_F_DUMP_INTR
+                // Links changed during the dump
+                if(reply && (nlh->nlmsg_flags & NLM_F_DUMP_INTR) != 0)
+                    return false;
+                #endif
+                update(nlh);
+                break;
+            case RTM_DELLINK:
+                if(nlh->nlmsg_len >= NLMSG_LENGTH(sizeof(ifinfomsg)))
+                    remove(((ifinfomsg *)NLMSG_DATA(nlh))->ifi_index);
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+void IfCache::update(nlmsghdr *nlh)
+{
+    if(nlh->nlmsg_len < NLMSG_LENGTH(sizeof(ifinfomsg)))
+        return;
+    ifinfomsg *ifi = (ifinfomsg *)NLMSG_DATA(nlh);
+    std::string name;
+    Binary mac;
+    int len = IFLA_PAYLOAD(nlh);
+    for(rtattr *rta = IFLA_RTA(ifi); RTA_OK(rta, len);
+        rta = RTA_NEXT(rta, len)) {
+        switch(rta->rta_type) {
+            case IFLA_IFNAME:
+                name.assign((const char *)RTA_DATA(rta),
+                    strnlen((const char *)RTA_DATA(rta), RTA_PAYLOAD(rta)));
+                break;
+            case IFLA_ADDRESS:
+                mac.setBin(RTA_DATA(rta), RTA_PAYLOAD(rta));
+                break;
+            default:
+                break;
+        }
+    }
+    if(name.empty())
+        return;
+    ifEntry_t &entry = m_ifs[ifi->ifi_index];
+    if(entry.name != name) {
+        // New interface or renamed one
+        if(!entry.name.empty())
+            m_names.erase(entry.name);
+        entry.name = name;
+        entry.havePtp = false;
+        m_names[name] = ifi->ifi_index;
+    }
+    entry.mac = mac;
+}
+void IfCache::remove(int ifIndex)
+{
+    auto it = m_ifs.find(ifIndex);
+    if(it == m_ifs.end())
+        return;
+    m_names.erase(it->second.name);
+    m_ifs.erase(it);
+}
+bool IfCache::get(ifEntry_t &entry, Binary &mac, int &ptpIndex)
+{
+    // Interface ioctls use the first 6 bytes of the hardware address
+    if(entry.mac.length() != EUI48)
+        return false;
+    if(!entry.havePtp) {
+        int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if(fd < 0)
+            return false;
+        ifreq ifr;
+        memset(&ifr, 0, sizeof ifr);
+        strncpy(ifr.ifr_name, entry.name.c_str(), IFNAMSIZ - 1);
+        entry.havePtp = fetchPtpIndex(fd, ifr, entry.ptpIndex);
+        close(fd);
+        if(!entry.havePtp)
+            return false;
+    }
+    mac = entry.mac;
+    ptpIndex = entry.ptpIndex;
+    return true;
+}
+bool IfCache::findName(const std::string &ifName, int &ifIndex, Binary &mac,
+    int &ptpIndex)
+{
+    std::lock_guard<std::mutex> lk(m_lock);
+    if(!open())
+        return false;
+    drain();
+    auto it = m_names.find(ifName);
+    if(it == m_names.end() || !get(m_ifs[it->second], mac, ptpIndex))
+        return false;
+    ifIndex = it->second;
+    return true;
+}
+bool IfCache::findIndex(int ifIndex, std::string &ifName, Binary &mac,
+    int &ptpIndex)
+{
+    std::lock_guard<std::mutex> lk(m_lock);
+    if(!open())
+        return false;
+    drain();
+    auto it = m_ifs.find(ifIndex);
+    if(it == m_ifs.end() || !get(it->second, mac, ptpIndex))
+        return false;
+    ifName = it->second.name;
+    return true;
+}
+
 bool IfInfo::initPtp(int fd, ifreq &ifr)
 {
     /* retrieve corresponding MAC */
@@ -179,16 +447,12 @@ bool IfInfo::initPtp(int fd, ifreq &ifr)
         return false;
     }
     m_mac.setBin(ifr.ifr_hwaddr.sa_data, EUI48);
-    ethtool_ts_info info = { .cmd = ETHTOOL_GET_TS_INFO };
-    info.phc_index = NO_SUCH_PTP;
-    ifr.ifr_data = (char *)&info;
-    if(ioctl(fd, SIOCETHTOOL, &ifr) == -1) {
+    if(!fetchPtpIndex(fd, ifr, m_ptpIndex)) {
         PTPMGMT_ERROR_P("SIOCETHTOOL");
         close(fd);
         return false;
     }
     close(fd);
-    m_ptpIndex = info.phc_index;
     m_isInit = true;
     PTPMGMT_ERROR_CLR;
     return true;
@@ -203,6 +467,12 @@ bool IfInfo::initUsingName(const std::string &ifName)
         PTPMGMT_ERROR("missing interface");
         return false;
     }
+    if(ifCache.findName(ifName, m_ifIndex, m_mac, m_ptpIndex)) {
+        m_ifName = ifName;
+        m_isInit = true;
+        PTPMGMT_ERROR_CLR;
+        return true;
+    }
     int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
     if(fd < 0) {
         PTPMGMT_ERROR_P("socket");
@@ -227,6 +497,12 @@ bool IfInfo::initUsingIndex(int ifIndex)
         PTPMGMT_ERROR("Alreay initialized");
         return false;
     }
+    if(ifCache.findIndex(ifIndex, m_ifName, m_mac, m_ptpIndex)) {
+        m_ifIndex = ifIndex;
+        m_isInit = true;
+        PTPMGMT_ERROR_CLR;
+        return true;
+    }
     int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
     if(fd < 0) {
         PTPMGMT_ERROR_P("socket");
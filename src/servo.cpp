@@ -0,0 +1,670 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Clock servos and in-process clock discipline
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include <cmath>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <pthread.h>
+#include <sched.h>
+#include "servo.h"
+#include "phcSmpl.h"
+#include "comp.h"
+#include "timeCvrt.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+// LinuxPTP defaults
+const int64_t DEF_FIRST_STEP_THRESHOLD = 20000; // 20 microseconds
+const float_freq DEF_MAX_FREQ = 500000; // 500 ppm
+const float_freq PI_KP = 0.7, PI_KP_EXP = -0.3, PI_KP_NORM_MAX = 0.7;
+const float_freq PI_KI = 0.3, PI_KI_EXP = 0.4, PI_KI_NORM_MAX = 0.3;
+// Linear regression servo
+const size_t LINREG_DEF_HORIZON = 4;
+const long double LINREG_ERR_WEIGHT = 0.1; // Prediction error smoothing
+// Clock discipline
+const size_t DISC_DEF_SAMPLES = 5;
+const size_t DISC_MAX_SAMPLES = 25;
+const float_seconds DISC_DEF_HOLDOVER = 60;
+
+Servo::Servo() : m_stepThreshold(0),
+    m_firstStepThreshold(DEF_FIRST_STEP_THRESHOLD), m_stableThreshold(0),
+    m_stableNum(0), m_stableCount(0), m_firstUpdate(true),
+    m_maxFreq(DEF_MAX_FREQ), m_interval(1)
+{
+}
+bool Servo::needStep(int64_t offset) const
+{
+    return (m_firstUpdate && m_firstStepThreshold > 0 &&
+            llabs(offset) > m_firstStepThreshold) || passStep(offset);
+}
+bool Servo::passStep(int64_t offset) const
+{
+    return m_stepThreshold > 0 && llabs(offset) > m_stepThreshold;
+}
+float_freq Servo::clamp(float_freq freq) const
+{
+    if(freq > m_maxFreq)
+        return m_maxFreq;
+    if(freq < -m_maxFreq)
+        return -m_maxFreq;
+    return freq;
+}
+float_freq Servo::sample(int64_t offset, uint64_t localTs, servoState_e &state)
+{
+    float_freq ret = doSample(offset, localTs, state);
+    switch(state) {
+        case SERVO_UNLOCKED:
+            m_stableCount = 0;
+            break;
+        case SERVO_JUMP:
+            m_stableCount = 0;
+            m_firstUpdate = false;
+            break;
+        case SERVO_LOCKED:
+            m_firstUpdate = false;
+            if(m_stableNum == 0)
+                break;
+            if(llabs(offset) < m_stableThreshold) {
+                if(m_stableCount < m_stableNum)
+                    m_stableCount++;
+            } else
+                m_stableCount = 0;
+            if(m_stableCount >= m_stableNum)
+                state = SERVO_LOCKED_STABLE;
+            break;
+        default:
+            break;
+    }
+    return ret;
+}
+void Servo::reset()
+{
+    m_stableCount = 0;
+    doReset();
+}
+bool Servo::syncInterval(float_seconds interval)
+{
+    if(!(interval > 0)) {
+        PTPMGMT_ERROR("Wrong sync interval");
+        return false;
+    }
+    m_interval = interval;
+    doSyncInterval();
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool Servo::setMaxFreq(float_freq maxFreq)
+{
+    if(!(maxFreq > 0)) {
+        PTPMGMT_ERROR("Wrong maximum frequency");
+        return false;
+    }
+    m_maxFreq = maxFreq;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+void Servo::setStableThreshold(int64_t threshold, size_t num)
+{
+    m_stableThreshold = threshold;
+    m_stableNum = num;
+    m_stableCount = 0;
+}
+
+/*
+ * The PI servo uses the LinuxPTP convention internally,
+ *  the drift is the frequency correction with the offset sign.
+ * The frequency to set on the clock is the minus of it.
+ */
+PiServo::PiServo() : m_offset{0}, m_local{0}, m_drift(0), m_kpConst(0),
+    m_kiConst(0), m_count(0)
+{
+    doSyncInterval();
+}
+float_freq PiServo::doSample(int64_t offset, uint64_t localTs,
+    servoState_e &state)
+{
+    float_freq ppb = m_drift;
+    float_freq kiTerm;
+    state = SERVO_UNLOCKED;
+    switch(m_count) {
+        case 0:
+            m_offset[0] = offset;
+            m_local[0] = localTs;
+            m_count = 1;
+            break;
+        case 1:
+            m_offset[1] = offset;
+            m_local[1] = localTs;
+            // Make sure the first sample is older than the second
+            if(m_local[0] >= m_local[1]) {
+                m_count = 0;
+                break;
+            }
+            // Wait long enough before estimating the frequency offset
+            m_drift += (float_freq)(m_offset[1] - m_offset[0]) * NSEC_PER_SEC /
+                (m_local[1] - m_local[0]);
+            m_drift = clamp(m_drift);
+            state = needStep(offset) ? SERVO_JUMP : SERVO_LOCKED;
+            ppb = m_drift;
+            m_count = 2;
+            break;
+        case 2:
+            // Reset the servo on a big offset
+            if(passStep(offset)) {
+                m_count = 0;
+                break;
+            }
+            state = SERVO_LOCKED;
+            kiTerm = m_ki * offset;
+            ppb = m_kp * offset + m_drift + kiTerm;
+            if(ppb < -m_maxFreq)
+                ppb = -m_maxFreq;
+            else if(ppb > m_maxFreq)
+                ppb = m_maxFreq;
+            else
+                m_drift += kiTerm; // Do not integrate when we saturate
+            break;
+    }
+    return -ppb;
+}
+void PiServo::doReset()
+{
+    m_count = 0;
+}
+void PiServo::doSyncInterval()
+{
+    if(m_kpConst > 0)
+        m_kp = m_kpConst;
+    else
+        m_kp = std::min(PI_KP * powl(m_interval, PI_KP_EXP),
+                PI_KP_NORM_MAX / m_interval);
+    if(m_kiConst > 0)
+        m_ki = m_kiConst;
+    else
+        m_ki = std::min(PI_KI * powl(m_interval, PI_KI_EXP),
+                PI_KI_NORM_MAX / m_interval);
+}
+void PiServo::setFreq(float_freq freq)
+{
+    m_drift = -freq;
+}
+bool PiServo::setConstants(float_freq kp, float_freq ki)
+{
+    if(kp < 0 || ki < 0) {
+        PTPMGMT_ERROR("Wrong PI constants");
+        return false;
+    }
+    m_kpConst = kp;
+    m_kiConst = ki;
+    doSyncInterval();
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+
+/*
+ * The free running offset is the offset the clock would have without
+ *  the frequency corrections the servo made.
+ * The regression of the free running offset gives the clock drift and
+ *  the expected offset, the servo sets a frequency that removes the
+ *  drift and corrects the offset in the horizon time.
+ */
+LinRegServo::LinRegServo() : m_numPoints(0), m_lastPoint(0), m_err{0},
+    m_base(0), m_last(0), m_corr(0), m_freq(0),
+    m_horizon(LINREG_DEF_HORIZON), m_count(0)
+{
+}
+bool LinRegServo::regress(size_t size, float_freq &slope,
+    float_nanoseconds &yhat, float_seconds x) const
+{
+    if(size < 2 || size > m_numPoints)
+        return false;
+    long double xm = 0, ym = 0;
+    for(size_t i = 0, j = m_lastPoint; i < size; i++) {
+        xm += m_points[j].x;
+        ym += m_points[j].y;
+        j = (j + MAX_POINTS - 1) % MAX_POINTS;
+    }
+    xm /= size;
+    ym /= size;
+    long double sxx = 0, sxy = 0;
+    for(size_t i = 0, j = m_lastPoint; i < size; i++) {
+        long double dx = m_points[j].x - xm;
+        sxx += dx * dx;
+        sxy += dx * (m_points[j].y - ym);
+        j = (j + MAX_POINTS - 1) % MAX_POINTS;
+    }
+    if(sxx <= 0)
+        return false;
+    slope = sxy / sxx;
+    yhat = ym + slope * (x - xm);
+    return true;
+}
+void LinRegServo::clearPoints()
+{
+    m_numPoints = 0;
+    m_lastPoint = 0;
+    for(size_t i = 0; i < NUM_SIZES; i++)
+        m_err[i] = 0;
+}
+float_freq LinRegServo::doSample(int64_t offset, uint64_t localTs,
+    servoState_e &state)
+{
+    state = SERVO_UNLOCKED;
+    if(m_count > 0 && localTs <= m_last) {
+        // Local time goes backward, start over
+        clearPoints();
+        m_count = 0;
+    }
+    if(m_count == 0) {
+        m_base = localTs;
+        m_corr = 0;
+    } else
+        m_corr += m_freq * (float_seconds)(localTs - m_last) / NSEC_PER_SEC;
+    m_last = localTs;
+    float_seconds x = (float_seconds)(localTs - m_base) / NSEC_PER_SEC;
+    float_nanoseconds y = offset - m_corr;
+    float_freq slope;
+    float_nanoseconds yhat;
+    // Update the prediction error of each regression size
+    for(size_t i = 0; i < NUM_SIZES; i++) {
+        if(!regress(4 << i, slope, yhat, x))
+            continue;
+        long double err = (yhat - y) * (yhat - y);
+        if(m_err[i] == 0)
+            m_err[i] = err;
+        else
+            m_err[i] += (err - m_err[i]) * LINREG_ERR_WEIGHT;
+    }
+    m_lastPoint = (m_lastPoint + 1) % MAX_POINTS;
+    m_points[m_lastPoint] = { x, y };
+    if(m_numPoints < MAX_POINTS)
+        m_numPoints++;
+    m_count++;
+    // Use the size with the smallest prediction error
+    size_t size = m_numPoints < 4 ? m_numPoints : 4;
+    long double best = -1;
+    for(size_t i = 0; i < NUM_SIZES && (4U << i) <= m_numPoints; i++) {
+        if(m_err[i] > 0 && (best < 0 || m_err[i] < best)) {
+            best = m_err[i];
+            size = 4 << i;
+        }
+    }
+    if(!regress(size, slope, yhat, x))
+        return m_freq;
+    if(m_count == 2 && needStep(offset)) {
+        // Remove the drift and step the clock
+        m_freq = clamp(-slope);
+        clearPoints();
+        m_count = 0;
+        state = SERVO_JUMP;
+        return m_freq;
+    }
+    if(passStep(offset)) {
+        clearPoints();
+        m_count = 0;
+        return m_freq;
+    }
+    float_seconds horizon = m_interval * m_horizon;
+    m_freq = clamp(-(slope + (yhat + m_corr) / horizon));
+    state = SERVO_LOCKED;
+    return m_freq;
+}
+void LinRegServo::doReset()
+{
+    clearPoints();
+    m_count = 0;
+}
+void LinRegServo::setFreq(float_freq freq)
+{
+    m_freq = freq;
+}
+bool LinRegServo::setHorizon(size_t intervals)
+{
+    if(intervals == 0) {
+        PTPMGMT_ERROR("Wrong horizon");
+        return false;
+    }
+    m_horizon = intervals;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+
+class ClockDiscipline::Loop
+{
+  public:
+    std::thread thread;
+    mutable std::mutex lock; // Protect status and quit
+    std::condition_variable wake;
+    std::chrono::steady_clock::time_point lastGood;
+    PhcCrossTs target, source;
+    bool primed; // Servo uses the target clock frequency
+    bool quit;
+    bool running;
+    Loop() : primed(false), quit(false), running(false) {}
+    void run(ClockDiscipline &disc);
+};
+
+void ClockDiscipline::Loop::run(ClockDiscipline &disc)
+{
+    auto next = std::chrono::steady_clock::now();
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>
+        (std::chrono::duration<long double>(disc.m_interval));
+    std::unique_lock<std::mutex> lk(lock);
+    while(!quit) {
+        lk.unlock();
+        disc.update();
+        lk.lock();
+        next += interval;
+        wake.wait_until(lk, next, [this] { return quit; });
+    }
+}
+ClockDiscipline::ClockDiscipline() : m_loop(new Loop), m_servo(new PiServo),
+    m_target(nullptr), m_source(nullptr), m_cb(nullptr), m_status{},
+    m_interval(1), m_holdover(DISC_DEF_HOLDOVER), m_samples(DISC_DEF_SAMPLES),
+    m_priority(0), m_cpu(-1), m_init(false)
+{
+}
+ClockDiscipline::~ClockDiscipline()
+{
+    stop();
+}
+#define CHECK_RUNNING do {\
+        if(isRunning()) {\
+            PTPMGMT_ERROR("Discipline is running");\
+            return false;\
+        } } while(0)
+bool ClockDiscipline::setClocks(const PtpClock *target, const PtpClock *source)
+{
+    CHECK_RUNNING;
+    if(target == nullptr && source == nullptr) {
+        PTPMGMT_ERROR("Can not synchronize system clock to itself");
+        return false;
+    }
+    if(target == source ||
+        (target != nullptr && source != nullptr &&
+            target->device() == source->device())) {
+        PTPMGMT_ERROR("Can not synchronize clock to itself");
+        return false;
+    }
+    if((target != nullptr && !target->isInit()) ||
+        (source != nullptr && !source->isInit())) {
+        PTPMGMT_ERROR("Clock is not initialized");
+        return false;
+    }
+    if((target != nullptr && !m_loop->target.setClock(target)) ||
+        (source != nullptr && !m_loop->source.setClock(source)))
+        return false;
+    m_target = target;
+    m_source = source;
+    m_loop->primed = false;
+    m_servo->reset();
+    m_init = true;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool ClockDiscipline::setServo(Servo *servo)
+{
+    if(servo == nullptr) {
+        PTPMGMT_ERROR("Missing servo");
+        return false;
+    }
+    if(isRunning()) {
+        delete servo;
+        PTPMGMT_ERROR("Discipline is running");
+        return false;
+    }
+    m_servo.reset(servo);
+    m_loop->primed = false;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool ClockDiscipline::setInterval(float_seconds interval)
+{
+    CHECK_RUNNING;
+    if(!(interval > 0)) {
+        PTPMGMT_ERROR("Wrong interval");
+        return false;
+    }
+    m_interval = interval;
+    m_loop->primed = false;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool ClockDiscipline::setHoldover(float_seconds holdover)
+{
+    CHECK_RUNNING;
+    if(holdover < 0) {
+        PTPMGMT_ERROR("Wrong holdover");
+        return false;
+    }
+    m_holdover = holdover;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool ClockDiscipline::setSamples(size_t samples)
+{
+    CHECK_RUNNING;
+    if(samples == 0 || samples > DISC_MAX_SAMPLES) {
+        PTPMGMT_ERROR("Wrong number of samples %zu", samples);
+        return false;
+    }
+    m_samples = samples;
+    m_loop->target.setSamples(samples);
+    m_loop->source.setSamples(samples);
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool ClockDiscipline::setPriority(int priority)
+{
+    CHECK_RUNNING;
+    if(priority < 0 || priority > sched_get_priority_max(SCHED_FIFO)) {
+        PTPMGMT_ERROR("Wrong priority %d", priority);
+        return false;
+    }
+    m_priority = priority;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+bool ClockDiscipline::setCpu(int cpu)
+{
+    CHECK_RUNNING;
+    if(cpu >= CPU_SETSIZE) {
+        PTPMGMT_ERROR("Wrong CPU %d", cpu);
+        return false;
+    }
+    m_cpu = cpu;
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+const BaseClock &ClockDiscipline::target() const
+{
+    if(m_target == nullptr)
+        return m_sys;
+    return *m_target;
+}
+bool ClockDiscipline::measure(int64_t &offset, int64_t &delay,
+    Timestamp_t &ts)
+{
+    PhcClockSample_t t, s;
+    if(m_target != nullptr && !m_loop->target.sample(t))
+        return false;
+    if(m_source != nullptr && !m_loop->source.sample(s))
+        return false;
+    if(m_target == nullptr) {
+        // System clock offset from the PHC
+        offset = -s.offset;
+        delay = s.delay;
+        ts = s.sysClk;
+    } else if(m_source == nullptr) {
+        offset = t.offset;
+        delay = t.delay;
+        ts = t.sysClk;
+    } else {
+        // The system clock cancels out
+        offset = t.offset - s.offset;
+        delay = std::max(t.delay, s.delay);
+        ts = t.sysClk;
+    }
+    return true;
+}
+void ClockDiscipline::setState(DisciplineState_e state)
+{
+    DisciplineStatus_t status;
+    {
+        std::lock_guard<std::mutex> lk(m_loop->lock);
+        if(m_status.state == state)
+            return;
+        m_status.state = state;
+        status = m_status;
+    }
+    if(m_cb != nullptr)
+        m_cb->stateChange(status);
+}
+bool ClockDiscipline::update()
+{
+    if(!m_init) {
+        PTPMGMT_ERROR("Clocks are not set");
+        return false;
+    }
+    Loop &loop = *m_loop;
+    const BaseClock &clk = target();
+    if(!loop.primed) {
+        m_servo->syncInterval(m_interval);
+        PtpCaps_t caps;
+        if(m_target != nullptr && m_target->fetchCaps(caps) && caps.max_ppb > 0)
+            m_servo->setMaxFreq(caps.max_ppb);
+        m_servo->setFreq(clk.getFreq());
+        loop.lastGood = std::chrono::steady_clock::now();
+        loop.primed = true;
+    }
+    int64_t offset, delay;
+    Timestamp_t ts;
+    if(!measure(offset, delay, ts)) {
+        DisciplineState_e state;
+        {
+            std::lock_guard<std::mutex> lk(loop.lock);
+            state = m_status.state;
+        }
+        auto elapsed = std::chrono::duration<long double>
+            (std::chrono::steady_clock::now() - loop.lastGood).count();
+        if(state == DISCIPLINE_LOCKED)
+            setState(DISCIPLINE_HOLDOVER);
+        else if(state == DISCIPLINE_HOLDOVER && elapsed >= m_holdover) {
+            m_servo->reset();
+            setState(DISCIPLINE_UNLOCKED);
+        }
+        PTPMGMT_ERROR("Fail to measure clocks offset");
+        return false;
+    }
+    loop.lastGood = std::chrono::steady_clock::now();
+    servoState_e servo;
+    float_freq freq = m_servo->sample(offset, ts.toNanoseconds(), servo);
+    bool ret = true;
+    switch(servo) {
+        case SERVO_JUMP:
+            ret = clk.setFreq(freq) && clk.offsetClock(-offset);
+            break;
+        case SERVO_LOCKED:
+        case SERVO_LOCKED_STABLE:
+            ret = clk.setFreq(freq);
+            break;
+        default:
+            break;
+    }
+    DisciplineStatus_t status;
+    {
+        std::lock_guard<std::mutex> lk(loop.lock);
+        m_status.servo = servo;
+        m_status.offset = offset;
+        m_status.delay = delay;
+        if(servo != SERVO_UNLOCKED && ret)
+            m_status.freq = freq;
+        m_status.updates++;
+        m_status.time = ts;
+    }
+    setState(servo == SERVO_LOCKED || servo == SERVO_LOCKED_STABLE ?
+        DISCIPLINE_LOCKED : DISCIPLINE_UNLOCKED);
+    if(m_cb != nullptr) {
+        status = getStatus();
+        m_cb->update(status);
+    }
+    if(ret)
+        PTPMGMT_ERROR_CLR;
+    return ret;
+}
+bool ClockDiscipline::start()
+{
+    if(isRunning()) {
+        PTPMGMT_ERROR_CLR;
+        return true;
+    }
+    if(!m_init) {
+        PTPMGMT_ERROR("Clocks are not set");
+        return false;
+    }
+    Loop &loop = *m_loop;
+    loop.quit = false;
+    loop.running = true;
+    loop.thread = std::thread(&Loop::run, &loop, std::ref(*this));
+    pthread_t thread = loop.thread.native_handle();
+    if(m_cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(m_cpu, &set);
+        int err = pthread_setaffinity_np(thread, sizeof set, &set);
+        if(err != 0) {
+            stop();
+            errno = err;
+            PTPMGMT_ERROR_P("pthread_setaffinity_np");
+            return false;
+        }
+    }
+    if(m_priority > 0) {
+        sched_param param = {};
+        param.sched_priority = m_priority;
+        int err = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if(err != 0) {
+            stop();
+            errno = err;
+            PTPMGMT_ERROR_P("pthread_setschedparam");
+            return false;
+        }
+    }
+    PTPMGMT_ERROR_CLR;
+    return true;
+}
+void ClockDiscipline::stop()
+{
+    Loop &loop = *m_loop;
+    if(!loop.running)
+        return;
+    {
+        std::lock_guard<std::mutex> lk(loop.lock);
+        loop.quit = true;
+    }
+    loop.wake.notify_all();
+    if(loop.thread.joinable())
+        loop.thread.join();
+    loop.running = false;
+}
+bool ClockDiscipline::isRunning() const
+{
+    return m_loop->running;
+}
+DisciplineStatus_t ClockDiscipline::getStatus() const
+{
+    std::lock_guard<std::mutex> lk(m_loop->lock);
+    return m_status;
+}
+
+__PTPMGMT_NAMESPACE_END
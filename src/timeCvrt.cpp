@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Batch conversion of clock times
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * @details
+ *  The loops are kept simple, with no branches or function calls,
+ *  so the compiler vectorizes them for the target architecture.
+ */
+
+#include <linux/ptp_clock.h>
+#include "timeCvrt.h"
+#include "types.h"
+
+__PTPMGMT_NAMESPACE_BEGIN
+
+void timeToNanoseconds(const Timestamp_t *ts, int64_t *ns, size_t num)
+{
+    for(size_t i = 0; i < num; i++)
+        ns[i] = (int64_t)ts[i].secondsField * NSEC_PER_SEC +
+            ts[i].nanosecondsField;
+}
+void timeToNanoseconds(const ptp_clock_time *ts, int64_t *ns, size_t num)
+{
+    for(size_t i = 0; i < num; i++)
+        ns[i] = ts[i].sec * NSEC_PER_SEC + ts[i].nsec;
+}
+void timeDiffNanoseconds(const Timestamp_t *a, const Timestamp_t *b,
+    int64_t *diff, size_t num)
+{
+    for(size_t i = 0; i < num; i++)
+        diff[i] = ((int64_t)a[i].secondsField - (int64_t)b[i].secondsField) *
+            NSEC_PER_SEC + (int64_t)a[i].nanosecondsField -
+            (int64_t)b[i].nanosecondsField;
+}
+void timeDiffNanoseconds(const ptp_clock_time *a, const ptp_clock_time *b,
+    int64_t *diff, size_t num)
+{
+    for(size_t i = 0; i < num; i++)
+        diff[i] = (a[i].sec - b[i].sec) * NSEC_PER_SEC +
+            (int64_t)a[i].nsec - (int64_t)b[i].nsec;
+}
+
+__PTPMGMT_NAMESPACE_END
@@ -682,6 +682,25 @@ cpp_cod(`     * @param[in] seconds')dnl
 cpp_cod(`     * @return reference to itself')dnl
 cpp_cod(`     */')dnl
 cpp_cod(`    Timestamp_t &subt(float_seconds seconds) { return add(-seconds); }')dnl
+cpp_cod(`    /**')dnl
+cpp_cod(`     * Add nanoseconds')dnl
+cpp_cod(`     * @param[in] nanoseconds to add, negative to subtract')dnl
+cpp_cod(`     * @return reference to itself')dnl
+cpp_cod(`     * @note use integer arithmetic only')dnl
+cpp_cod(`     */')dnl
+cpp_cod(`    Timestamp_t &addNanoseconds(int64_t nanoseconds);')dnl
+cpp_cod(`    /**')dnl
+cpp_cod(`     * Get difference from another clock time in nanoseconds')dnl
+cpp_cod(`     * @param[in] ts another clock time')dnl
+cpp_cod(`     * @return this time minus the other time in nanoseconds')dnl
+cpp_cod(`     * @note use integer arithmetic only')dnl
+cpp_cod(`     * @note the difference must be smaller than 292 years')dnl
+cpp_cod(`     */')dnl
+cpp_cod(`    int64_t diffNanoseconds(const Timestamp_t &ts) const {')dnl
+cpp_cod(`        return ((int64_t)secondsField - (int64_t)ts.secondsField) *')dnl
+cpp_cod(`            1000000000 + (int64_t)nanosecondsField -')dnl
+cpp_cod(`            (int64_t)ts.nanosecondsField;')dnl
+cpp_cod(`    }')dnl
 };
 /** PTP clock ID */
 strc(ClockIdentity_t) {
@@ -951,6 +970,7 @@ c_cod(`    /**< @endcond */')dnl
     bool rcvSignaling; /**< parse signaling messages */
     bool filterSignaling; /**< use filter for signaling messages TLVs */
     bool rcvSMPTEOrg; /**< parse SMPTE Organization Extension TLV */
+cpp_cod(`    bool rcvRequests; /**< parse management requests, for a responder */')dnl
 cpp_cod(`    MsgParams();')dnl
     /** Add TLV type to allowed signalling filter */
 cpp_cod(`    void allowSigTlv(tlvType_e type);')dnl
@@ -966,6 +986,7 @@ cpp_cod(`    size_t countSigTlvs() const;')dnl
 c_cod(`    size_t (*countSigTlvs)(ptpmgmt_cpMsgParams m);')dnl
 c_cod(`    /** Free structure object */')dnl
 c_cod(`    void (*free)(ptpmgmt_pMsgParams m);')dnl
+c_cod(`    bool rcvRequests; /**< parse management requests, for a responder */')dnl
 cpp_cod(`  private:')dnl
 cpp_cod(`    /** when filter TLVs in signalling messages')dnl
 cpp_cod(`     * allow TLVs that are in the map, the bool value is ignored */')dnl
@@ -1148,6 +1148,19 @@ Test(MessageTest, MethodIsEmpty)
     m->free(m);
 }
 
+// test if management TLV id applies to a port
+// bool ptpmgmt_msg_isPortScope(enum ptpmgmt_mng_vals_e id)
+// bool isPortScope(enum ptpmgmt_mng_vals_e id)
+Test(MessageTest, MethodIsPortScope)
+{
+    ptpmgmt_msg m = ptpmgmt_msg_alloc();
+    cr_expect(ptpmgmt_msg_isPortScope(PTPMGMT_PORT_DATA_SET));
+    cr_expect(not(ptpmgmt_msg_isPortScope(PTPMGMT_DEFAULT_DATA_SET)));
+    cr_expect(m->isPortScope(PTPMGMT_PORT_STATS_NP));
+    cr_expect(not(m->isPortScope(PTPMGMT_TIME_STATUS_NP)));
+    m->free(m);
+}
+
 // Test if management TLV is valid for use method
 // bool isValidId(const_ptpmgmt_msg m, enum ptpmgmt_mng_vals_e id)
 Test(MessageTest, MethodIsValidId)
@@ -16,6 +16,7 @@
 #include <cerrno>
 #include <climits>
 #include <map>
+#include <deque>
 #include <stdarg.h>
 #include <time.h>
 #include <pwd.h>
@@ -39,6 +40,8 @@
 #include <linux/sockios.h>
 #include <linux/ptp_clock.h>
 #include <linux/ethtool.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 /*****************************************************************************/
 static bool didInit = false;
 static bool testMode = false;
@@ -202,6 +205,124 @@ static inline clockid_t fd_to_clockid(int fd)
     *(int *)optval != v)\
     return retErr(EINVAL); break
 /*****************************************************************************/
+/*
+ * Emulate the rtnetlink link messages for the interfaces cache.
+ * The cache is process wide and keeps its socket between tests,
+ *  so the netlink state is not reset with the test mode.
+ */
+struct nlLink_t {
+    std::string name;
+    uint8_t mac[6];
+    int ptpIndex;
+};
+static std::map<int, nlLink_t> nlLinks = {
+    {7, {"eth0", { 1, 2, 3, 4, 5, 6 }, 3}}
+};
+static std::deque<std::string> nlRx; // Pending datagrams
+static int nlFd = -1;
+static int nlErr = 0;
+static bool nlFail = false;
+static int nlSockets = 0;
+static void nlAddAttr(char *buf, size_t &len, uint16_t type, const void *data,
+    size_t size)
+{
+    rtattr *rta = (rtattr *)(buf + NLMSG_ALIGN(len));
+    rta->rta_type = type;
+    rta->rta_len = RTA_LENGTH(size);
+    memcpy(RTA_DATA(rta), data, size);
+    len = NLMSG_ALIGN(len) + RTA_ALIGN(rta->rta_len);
+}
+static void nlAddMsg(std::string &out, uint16_t type, uint32_t seq,
+    int ifIndex)
+{
+    alignas(nlmsghdr) char buf[256] = { 0 };
+    nlmsghdr *nlh = (nlmsghdr *)buf;
+    nlh->nlmsg_type = type;
+    nlh->nlmsg_seq = seq;
+    nlh->nlmsg_flags = seq != 0 ? NLM_F_MULTI : 0;
+    size_t len;
+    if(type == NLMSG_DONE)
+        len = NLMSG_LENGTH(sizeof(int));
+    else {
+        ifinfomsg *ifi = (ifinfomsg *)NLMSG_DATA(nlh);
+        ifi->ifi_family = AF_UNSPEC;
+        ifi->ifi_index = ifIndex;
+        len = NLMSG_LENGTH(sizeof(ifinfomsg));
+        if(type == RTM_NEWLINK) {
+            const nlLink_t &lnk = nlLinks[ifIndex];
+            nlAddAttr(buf, len, IFLA_IFNAME, lnk.name.c_str(),
+                lnk.name.length() + 1);
+            nlAddAttr(buf, len, IFLA_ADDRESS, lnk.mac, sizeof lnk.mac);
+        }
+    }
+    nlh->nlmsg_len = len;
+    out.append(buf, NLMSG_ALIGN(len));
+}
+void nlNewLink(int ifIndex, const char *name, const uint8_t *mac,
+    int ptpIndex)
+{
+    nlLink_t &lnk = nlLinks[ifIndex];
+    lnk.name = name;
+    memcpy(lnk.mac, mac, sizeof lnk.mac);
+    lnk.ptpIndex = ptpIndex;
+    std::string msg;
+    nlAddMsg(msg, RTM_NEWLINK, 0, ifIndex);
+    nlRx.push_back(msg);
+}
+void nlDelLink(int ifIndex)
+{
+    nlLinks.erase(ifIndex);
+    std::string msg;
+    nlAddMsg(msg, RTM_DELLINK, 0, ifIndex);
+    nlRx.push_back(msg);
+}
+void nlRecvError(int err) {nlErr = err;}
+void nlSocketFail(bool n) {nlFail = n;}
+int nlSocketCount(void) {return nlSockets;}
+static int nlBind(const sockaddr *addr, socklen_t addrlen)
+{
+    const sockaddr_nl *nl = (const sockaddr_nl *)addr;
+    if(addr == nullptr || addrlen != sizeof(sockaddr_nl) ||
+        nl->nl_family != AF_NETLINK || nl->nl_groups != RTMGRP_LINK)
+        return retErr(EINVAL);
+    return 0;
+}
+static ssize_t nlSend(const void *buf, size_t len)
+{
+    const nlmsghdr *nlh = (const nlmsghdr *)buf;
+    if(len < NLMSG_LENGTH(sizeof(ifinfomsg)) ||
+        nlh->nlmsg_type != RTM_GETLINK ||
+        nlh->nlmsg_flags != (NLM_F_REQUEST | NLM_F_DUMP))
+        return retErr(EINVAL);
+    // Links and done in separate datagrams
+    std::string msg;
+    for(auto &it : nlLinks)
+        nlAddMsg(msg, RTM_NEWLINK, nlh->nlmsg_seq, it.first);
+    nlRx.push_back(msg);
+    msg.clear();
+    nlAddMsg(msg, NLMSG_DONE, nlh->nlmsg_seq, 0);
+    nlRx.push_back(msg);
+    return len;
+}
+static ssize_t nlRecv(void *buf, size_t len, int flags)
+{
+    if(nlErr != 0) {
+        int err = nlErr;
+        nlErr = 0;
+        // The kernel dropped the notifications
+        if(err == ENOBUFS)
+            nlRx.clear();
+        return retErr(err);
+    }
+    if(nlRx.empty())
+        return retErr(flags & MSG_DONTWAIT ? EAGAIN : ECONNRESET);
+    std::string msg = nlRx.front();
+    nlRx.pop_front();
+    len = std::min(len, msg.length());
+    memcpy(buf, msg.c_str(), len);
+    return len;
+}
+/*****************************************************************************/
 int socket(int domain, int type, int protocol)
 {
     retTest(socket, domain, type, protocol);
@@ -215,6 +336,15 @@ int socket(int domain, int type, int protocol)
         case AF_PACKET:
             add = type == SOCK_RAW;
             break;
+        case AF_NETLINK:
+            if(protocol != NETLINK_ROUTE || (type & SOCK_RAW) != SOCK_RAW)
+                return retErr(EPROTONOSUPPORT);
+            nlSockets++;
+            if(nlFail)
+                return retErr(EAFNOSUPPORT);
+            nlFd = _socket(AF_INET, SOCK_DGRAM, 0);
+            nlRx.clear();
+            return nlFd;
         default:
             break;
     }
@@ -229,6 +359,8 @@ int socket(int domain, int type, int protocol)
 }
 int close(int fd)
 {
+    if(fd == nlFd)
+        nlFd = -1;
     if(testMode && fdesc.count(fd) > 0) {
         clockid_t clkID = fdesc[fd].clkID;
         if(clkID != 0) {
@@ -264,6 +396,8 @@ const uint8_t ip6_addr_b[28] = { 10, 0, 1, 64 };
 const uint8_t raw_addr_b[20] = { 17, 0, 0, 3, 7 };
 int bind(int fd, const sockaddr *addr, socklen_t addrlen)
 {
+    if(testMode && fd == nlFd)
+        return nlBind(addr, addrlen);
     retSock(bind, addr, addrlen);
     if(addr == nullptr || addrlen <= 0)
         return retErr(EINVAL);
@@ -382,6 +516,8 @@ ssize_t recvFill(void *buf, size_t len, int flags)
 }
 ssize_t recv(int fd, void *buf, size_t len, int flags)
 {
+    if(testMode && fd == nlFd)
+        return nlRecv(buf, len, flags);
     retSock(recv, buf, len, flags);
     if(buf == nullptr || len == 0)
         return retErr(ENOMEM);
@@ -433,6 +569,8 @@ const uint8_t ip6_addr_s[28] = { 10, 0, 1, 64, 0, 0, 0, 0, 255, 15, 0, 0,
 ssize_t sendto(int fd, const void *buf, size_t len, int flags,
     const sockaddr *addr, socklen_t addrlen)
 {
+    if(testMode && fd == nlFd)
+        return nlSend(buf, len);
     retSock(sendto, buf, len, flags, addr, addrlen);
     if(buf == nullptr || len == 0)
         return retErr(ENOMEM);
@@ -768,16 +906,21 @@ int ioctl(int fd, unsigned long request, ...)
                 return retErr(EINVAL);
             memcpy(ifr->ifr_hwaddr.sa_data, "\x1\x2\x3\x4\x5\x6", 6);
             break;
-        case SIOCETHTOOL:
-            if(strcmp("eth0", ifr->ifr_name) != 0)
-                return retErr(EINVAL);
-            {
-                ethtool_ts_info *info = (ethtool_ts_info *)ifr->ifr_data;
-                if(info == nullptr || info->cmd != ETHTOOL_GET_TS_INFO)
-                    return retErr(EINVAL);
-                info->phc_index = 3;
+        case SIOCETHTOOL: {
+            // Interfaces of the netlink emulation
+            const nlLink_t *lnk = nullptr;
+            for(auto &it : nlLinks) {
+                if(it.second.name == ifr->ifr_name)
+                    lnk = &it.second;
             }
+            if(lnk == nullptr)
+                return retErr(EINVAL);
+            ethtool_ts_info *info = (ethtool_ts_info *)ifr->ifr_data;
+            if(info == nullptr || info->cmd != ETHTOOL_GET_TS_INFO)
+                return retErr(EINVAL);
+            info->phc_index = lnk->ptpIndex;
             break;
+        }
         case SIOCGIFINDEX:
             if(strcmp("eth0", ifr->ifr_name) != 0)
                 return retErr(EINVAL);
@@ -9,12 +9,20 @@
  *
  */
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 extern void initLibSys(void);
 extern void useTestMode(bool);
 extern void useRoot(bool);
+extern void nlNewLink(int ifIndex, const char *name, const uint8_t *mac,
+    int ptpIndex);
+extern void nlDelLink(int ifIndex);
+extern void nlRecvError(int err);
+extern void nlSocketFail(bool);
+extern int nlSocketCount(void);
 #ifdef __cplusplus
 }
 #endif
@@ -63,6 +63,7 @@ TEST(MessageTest, MethodGetParams)
     EXPECT_EQ(p.rcvSignaling, p1.rcvSignaling);
     EXPECT_EQ(p.filterSignaling, p1.filterSignaling);
     EXPECT_EQ(p.rcvSMPTEOrg, p1.rcvSMPTEOrg);
+    EXPECT_EQ(p.rcvRequests, p1.rcvRequests);
 }
 
 // Tests set parameters method
@@ -88,6 +89,7 @@ TEST(MessageTest, MethodUpdateParams)
     EXPECT_EQ(p.rcvSignaling, p1.rcvSignaling);
     EXPECT_EQ(p.filterSignaling, p1.filterSignaling);
     EXPECT_EQ(p.rcvSMPTEOrg, p1.rcvSMPTEOrg);
+    EXPECT_EQ(p.rcvRequests, p1.rcvRequests);
 }
 
 // Tests get parsed TLV ID method
@@ -817,6 +819,20 @@ TEST(MessageTest, MethodIsEmpty)
     EXPECT_FALSE(Message::isEmpty(POWER_PROFILE_SETTINGS_NP));
 }
 
+// test if management TLV id applies to a port
+// static bool isPortScope(mng_vals_e id)
+TEST(MessageTest, MethodIsPortScope)
+{
+    EXPECT_TRUE(Message::isPortScope(NULL_PTP_MANAGEMENT));
+    EXPECT_TRUE(Message::isPortScope(CLOCK_DESCRIPTION));
+    EXPECT_TRUE(Message::isPortScope(PORT_DATA_SET));
+    EXPECT_TRUE(Message::isPortScope(PORT_STATS_NP));
+    EXPECT_FALSE(Message::isPortScope(DEFAULT_DATA_SET));
+    EXPECT_FALSE(Message::isPortScope(PRIORITY1));
+    EXPECT_FALSE(Message::isPortScope(TIME_STATUS_NP));
+    EXPECT_FALSE(Message::isPortScope(LAST_MNG_ID));
+}
+
 // Test if management TLV is valid for use method
 // bool isValidId(mng_vals_e id)
 TEST(MessageTest, MethodIsValidId)
@@ -860,6 +876,57 @@ TEST(MessageTest, MethodSetAction)
     EXPECT_EQ(m.getBuildTlvId(), PRIORITY1);
     EXPECT_EQ(m.getSendAction(), SET);
     m.clearData();
+    // Responder actions
+    EXPECT_TRUE(m.setAction(RESPONSE, PRIORITY1, &p));
+    EXPECT_EQ(m.getSendAction(), RESPONSE);
+    EXPECT_FALSE(m.setAction(RESPONSE, PRIORITY1));
+    EXPECT_TRUE(m.setAction(ACKNOWLEDGE, ENABLE_PORT));
+    EXPECT_FALSE(m.setAction(ACKNOWLEDGE, PRIORITY1, &p));
+    EXPECT_FALSE(m.setAction(RESPONSE, ENABLE_PORT));
+    m.clearData();
+}
+
+// Test parse requests and build responses
+TEST(MessageTest, MethodResponder)
+{
+    Message m;
+    MsgParams prms = m.getParams();
+    PRIORITY1_t p;
+    p.priority1 = 0x7f;
+    uint8_t buf[70];
+    EXPECT_TRUE(m.setAction(SET, PRIORITY1, &p));
+    EXPECT_EQ(m.build(buf, sizeof buf, 137), MNG_PARSE_ERROR_OK);
+    // Requests are ignored by default
+    EXPECT_EQ(m.parse(buf, 56), MNG_PARSE_ERROR_ACTION);
+    prms.rcvRequests = true;
+    EXPECT_TRUE(m.updateParams(prms));
+    EXPECT_EQ(m.parse(buf, 56), MNG_PARSE_ERROR_OK);
+    EXPECT_EQ(m.getReplyAction(), SET);
+    EXPECT_EQ(m.getTlvId(), PRIORITY1);
+    EXPECT_EQ(m.getSequence(), 137);
+    const PRIORITY1_t *r = dynamic_cast<const PRIORITY1_t *>(m.getData());
+    ASSERT_NE(r, nullptr);
+    EXPECT_EQ(r->priority1, 0x7f);
+    EXPECT_TRUE(m.setAction(GET, PRIORITY1));
+    EXPECT_EQ(m.build(buf, sizeof buf, 138), MNG_PARSE_ERROR_OK);
+    EXPECT_EQ(m.parse(buf, m.getMsgLen()), MNG_PARSE_ERROR_OK);
+    EXPECT_EQ(m.getReplyAction(), GET);
+    EXPECT_EQ(m.getData(), nullptr);
+    // GET of a command only TLV
+    buf[53] = 0xd; // ENABLE_PORT
+    EXPECT_EQ(m.parse(buf, m.getMsgLen()), MNG_PARSE_ERROR_ACTION);
+    // Build the response
+    p.priority1 = 12;
+    EXPECT_TRUE(m.setAction(RESPONSE, PRIORITY1, &p));
+    EXPECT_EQ(m.build(buf, sizeof buf, 138), MNG_PARSE_ERROR_OK);
+    EXPECT_EQ(buf[46], RESPONSE);
+    prms.rcvRequests = false;
+    EXPECT_TRUE(m.updateParams(prms));
+    EXPECT_EQ(m.parse(buf, m.getMsgLen()), MNG_PARSE_ERROR_OK);
+    EXPECT_EQ(m.getReplyAction(), RESPONSE);
+    r = dynamic_cast<const PRIORITY1_t *>(m.getData());
+    ASSERT_NE(r, nullptr);
+    EXPECT_EQ(r->priority1, 12);
 }
 
 // Test clear Data
@@ -116,6 +116,31 @@ TEST(Msg2JsonTest, MngTlv)
         "}");
 }
 
+// Test PTP message with a managment TLV in compact form
+TEST(Msg2JsonTest, MngTlvCompact)
+{
+    uint8_t buf[70];
+    Message m;
+    USER_DESCRIPTION_t t;
+    t.userDescription.textField = "test 123";
+    EXPECT_TRUE(m.setAction(SET, USER_DESCRIPTION, &t));
+    EXPECT_EQ(m.build(buf, sizeof buf, 1), MNG_PARSE_ERROR_OK);
+    EXPECT_EQ(m.getMsgLen(), 64);
+    buf[46] = RESPONSE;
+    ASSERT_EQ(m.parse(buf, 64), MNG_PARSE_ERROR_OK);
+    EXPECT_STREQ(msg2json(m, -1).c_str(),
+        "{\"sequenceId\":1,\"sdoId\":0,\"domainNumber\":0,"
+        "\"versionPTP\":2,\"minorVersionPTP\":0,\"unicastFlag\":true,"
+        "\"PTPProfileSpecific\":0,\"messageType\":\"Management\","
+        "\"sourcePortIdentity\":{\"clockIdentity\":\"000000.0000.000000\","
+        "\"portNumber\":0},"
+        "\"targetPortIdentity\":{\"clockIdentity\":\"ffffff.ffff.ffffff\","
+        "\"portNumber\":65535},"
+        "\"actionField\":\"RESPONSE\",\"tlvType\":\"MANAGEMENT\","
+        "\"managementId\":\"USER_DESCRIPTION\","
+        "\"dataField\":{\"userDescription\":\"test 123\"}}");
+}
+
 // Test PTP message with a managment error TLV
 TEST(Msg2JsonTest, MngErrTlv)
 {
@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Capture file reader unit test
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include <unistd.h>
+#include "pcap.h"
+#include "msg.h"
+#include "comp.h"
+
+__PTPMGMT_NAMESPACE_USE;
+
+// Management response header, 48 octets, message length 54
+static const uint8_t ptpMsg[] = { 0x0d, 0x02, 0, 54, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 1, 0, 7, 4, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0, 0, 2, 0, 0, 1, 0, 2, 0, 0 // NULL_PTP_MANAGEMENT
+    };
+static const uint8_t macs[] = { 1, 0x1b, 0x19, 0, 0, 0,
+        0xc4, 0x7d, 0x46, 0x20, 0xac, 0xae
+    };
+
+class PcapTest : public ::testing::Test
+{
+  protected:
+    char file[30];
+    std::string data;
+    PcapFile pcap;
+    void SetUp() override {
+        strcpy(file, "/tmp/utest_pcapXXXXXX");
+        int fd = mkstemp(file);
+        ASSERT_GE(fd, 0);
+        close(fd);
+    }
+    void TearDown() override {
+        pcap.close();
+        unlink(file);
+    }
+    void add(const void *buf, size_t len) {
+        data.append((const char *)buf, len);
+    }
+    void add16(uint16_t v) { add(&v, sizeof v); }
+    void add32(uint32_t v) { add(&v, sizeof v); }
+    void add16n(uint16_t v) { uint8_t b[2] = {(uint8_t)(v >> 8), (uint8_t)v}; add(b, 2); }
+    // Ethernet, IPv4 and UDP with the PTP message
+    std::string udpFrame(uint16_t port) {
+        std::string s = data;
+        data.clear();
+        add(macs, sizeof macs);
+        add16n(0x0800);
+        const uint8_t ip[] = { 0x45, 0, 0, 82, 0, 0, 0x40, 0, 64, 17, 0, 0,
+                10, 0, 0, 1, 10, 0, 0, 2
+            };
+        add(ip, sizeof ip);
+        add16n(port);
+        add16n(port);
+        add16n(62);
+        add16(0);
+        add(ptpMsg, sizeof ptpMsg);
+        std::string f = data;
+        data = s;
+        return f;
+    }
+    // Ethernet with VLAN tag and padding
+    std::string l2Frame() {
+        std::string s = data;
+        data.clear();
+        add(macs, sizeof macs);
+        add16n(0x8100);
+        add16n(5);
+        add16n(0x88f7);
+        add(ptpMsg, sizeof ptpMsg);
+        data.append(10, 0);
+        std::string f = data;
+        data = s;
+        return f;
+    }
+    void pcapRec(uint32_t sec, uint32_t usec, const std::string &f) {
+        add32(sec);
+        add32(usec);
+        add32(f.size());
+        add32(f.size());
+        data += f;
+    }
+    void save() {
+        FILE *f = fopen(file, "w");
+        ASSERT_NE(f, nullptr);
+        fwrite(data.c_str(), 1, data.size(), f);
+        fclose(f);
+    }
+    void pcapFile() {
+        add32(0xa1b2c3d4);
+        add16(2);
+        add16(4);
+        add32(0);
+        add32(0);
+        add32(65535);
+        add32(1); // Ethernet
+        pcapRec(10, 5, udpFrame(320));
+        pcapRec(11, 6, udpFrame(53)); // Not PTP
+        pcapRec(12, 7, l2Frame());
+        save();
+    }
+    void ngBlock(uint32_t type, const std::string &body) {
+        uint32_t len = 12 + ((body.size() + 3) & ~3);
+        add32(type);
+        add32(len);
+        data += body;
+        data.append(len - 12 - body.size(), 0);
+        add32(len);
+    }
+    void ngFile() {
+        std::string s;
+        data.clear();
+        add32(0x1a2b3c4d);
+        add16(1);
+        add16(0);
+        add32(0xffffffff);
+        add32(0xffffffff);
+        s = data;
+        data.clear();
+        ngBlock(0x0a0d0d0a, s);
+        s = data;
+        data.clear();
+        add16(1); // Ethernet
+        add16(0);
+        add32(65535);
+        add16(9); // Nanoseconds resolution
+        add16(1);
+        add32(9);
+        add32(0);
+        std::string idb = data;
+        std::string f = l2Frame();
+        data.clear();
+        uint64_t ts = UINT64_C(20000000012);
+        add32(0);
+        add32(ts >> 32);
+        add32(ts & 0xffffffff);
+        add32(f.size());
+        add32(f.size());
+        data += f;
+        std::string epb = data;
+        data = s;
+        ngBlock(1, idb);
+        ngBlock(6, epb);
+        save();
+    }
+};
+
+// Tests open a pcap file
+// bool open(const std::string &file)
+// size_t frames() const
+// size_t chunks() const
+TEST_F(PcapTest, OpenPcap)
+{
+    pcapFile();
+    EXPECT_FALSE(pcap.isOpen());
+    EXPECT_TRUE(pcap.open(file));
+    EXPECT_TRUE(pcap.isOpen());
+    EXPECT_EQ(pcap.frames(), 3);
+    EXPECT_EQ(pcap.chunks(), 1);
+}
+
+// Tests open a file that is not a capture
+TEST_F(PcapTest, OpenWrong)
+{
+    data.append(100, 'x');
+    save();
+    EXPECT_FALSE(pcap.open(file));
+    EXPECT_FALSE(pcap.isOpen());
+    EXPECT_FALSE(pcap.open("/none/such/file"));
+}
+
+// Tests split frames to chunks
+// bool setChunkFrames(size_t frames)
+TEST_F(PcapTest, Chunks)
+{
+    pcapFile();
+    EXPECT_FALSE(pcap.setChunkFrames(0));
+    EXPECT_TRUE(pcap.setChunkFrames(2));
+    EXPECT_TRUE(pcap.open(file));
+    EXPECT_EQ(pcap.chunks(), 2);
+    size_t n = 0;
+    EXPECT_TRUE(pcap.traverse(1, [&](const PcapFrame_t &frm) {
+        EXPECT_EQ(frm.index, 3);
+        n++;
+        return true;
+    }));
+    EXPECT_EQ(n, 1);
+    EXPECT_FALSE(pcap.traverse(2, [](const PcapFrame_t &) { return true; }));
+}
+
+// Tests walk the PTP messages
+// bool traverse(size_t chunk,
+//     const std::function<bool (const PcapFrame_t &frame)> &callback) const
+TEST_F(PcapTest, Traverse)
+{
+    pcapFile();
+    ASSERT_TRUE(pcap.open(file));
+    std::vector<PcapFrame_t> frms;
+    EXPECT_TRUE(pcap.traverse(0, [&](const PcapFrame_t &frm) {
+        frms.push_back(frm);
+        return true;
+    }));
+    ASSERT_EQ(frms.size(), 2);
+    EXPECT_EQ(frms[0].index, 1);
+    EXPECT_EQ(frms[0].ts, Timestamp_t(10, 5000));
+    EXPECT_EQ(frms[0].transport, UDP_IPv4);
+    EXPECT_EQ(frms[0].addrLen, 4);
+    EXPECT_EQ(Binary(frms[0].src, 4).toIp(), "10.0.0.1");
+    EXPECT_EQ(Binary(frms[0].dst, 4).toIp(), "10.0.0.2");
+    EXPECT_EQ(frms[0].srcPort, 320);
+    EXPECT_EQ(frms[0].dstPort, 320);
+    EXPECT_EQ(frms[0].size, sizeof ptpMsg);
+    EXPECT_EQ(memcmp(frms[0].msg, ptpMsg, sizeof ptpMsg), 0);
+    EXPECT_EQ(frms[1].index, 3);
+    EXPECT_EQ(frms[1].ts, Timestamp_t(12, 7000));
+    EXPECT_EQ(frms[1].transport, IEEE_802_3);
+    EXPECT_EQ(Binary::bufToId(frms[1].src, frms[1].addrLen),
+        "c4:7d:46:20:ac:ae");
+    EXPECT_EQ(frms[1].srcPort, 0);
+    // Padding is removed
+    EXPECT_EQ(frms[1].size, sizeof ptpMsg);
+    Message msg;
+    EXPECT_EQ(msg.parse(frms[1].msg, frms[1].size), MNG_PARSE_ERROR_OK);
+    EXPECT_EQ(msg.getTlvId(), NULL_PTP_MANAGEMENT);
+    EXPECT_EQ(msg.getSequence(), 7);
+    // Stop the walk
+    EXPECT_FALSE(pcap.traverse(0, [](const PcapFrame_t &) { return false; }));
+}
+
+// Tests pcapng file with nanoseconds resolution
+TEST_F(PcapTest, PcapNg)
+{
+    ngFile();
+    ASSERT_TRUE(pcap.open(file));
+    EXPECT_EQ(pcap.frames(), 1);
+    size_t n = 0;
+    EXPECT_TRUE(pcap.traverse(0, [&](const PcapFrame_t &frm) {
+        EXPECT_EQ(frm.index, 1);
+        EXPECT_EQ(frm.ts, Timestamp_t(20, 12));
+        EXPECT_EQ(frm.transport, IEEE_802_3);
+        EXPECT_EQ(frm.size, sizeof ptpMsg);
+        n++;
+        return true;
+    }));
+    EXPECT_EQ(n, 1);
+}
@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief PHC sampler class unit tests
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include "phcSmpl.h"
+#include "err.h"
+
+using namespace ptpmgmt;
+
+class PhcCrossTsTest : public ::testing::Test, public PhcCrossTs
+{
+  protected:
+    PtpClock clk;
+    void SetUp() override {
+        useTestMode(true);
+        PhcCrossTs::clearCache();
+        ASSERT_TRUE(clk.initUsingIndex(0, false));
+    }
+    void TearDown() override {
+        useTestMode(false);
+    }
+};
+
+// Tests configuration methods
+// bool setClock(const PtpClock *clk)
+// bool setSamples(size_t samples)
+// bool setMethod(PhcCrossMethod_e method)
+TEST_F(PhcCrossTsTest, MethodSetConfig)
+{
+    PhcClockSample_t res;
+    EXPECT_FALSE(sample(res));
+    EXPECT_STREQ(Error::getMsg().c_str(), "Clock is not set");
+    PtpClock noInit;
+    EXPECT_FALSE(setClock(&noInit));
+    EXPECT_TRUE(setClock(&clk));
+    EXPECT_EQ(getClock(), &clk);
+    EXPECT_EQ(getSamples(), 5);
+    EXPECT_FALSE(setSamples(0));
+    EXPECT_FALSE(setSamples(26));
+    EXPECT_TRUE(setSamples(7));
+    EXPECT_EQ(getSamples(), 7);
+    EXPECT_EQ(getMethod(), PHC_CROSS_AUTO);
+    EXPECT_FALSE(setMethod((PhcCrossMethod_e)7));
+    EXPECT_TRUE(setMethod(PHC_CROSS_BASIC));
+    EXPECT_EQ(getMethod(), PHC_CROSS_BASIC);
+}
+
+// Tests sample method
+// bool sample(PhcClockSample_t &res)
+// PhcCrossMethod_e getMethod() const
+// const PhcCrossStats_t &getStats(PhcCrossMethod_e method) const
+TEST_F(PhcCrossTsTest, MethodSample)
+{
+    EXPECT_TRUE(setClock(&clk));
+    PhcClockSample_t res;
+    ASSERT_TRUE(sample(res));
+    EXPECT_EQ(getMethod(), PHC_CROSS_PRECISE);
+    EXPECT_TRUE(res.valid);
+    EXPECT_EQ(res.offset, -398000000047);
+    EXPECT_EQ(res.delay, 0);
+    ASSERT_TRUE(sample(res));
+    const PhcCrossStats_t &st = getStats(PHC_CROSS_AUTO);
+    EXPECT_EQ(&st, &getStats(PHC_CROSS_PRECISE));
+    EXPECT_EQ(st.samples, 2);
+    EXPECT_EQ(st.failures, 0);
+    EXPECT_EQ(st.window, 0);
+    EXPECT_EQ(st.jitter, 0);
+    // Method is cached per device
+    PhcCrossTs other;
+    EXPECT_TRUE(other.setClock(&clk));
+    EXPECT_TRUE(other.setSamples(7));
+    ASSERT_TRUE(other.sample(res));
+    EXPECT_EQ(other.getMethod(), PHC_CROSS_PRECISE);
+    EXPECT_EQ(other.getStats(PHC_CROSS_EXT).samples, 0);
+}
+
+// Tests forced methods
+TEST_F(PhcCrossTsTest, ForcedMethods)
+{
+    EXPECT_TRUE(setClock(&clk));
+    PhcClockSample_t res;
+    EXPECT_TRUE(setMethod(PHC_CROSS_EXT));
+    EXPECT_TRUE(setSamples(7));
+    ASSERT_TRUE(sample(res));
+    // Second sample system clock goes backward
+    EXPECT_EQ(res.delay, 73000000058);
+    EXPECT_EQ(res.sysClk, Timestamp_t(47, 500000062));
+    EXPECT_EQ(res.phcClk, Timestamp_t(22, 44));
+    EXPECT_EQ(res.offset, -25500000018);
+    EXPECT_EQ(getStats(PHC_CROSS_EXT).window, 73000000058);
+    EXPECT_TRUE(setMethod(PHC_CROSS_BASIC));
+    EXPECT_TRUE(setSamples(5));
+    ASSERT_TRUE(sample(res));
+    EXPECT_EQ(res.sysClk, Timestamp_t(41, 48));
+    EXPECT_EQ(res.phcClk, Timestamp_t(22, 44));
+    EXPECT_EQ(res.delay, 60000000030);
+    // Mock refuses 5 samples with the extended method
+    EXPECT_TRUE(setMethod(PHC_CROSS_EXT));
+    EXPECT_FALSE(sample(res));
+    EXPECT_EQ(getStats(PHC_CROSS_EXT).failures, 1);
+}
+
+// Tests calibrate method
+// bool calibrate(size_t rounds)
+TEST_F(PhcCrossTsTest, MethodCalibrate)
+{
+    EXPECT_FALSE(calibrate(3));
+    EXPECT_TRUE(setClock(&clk));
+    EXPECT_FALSE(calibrate(0));
+    EXPECT_TRUE(calibrate(3));
+    EXPECT_EQ(getMethod(), PHC_CROSS_PRECISE);
+    EXPECT_EQ(getStats(PHC_CROSS_PRECISE).samples, 3);
+    // Mock uses 7 samples with the extended method
+    EXPECT_EQ(getStats(PHC_CROSS_EXT).failures, 3);
+    EXPECT_EQ(getStats(PHC_CROSS_BASIC).samples, 3);
+    EXPECT_STREQ(method2str(getMethod()), "precise");
+    EXPECT_STREQ(method2str(PHC_CROSS_BASIC), "basic");
+}
+
+class PhcSamplerTest : public ::testing::Test, public PhcSampler
+{
+  protected:
+    void SetUp() override {
+        useTestMode(true);
+        PhcCrossTs::clearCache();
+    }
+    void TearDown() override {
+        stop();
+        useTestMode(false);
+    }
+};
+
+// Tests addClock method
+// bool addClock(int ptpIndex, bool readonly = true)
+// size_t size() const
+// const PtpClock *getClock(size_t index) const
+TEST_F(PhcSamplerTest, MethodAddClock)
+{
+    EXPECT_TRUE(addClock(0, false));
+    EXPECT_EQ(size(), 1);
+    ASSERT_NE(getClock(0), nullptr);
+    EXPECT_EQ(getClock(0)->ptpIndex(), 0);
+    EXPECT_STREQ(getClock(0)->device_c(), "/dev/ptp0");
+    EXPECT_EQ(getClock(1), nullptr);
+    // Same clock twice
+    EXPECT_FALSE(addClock(0, false));
+    EXPECT_STREQ(Error::getMsg().c_str(), "Clock 0 is already used");
+    EXPECT_TRUE(addClock(1));
+    EXPECT_EQ(size(), 2);
+}
+
+// Tests setSamples method
+// bool setSamples(size_t samples)
+// size_t getSamples() const
+TEST_F(PhcSamplerTest, MethodSetSamples)
+{
+    EXPECT_EQ(getSamples(), 5);
+    EXPECT_FALSE(setSamples(0));
+    EXPECT_FALSE(setSamples(26));
+    EXPECT_TRUE(setSamples(7));
+    EXPECT_EQ(getSamples(), 7);
+}
+
+// Tests setCpus method
+// bool setCpus(const std::vector<int> &cpus)
+TEST_F(PhcSamplerTest, MethodSetCpus)
+{
+    EXPECT_FALSE(setCpus({ -1 }));
+    EXPECT_TRUE(setCpus({ 0, 1 }));
+    EXPECT_TRUE(setCpus({}));
+}
+
+// Tests start method
+// bool start()
+// void stop()
+// bool isRunning() const
+TEST_F(PhcSamplerTest, MethodStart)
+{
+    EXPECT_FALSE(start());
+    EXPECT_STREQ(Error::getMsg().c_str(), "No clocks to sample");
+    EXPECT_TRUE(addClock(0, false));
+    EXPECT_TRUE(start());
+    EXPECT_TRUE(isRunning());
+    EXPECT_FALSE(addClock(1));
+    EXPECT_FALSE(setSamples(7));
+    stop();
+    EXPECT_FALSE(isRunning());
+}
+
+// Tests sampleRound method
+// bool sampleRound(PhcRound_t &round)
+TEST_F(PhcSamplerTest, MethodSampleRound)
+{
+    EXPECT_TRUE(addClock(0, false));
+    EXPECT_TRUE(addClock(1));
+    EXPECT_TRUE(setSamples(7));
+    PhcRound_t round;
+    ASSERT_TRUE(sampleRound(round));
+    EXPECT_TRUE(isRunning());
+    EXPECT_EQ(round.sequence, 1);
+    ASSERT_EQ(round.size(), 2);
+    for(size_t i = 0; i < 2; i++) {
+        const PhcClockSample_t &c = round.clocks[i];
+        EXPECT_TRUE(c.valid);
+        // Driver support precise cross time stamp
+        EXPECT_EQ(c.delay, 0);
+        EXPECT_EQ(c.sysClk, Timestamp_t(415, 182));
+        EXPECT_EQ(c.phcClk, Timestamp_t(17, 135));
+        EXPECT_EQ(c.offset, -398000000047);
+        ASSERT_NE(getCrossTs(i), nullptr);
+        EXPECT_EQ(getCrossTs(i)->getMethod(), PHC_CROSS_PRECISE);
+    }
+    EXPECT_EQ(getCrossTs(2), nullptr);
+    EXPECT_TRUE(round.valid(0, 1));
+    EXPECT_FALSE(round.valid(0, 2));
+    EXPECT_EQ(round.offset(0, 1), 0);
+    EXPECT_EQ(round.offset(1, 0), 0);
+    ASSERT_TRUE(sampleRound(round));
+    EXPECT_EQ(round.sequence, 2);
+}
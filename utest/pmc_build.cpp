@@ -14,6 +14,7 @@
 Message m;
 char str[512];
 void (*handle)(const BaseMngTlv *);
+bool show_sending = true;
 /* Called from call_data() */
 bool sendAction()
 {
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Pulse per second discipline class unit tests
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include "pps.h"
+#include "err.h"
+
+using namespace ptpmgmt;
+
+class PpsDisciplineTest : public ::testing::Test, public PpsDiscipline
+{
+  protected:
+    PtpClock clk;
+    void SetUp() override {
+        useTestMode(true);
+        ASSERT_TRUE(clk.initUsingIndex(0));
+    }
+    void TearDown() override {
+        useTestMode(false);
+    }
+    void edge(unsigned int index, int64_t secs, uint32_t nano) {
+        PtpEvent_t event;
+        event.index = index;
+        event.time = Timestamp_t(secs, nano);
+        process(event);
+    }
+};
+
+// Tests configuration methods
+// bool setClock(const PtpClock *clk)
+// bool setEdge(uint8_t edges)
+// bool setServo(Servo *servo)
+// bool setFilter(size_t size, int64_t threshold)
+// bool setTolerance(int64_t tolerance)
+// bool setPriority(int priority)
+// bool setCpu(int cpu)
+TEST_F(PpsDisciplineTest, MethodSetConfig)
+{
+    EXPECT_FALSE(enable());
+    EXPECT_STREQ(Error::getMsg().c_str(), "Clock is not set");
+    PtpClock noInit;
+    EXPECT_FALSE(setClock(&noInit));
+    EXPECT_TRUE(setClock(&clk));
+    EXPECT_FALSE(setEdge(PTP_EXTERN_TS_RISING_EDGE | PTP_EXTERN_TS_FALLING_EDGE));
+    EXPECT_TRUE(setEdge(PTP_EXTERN_TS_FALLING_EDGE));
+    EXPECT_FALSE(setServo(nullptr));
+    EXPECT_TRUE(setServo(new LinRegServo));
+    EXPECT_NE(dynamic_cast<LinRegServo *>(&getServo()), nullptr);
+    EXPECT_FALSE(setFilter(5, 0));
+    EXPECT_TRUE(setFilter(0, 0));
+    EXPECT_TRUE(setFilter(7, 2000));
+    EXPECT_FALSE(setTolerance(0));
+    EXPECT_FALSE(setTolerance(1000000000));
+    EXPECT_TRUE(setTolerance(100000));
+    EXPECT_FALSE(setPriority(-1));
+    EXPECT_TRUE(setPriority(0));
+    EXPECT_FALSE(setCpu(CPU_SETSIZE));
+    EXPECT_TRUE(setCpu(-1));
+}
+
+// Tests enable method
+// bool setPin(int pin, unsigned int channel)
+// bool enable()
+TEST_F(PpsDisciplineTest, MethodEnable)
+{
+    EXPECT_TRUE(setClock(&clk));
+    EXPECT_TRUE(setPin(-1, 7));
+    EXPECT_TRUE(enable());
+}
+
+// Tests process method
+// bool process(const PtpEvent_t &event)
+// PpsStatus_t getStatus() const
+TEST_F(PpsDisciplineTest, MethodProcess)
+{
+    EXPECT_TRUE(setClock(&clk));
+    EXPECT_TRUE(setPin(-1, 7));
+    EXPECT_TRUE(setFilter(3, 1000));
+    edge(7, 100, 1000);
+    PpsStatus_t st = getStatus();
+    EXPECT_EQ(st.servo, SERVO_UNLOCKED);
+    EXPECT_EQ(st.offset, 1000);
+    EXPECT_EQ(st.time, Timestamp_t(100, 1000));
+    EXPECT_EQ(st.events, 1);
+    // Other channel
+    edge(2, 101, 0);
+    EXPECT_STREQ(Error::getMsg().c_str(), "Event of channel 2");
+    EXPECT_EQ(getStatus().events, 1);
+    // Half a second from the previous edge
+    edge(7, 100, 500001000);
+    st = getStatus();
+    EXPECT_EQ(st.events, 2);
+    EXPECT_EQ(st.rejected, 1);
+    EXPECT_EQ(st.time, Timestamp_t(100, 1000));
+    edge(7, 101, 1100);
+    st = getStatus();
+    EXPECT_EQ(st.servo, SERVO_LOCKED);
+    EXPECT_EQ(st.offset, 1100);
+    // PHC is behind the second boundary
+    edge(7, 102, 999999900);
+    EXPECT_EQ(getStatus().offset, -100);
+    edge(7, 104, 50);
+    // Outlier from the median of the recent phase errors
+    edge(7, 105, 900000);
+    st = getStatus();
+    EXPECT_EQ(st.events, 6);
+    EXPECT_EQ(st.rejected, 2);
+    EXPECT_EQ(st.offset, 50);
+}
+
+// Tests the discipline starts over after consecutive rejected edges
+TEST_F(PpsDisciplineTest, Restart)
+{
+    EXPECT_TRUE(setClock(&clk));
+    EXPECT_TRUE(setPin(-1, 7));
+    EXPECT_TRUE(setFilter(2, 1000));
+    edge(7, 10, 0);
+    edge(7, 11, 10);
+    edge(7, 12, 20);
+    // The source moved by 300 microseconds
+    edge(7, 13, 300000);
+    EXPECT_EQ(getStatus().rejected, 1);
+    edge(7, 14, 300010);
+    PpsStatus_t st = getStatus();
+    EXPECT_EQ(st.rejected, 2);
+    EXPECT_EQ(st.offset, 300010);
+    EXPECT_EQ(st.time, Timestamp_t(14, 300010));
+}
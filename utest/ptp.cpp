@@ -73,6 +73,97 @@ TEST_F(IfInfoTest, MethodInitUsingIndex)
     EXPECT_EQ(ptpIndex(), 3);
 }
 
+// Interfaces cache, the system library emulates the rtnetlink messages
+class IfCacheTest : public ::testing::Test
+{
+  protected:
+    const uint8_t mac7[6] = { 1, 2, 3, 4, 5, 6 };
+    const uint8_t mac8[6] = { 1, 2, 3, 4, 5, 8 };
+    void SetUp() override {
+        useTestMode(true);
+        // Open the cache
+        IfInfo i;
+        ASSERT_TRUE(i.initUsingIndex(7));
+    }
+    void TearDown() override {
+        useTestMode(false);
+    }
+};
+
+// Tests RTM_NEWLINK and RTM_DELLINK notifications
+TEST_F(IfCacheTest, NewDelLink)
+{
+    nlNewLink(8, "eth1", mac8, 5);
+    // The ioctls emulation knows eth0 only
+    IfInfo i;
+    EXPECT_TRUE(i.initUsingName("eth1"));
+    EXPECT_EQ(i.ifIndex(), 8);
+    EXPECT_EQ(i.mac(), Binary(mac8, sizeof mac8));
+    EXPECT_EQ(i.ptpIndex(), 5);
+    IfInfo j;
+    EXPECT_TRUE(j.initUsingIndex(8));
+    EXPECT_STREQ(j.ifName_c(), "eth1");
+    nlDelLink(8);
+    IfInfo k;
+    EXPECT_FALSE(k.initUsingName("eth1"));
+    IfInfo l;
+    EXPECT_FALSE(l.initUsingIndex(8));
+}
+
+// Tests RTM_NEWLINK of a renamed interface
+TEST_F(IfCacheTest, RenameLink)
+{
+    nlNewLink(7, "lan0", mac8, 4);
+    IfInfo i;
+    EXPECT_TRUE(i.initUsingIndex(7));
+    EXPECT_STREQ(i.ifName_c(), "lan0");
+    EXPECT_EQ(i.mac(), Binary(mac8, sizeof mac8));
+    // The PTP index is fetched again for the new name
+    EXPECT_EQ(i.ptpIndex(), 4);
+    IfInfo j;
+    EXPECT_TRUE(j.initUsingName("lan0"));
+    EXPECT_EQ(j.ifIndex(), 7);
+    nlNewLink(7, "eth0", mac7, 3);
+    IfInfo k;
+    EXPECT_TRUE(k.initUsingName("eth0"));
+    EXPECT_EQ(k.mac(), Binary(mac7, sizeof mac7));
+    EXPECT_EQ(k.ptpIndex(), 3);
+}
+
+// Tests dump of the links after the kernel drops notifications
+TEST_F(IfCacheTest, LostNotifications)
+{
+    nlNewLink(9, "eth2", mac8, 6);
+    nlRecvError(ENOBUFS);
+    IfInfo i;
+    EXPECT_TRUE(i.initUsingName("eth2"));
+    EXPECT_EQ(i.ifIndex(), 9);
+    EXPECT_EQ(i.ptpIndex(), 6);
+    nlDelLink(9);
+    IfInfo j;
+    EXPECT_FALSE(j.initUsingName("eth2"));
+}
+
+// Tests fall back to the ioctls when netlink is not available
+// Netlink stays closed, keep this test last
+TEST_F(IfCacheTest, NetlinkFail)
+{
+    // Close the cache socket on a receive error
+    nlRecvError(EBADF);
+    nlSocketFail(true);
+    int count = nlSocketCount();
+    IfInfo i;
+    EXPECT_TRUE(i.initUsingName("eth0"));
+    EXPECT_EQ(i.ifIndex(), 7);
+    IfInfo j;
+    EXPECT_TRUE(j.initUsingName("eth0"));
+    IfInfo k;
+    EXPECT_TRUE(k.initUsingIndex(7));
+    // The cache tries to open netlink once
+    EXPECT_EQ(nlSocketCount(), count + 1);
+    nlSocketFail(false);
+}
+
 class SysClockTest : public ::testing::Test, public SysClock
 {
   protected:
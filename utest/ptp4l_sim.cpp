@@ -5,16 +5,39 @@
  * @brief Simulate dummy PHC clock for ptp4l
  *        The purpose is to get Managment replies on UDS socket
  *         and run phc_ctl.
- *        Nothing beyond!
  *        If you wish to simulate a clocks network.
  *        You can use https://github.com/mlichvar/clknetsim/
  *
  * @author Erez Geva <ErezGeva2@@gmail.com>
  * @copyright © 2023 Erez Geva
  *
+ * @details
+ *  Without environment, any /dev/ptp device is a dummy PHC,
+ *   that moves one second on each read.
+ *  Set PTP_SIM_CLOCKS to simulate virtual PHCs for performance testing
+ *   of the clock discipline and sampling code:
+ *  PTP_SIM_CLOCKS   number of /dev/ptpN devices, up to 64
+ *  PTP_SIM_DRIFT    frequency error in ppb, comma separated per device,
+ *                    the last value is used for the rest
+ *  PTP_SIM_OFFSET   initial offset from the system clock in nanoseconds,
+ *                    comma separated per device
+ *  PTP_SIM_JITTER   maximum noise added to a PHC read in nanoseconds
+ *  PTP_SIM_LATENCY  duration of a PHC read in nanoseconds
+ *  PTP_SIM_SEED     seed of the noise generator, default 1
+ *  PTP_SIM_XTS      best cross time stamp: precise, extended or basic
+ *  PTP_SIM_PPS      phase of the pulse per second in nanoseconds,
+ *                    fed to the enabled external time stamp channels
+ *  The PHCs run on the system monotonic raw clock.
+ *  The system clock is never adjusted.
+ *  Applications can use dlsym() to find the ptp_sim_xxx functions,
+ *   to inject external time stamp events, change the drift and
+ *   read the PHC true offset from the system clock.
  */
 
+#include <mutex>
+#include <deque>
 #include <string>
+#include <thread>
 #include <cstring>
 #include <dlfcn.h>
 #include <stdarg.h>
@@ -25,6 +48,7 @@
 #include <sys/ioctl.h>
 #include <sys/timex.h>
 #include <sys/stat.h>
+#include <sys/eventfd.h>
 #include <net/if.h>
 #include <linux/ptp_clock.h>
 #include <linux/net_tstamp.h>
@@ -35,6 +59,37 @@
 static bool did_init = false;
 static const char ptp_dev[] = "/dev/ptp";
 static timespec start_ts = {1600000000, 0};
+static const int64_t NSEC_PER_SEC = 1000000000;
+static const size_t MAX_CLOCKS = 64;
+static const int MAX_FDS = 1024;
+static const unsigned int NUM_CHANNELS = 2; // external time stamp channels
+static const unsigned int NUM_PINS = 2;
+static const long MAX_ADJ = 0xffffff;
+enum xtsMethod_e { XTS_BASIC, XTS_EXT, XTS_PRECISE };
+/*****************************************************************************/
+struct VirtPhc {
+    std::mutex lock;
+    int64_t baseRaw; // Monotonic raw time of the last rebase
+    int64_t basePhc; // PHC time of the last rebase
+    long double drift; // Simulated frequency error in ppb
+    long double freq; // Frequency set by the user in ppb
+    long adjFreq; // Frequency set by the user in scaled ppm
+    uint32_t extts; // Enabled external time stamp channels
+    ptp_pin_desc pins[NUM_PINS];
+    uint64_t rnd; // Noise generator state
+};
+struct OpenFile {
+    VirtPhc *phc; // null if the file is not a virtual PHC
+    std::deque<ptp_extts_event> events; // Protected by the PHC lock
+};
+static VirtPhc *phcs = nullptr;
+static size_t phcNum = 0;
+static OpenFile files[MAX_FDS];
+static int64_t jitter = 0;
+static int64_t latency = 0;
+static int64_t ppsPhase = -1;
+static xtsMethod_e xtsMethod = XTS_PRECISE;
+static std::once_flag ppsOnce;
 /*****************************************************************************/
 #define sysFuncDec(ret, name, ...)\
     ret (*_##name)(__VA_ARGS__);\
@@ -53,11 +108,15 @@ sysFuncDec(int, clock_settime, clockid_t, const timespec *)
 sysFuncDec(int, clock_adjtime, clockid_t, timex *)
 sysFuncDec(int, open, const char *, int, ...)
 sysFuncDec(int, ioctl, int, unsigned long, ...)
+sysFuncDec(ssize_t, read, int, void *, size_t)
+sysFuncDec(int, close, int)
+sysFuncDec(char *, realpath, const char *, char *)
 // glibc 'stat' fucntion
 sysFuncDec(int, stat, const char *, struct stat *)
 sysFuncDec(int, stat64, const char *, struct stat64 *)
 sysFuncDec(int, __xstat, int, const char *, struct stat *)
 sysFuncDec(int, __xstat64, int, const char *, struct stat64 *)
+static void initVirtPhc();
 __attribute__((constructor))
 static void initPtpSim(void)
 {
@@ -69,38 +128,450 @@ static void initPtpSim(void)
     sysFuncAgn(int, clock_adjtime, clockid_t, timex *)
     sysFuncAgn(int, open, const char *, int, ...)
     sysFuncAgn(int, ioctl, int, unsigned long, ...)
+    sysFuncAgn(ssize_t, read, int, void *, size_t)
+    sysFuncAgn(int, close, int)
+    sysFuncAgn(char *, realpath, const char *, char *)
     sysFuncAgZ(int, stat, const char *, struct stat *)
     sysFuncAgZ(int, stat64, const char *, struct stat64 *)
     sysFuncAgn(int, __xstat, int, const char *, struct stat *)
     sysFuncAgn(int, __xstat64, int, const char *, struct stat64 *)
     if(fail)
         fprintf(stderr, "Fail obtain address of functions\n");
-    did_init = false;
+    initVirtPhc();
+    did_init = true;
+}
+/*****************************************************************************/
+static inline int64_t now(clockid_t id)
+{
+    timespec ts;
+    orgFunc(clock_gettime, id, &ts);
+    return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+static inline void toTs(int64_t ns, timespec *ts)
+{
+    ts->tv_sec = ns / NSEC_PER_SEC;
+    ts->tv_nsec = ns % NSEC_PER_SEC;
+    if(ts->tv_nsec < 0) {
+        ts->tv_sec--;
+        ts->tv_nsec += NSEC_PER_SEC;
+    }
+}
+static inline void toPtp(int64_t ns, ptp_clock_time &t)
+{
+    timespec ts;
+    toTs(ns, &ts);
+    t.sec = ts.tv_sec;
+    t.nsec = ts.tv_nsec;
+    t.reserved = 0;
+}
+// Spend the read duration
+static inline void spin(int64_t duration)
+{
+    if(duration <= 0)
+        return;
+    int64_t end = now(CLOCK_MONOTONIC_RAW) + duration;
+    while(now(CLOCK_MONOTONIC_RAW) < end);
+}
+// Use the value per device, the last value for the rest
+static void parseList(const char *env, int64_t *vals, size_t num)
+{
+    const char *str = getenv(env);
+    int64_t last = 0;
+    for(size_t i = 0; i < num; i++) {
+        if(str != nullptr && *str != 0) {
+            char *end;
+            last = strtoll(str, &end, 0);
+            str = *end == ',' ? end + 1 : nullptr;
+        }
+        vals[i] = last;
+    }
+}
+static int64_t getNum(const char *env, int64_t def)
+{
+    const char *str = getenv(env);
+    if(str == nullptr || *str == 0)
+        return def;
+    return strtoll(str, nullptr, 0);
+}
+static void initVirtPhc()
+{
+    size_t num = getNum("PTP_SIM_CLOCKS", 0);
+    if(num == 0)
+        return;
+    if(num > MAX_CLOCKS)
+        num = MAX_CLOCKS;
+    int64_t drifts[MAX_CLOCKS], offsets[MAX_CLOCKS];
+    parseList("PTP_SIM_DRIFT", drifts, num);
+    parseList("PTP_SIM_OFFSET", offsets, num);
+    jitter = getNum("PTP_SIM_JITTER", 0);
+    latency = getNum("PTP_SIM_LATENCY", 0);
+    ppsPhase = getNum("PTP_SIM_PPS", -1);
+    uint64_t seed = getNum("PTP_SIM_SEED", 1);
+    const char *xts = getenv("PTP_SIM_XTS");
+    if(xts != nullptr) {
+        if(strcmp(xts, "basic") == 0)
+            xtsMethod = XTS_BASIC;
+        else if(strcmp(xts, "extended") == 0)
+            xtsMethod = XTS_EXT;
+    }
+    phcs = new VirtPhc[num];
+    int64_t raw = now(CLOCK_MONOTONIC_RAW);
+    int64_t sys = now(CLOCK_REALTIME);
+    for(size_t i = 0; i < num; i++) {
+        VirtPhc &p = phcs[i];
+        p.baseRaw = raw;
+        p.basePhc = sys + offsets[i];
+        p.drift = drifts[i];
+        p.freq = 0;
+        p.adjFreq = 0;
+        p.extts = 0;
+        memset(p.pins, 0, sizeof p.pins);
+        for(unsigned int j = 0; j < NUM_PINS; j++) {
+            snprintf(p.pins[j].name, sizeof p.pins[j].name, "SMA%u", j + 1);
+            p.pins[j].index = j;
+        }
+        // Zero state is not allowed
+        p.rnd = seed + i + 1;
+    }
+    phcNum = num;
+}
+/*****************************************************************************/
+/* Virtual PHC, caller holds the PHC lock */
+static inline int64_t phcAt(VirtPhc &p, int64_t raw)
+{
+    int64_t elapsed = raw - p.baseRaw;
+    return p.basePhc + elapsed + (int64_t)(elapsed * (p.drift + p.freq) / 1e9);
+}
+static inline void rebase(VirtPhc &p, int64_t raw)
+{
+    p.basePhc = phcAt(p, raw);
+    p.baseRaw = raw;
+}
+// Uniform noise in [-jitter, jitter], xorshift64*
+static inline int64_t noise(VirtPhc &p)
+{
+    if(jitter <= 0)
+        return 0;
+    p.rnd ^= p.rnd >> 12;
+    p.rnd ^= p.rnd << 25;
+    p.rnd ^= p.rnd >> 27;
+    uint64_t r = p.rnd * 0x2545F4914F6CDD1DULL;
+    return (int64_t)(r % (2 * jitter + 1)) - jitter;
+}
+// Read PHC, the read takes the latency and the PHC is sampled in the middle
+static int64_t phcRead(VirtPhc &p)
+{
+    spin(latency / 2);
+    int64_t ret;
+    {
+        std::lock_guard<std::mutex> lk(p.lock);
+        ret = phcAt(p, now(CLOCK_MONOTONIC_RAW)) + noise(p);
+    }
+    spin(latency - latency / 2);
+    return ret;
+}
+static VirtPhc *fd2Phc(int fd)
+{
+    if(fd < 0 || fd >= MAX_FDS)
+        return nullptr;
+    return files[fd].phc;
+}
+static VirtPhc *clk2Phc(clockid_t id)
+{
+    // See FD_TO_CLOCKID in the kernel
+    if((id & 7) != 3)
+        return nullptr;
+    return fd2Phc((int)~(id >> 3));
+}
+static VirtPhc *dev2Phc(const char *name)
+{
+    if(phcNum == 0 || name == nullptr ||
+        strncmp(ptp_dev, name, sizeof(ptp_dev) - 1) != 0)
+        return nullptr;
+    const char *num = name + sizeof(ptp_dev) - 1;
+    char *end;
+    long idx = strtol(num, &end, 10);
+    if(*num == 0 || *end != 0 || idx < 0 || (size_t)idx >= phcNum)
+        return nullptr;
+    return phcs + idx;
+}
+// Caller holds the PHC lock
+static void queueEvent(VirtPhc &p, unsigned int channel, int64_t ts)
+{
+    ptp_extts_event event = {};
+    toPtp(ts, event.t);
+    event.index = channel;
+    for(int fd = 0; fd < MAX_FDS; fd++) {
+        if(files[fd].phc == &p) {
+            files[fd].events.push_back(event);
+            uint64_t one = 1;
+            if(write(fd, &one, sizeof one) < 0)
+                fprintf(stderr, "Fail to signal event\n");
+        }
+    }
+}
+// Feed the pulse per second to the enabled channels
+static void ppsThread()
+{
+    int64_t next = (now(CLOCK_REALTIME) / NSEC_PER_SEC + 1) * NSEC_PER_SEC +
+        ppsPhase;
+    for(;;) {
+        timespec ts;
+        toTs(next, &ts);
+        clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, nullptr);
+        // Edge time on the monotonic raw clock
+        int64_t raw = now(CLOCK_MONOTONIC_RAW) - (now(CLOCK_REALTIME) - next);
+        for(size_t i = 0; i < phcNum; i++) {
+            VirtPhc &p = phcs[i];
+            std::lock_guard<std::mutex> lk(p.lock);
+            for(unsigned int c = 0; c < NUM_CHANNELS; c++) {
+                if((p.extts & (1 << c)) != 0)
+                    queueEvent(p, c, phcAt(p, raw) + noise(p));
+            }
+        }
+        next += NSEC_PER_SEC;
+    }
+}
+/*****************************************************************************/
+/* Exported functions for applications, use dlsym() */
+extern "C" int ptp_sim_inject_extts(int ptpIndex, unsigned int channel,
+    int64_t ts)
+{
+    if(ptpIndex < 0 || (size_t)ptpIndex >= phcNum || channel >= NUM_CHANNELS)
+        return -1;
+    VirtPhc &p = phcs[ptpIndex];
+    std::lock_guard<std::mutex> lk(p.lock);
+    queueEvent(p, channel, ts);
+    return 0;
+}
+extern "C" int ptp_sim_set_drift(int ptpIndex, double drift)
+{
+    if(ptpIndex < 0 || (size_t)ptpIndex >= phcNum)
+        return -1;
+    VirtPhc &p = phcs[ptpIndex];
+    std::lock_guard<std::mutex> lk(p.lock);
+    rebase(p, now(CLOCK_MONOTONIC_RAW));
+    p.drift = drift;
+    return 0;
+}
+// PHC offset from the system clock without noise
+extern "C" int ptp_sim_true_offset(int ptpIndex, int64_t *offset)
+{
+    if(ptpIndex < 0 || (size_t)ptpIndex >= phcNum || offset == nullptr)
+        return -1;
+    VirtPhc &p = phcs[ptpIndex];
+    std::lock_guard<std::mutex> lk(p.lock);
+    int64_t raw = now(CLOCK_MONOTONIC_RAW);
+    *offset = phcAt(p, raw) - now(CLOCK_REALTIME);
+    return 0;
+}
+/*****************************************************************************/
+static int virtAdjtime(VirtPhc &p, timex *tx)
+{
+    std::lock_guard<std::mutex> lk(p.lock);
+    int64_t raw = now(CLOCK_MONOTONIC_RAW);
+    if((tx->modes & ADJ_FREQUENCY) != 0) {
+        rebase(p, raw);
+        p.adjFreq = tx->freq;
+        // Scaled ppm to ppb
+        p.freq = (long double)tx->freq / 65.536;
+    }
+    if((tx->modes & ADJ_SETOFFSET) != 0) {
+        rebase(p, raw);
+        int64_t sub = (tx->modes & ADJ_NANO) != 0 ? tx->time.tv_usec :
+            tx->time.tv_usec * 1000;
+        p.basePhc += tx->time.tv_sec * NSEC_PER_SEC + sub;
+    } else if((tx->modes & ADJ_OFFSET) != 0) {
+        // Phase adjustment is applied at once
+        rebase(p, raw);
+        p.basePhc += (tx->modes & ADJ_NANO) != 0 ? tx->offset :
+            tx->offset * 1000;
+    }
+    tx->freq = p.adjFreq;
+    return TIME_OK;
+}
+static int virtIoctl(VirtPhc &p, unsigned long rq, void *arg)
+{
+    switch(rq) {
+        #ifdef PTP_CLOCK_GETCAPS2
+        case PTP_CLOCK_GETCAPS2:
+            #endif
+        case PTP_CLOCK_GETCAPS: {
+            ptp_clock_caps *cps = (ptp_clock_caps *)arg;
+            memset(cps, 0, sizeof(ptp_clock_caps));
+            cps->max_adj = MAX_ADJ;
+            cps->n_ext_ts = NUM_CHANNELS;
+            cps->n_pins = NUM_PINS;
+            cps->pps = 1;
+            cps->cross_timestamping = xtsMethod == XTS_PRECISE;
+            return 0;
+        }
+        #ifdef PTP_SYS_OFFSET2
+        case PTP_SYS_OFFSET2:
+            #endif
+        case PTP_SYS_OFFSET: {
+            ptp_sys_offset *req = (ptp_sys_offset *)arg;
+            if(req->n_samples == 0 || req->n_samples > PTP_MAX_SAMPLES)
+                break;
+            ptp_clock_time *t = req->ts;
+            toPtp(now(CLOCK_REALTIME), *t++);
+            for(unsigned int i = 0; i < req->n_samples; i++) {
+                toPtp(phcRead(p), *t++);
+                toPtp(now(CLOCK_REALTIME), *t++);
+            }
+            return 0;
+        }
+        #ifdef PTP_SYS_OFFSET_EXTENDED2
+        case PTP_SYS_OFFSET_EXTENDED2:
+            #endif
+        case PTP_SYS_OFFSET_EXTENDED: {
+            ptp_sys_offset_extended *req = (ptp_sys_offset_extended *)arg;
+            if(xtsMethod == XTS_BASIC) {
+                errno = EOPNOTSUPP;
+                return -1;
+            }
+            if(req->n_samples == 0 || req->n_samples > PTP_MAX_SAMPLES)
+                break;
+            for(unsigned int i = 0; i < req->n_samples; i++) {
+                toPtp(now(CLOCK_REALTIME), req->ts[i][0]);
+                toPtp(phcRead(p), req->ts[i][1]);
+                toPtp(now(CLOCK_REALTIME), req->ts[i][2]);
+            }
+            return 0;
+        }
+        #ifdef PTP_SYS_OFFSET_PRECISE2
+        case PTP_SYS_OFFSET_PRECISE2:
+            #endif
+        case PTP_SYS_OFFSET_PRECISE: {
+            ptp_sys_offset_precise *req = (ptp_sys_offset_precise *)arg;
+            if(xtsMethod != XTS_PRECISE) {
+                errno = EOPNOTSUPP;
+                return -1;
+            }
+            spin(latency);
+            std::lock_guard<std::mutex> lk(p.lock);
+            int64_t raw = now(CLOCK_MONOTONIC_RAW);
+            toPtp(phcAt(p, raw) + noise(p), req->device);
+            toPtp(now(CLOCK_REALTIME), req->sys_realtime);
+            toPtp(raw, req->sys_monoraw);
+            return 0;
+        }
+        #ifdef PTP_EXTTS_REQUEST2
+        case PTP_EXTTS_REQUEST2:
+            #endif
+        case PTP_EXTTS_REQUEST: {
+            ptp_extts_request *req = (ptp_extts_request *)arg;
+            if(req->index >= NUM_CHANNELS)
+                break;
+            {
+                std::lock_guard<std::mutex> lk(p.lock);
+                if((req->flags & PTP_ENABLE_FEATURE) != 0)
+                    p.extts |= 1 << req->index;
+                else
+                    p.extts &= ~(1 << req->index);
+            }
+            if(ppsPhase >= 0 && (req->flags & PTP_ENABLE_FEATURE) != 0)
+                std::call_once(ppsOnce, [] { std::thread(ppsThread).detach(); });
+            return 0;
+        }
+        #ifdef PTP_PIN_GETFUNC2
+        case PTP_PIN_GETFUNC2:
+            #endif
+        case PTP_PIN_GETFUNC: {
+            ptp_pin_desc *desc = (ptp_pin_desc *)arg;
+            if(desc->index >= NUM_PINS)
+                break;
+            std::lock_guard<std::mutex> lk(p.lock);
+            *desc = p.pins[desc->index];
+            return 0;
+        }
+        #ifdef PTP_PIN_SETFUNC2
+        case PTP_PIN_SETFUNC2:
+            #endif
+        case PTP_PIN_SETFUNC: {
+            ptp_pin_desc *desc = (ptp_pin_desc *)arg;
+            if(desc->index >= NUM_PINS || desc->func > PTP_PF_PHYSYNC ||
+                (desc->func == PTP_PF_EXTTS && desc->chan >= NUM_CHANNELS))
+                break;
+            std::lock_guard<std::mutex> lk(p.lock);
+            p.pins[desc->index].func = desc->func;
+            p.pins[desc->index].chan = desc->chan;
+            return 0;
+        }
+        #ifdef PTP_PEROUT_REQUEST2
+        case PTP_PEROUT_REQUEST2:
+            #endif
+        case PTP_PEROUT_REQUEST:
+        #ifdef PTP_ENABLE_PPS2
+        case PTP_ENABLE_PPS2:
+            #endif
+        case PTP_ENABLE_PPS:
+            return 0;
+        default:
+            errno = ENOTTY;
+            return -1;
+    }
+    errno = EINVAL;
+    return -1;
 }
 /*****************************************************************************/
 int clock_gettime(clockid_t id, timespec *ts)
 {
-    if(id < 0) {
+    VirtPhc *p = clk2Phc(id);
+    if(p != nullptr) {
+        toTs(phcRead(*p), ts);
+        return 0;
+    }
+    if(id < 0 && phcNum == 0) {
         ts->tv_sec = start_ts.tv_sec++;
         ts->tv_nsec = start_ts.tv_nsec;
         return 0;
     }
     return orgFunc(clock_gettime, id, ts);
 }
-int clock_settime(clockid_t id, const timespec *)
+int clock_settime(clockid_t id, const timespec *ts)
 {
-    if(id < 0)
+    VirtPhc *p = clk2Phc(id);
+    if(p != nullptr) {
+        std::lock_guard<std::mutex> lk(p->lock);
+        p->baseRaw = now(CLOCK_MONOTONIC_RAW);
+        p->basePhc = ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+    } else if(id < 0)
         start_ts.tv_sec = 1;
     return 0;
 }
-int clock_adjtime(clockid_t, timex *)
+int clock_adjtime(clockid_t id, timex *tx)
 {
+    VirtPhc *p = clk2Phc(id);
+    if(p != nullptr)
+        return virtAdjtime(*p, tx);
     return TIME_OK;
 }
 int open(const char *name, int flags, ...)
 {
-    // Skip PHC clocks
-    if(strncmp(ptp_dev, name, sizeof(ptp_dev) - 1) == 0)
+    if(phcNum > 0) {
+        VirtPhc *p = dev2Phc(name);
+        if(p == nullptr && strncmp(ptp_dev, name, sizeof(ptp_dev) - 1) == 0) {
+            errno = ENOENT;
+            return -1;
+        }
+        if(p != nullptr) {
+            // Use an event file, so poll() works with external time stamps
+            int fd = eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE);
+            if(fd >= MAX_FDS) {
+                orgFunc(close, fd);
+                errno = EMFILE;
+                return -1;
+            }
+            if(fd >= 0) {
+                std::lock_guard<std::mutex> lk(p->lock);
+                files[fd].events.clear();
+                files[fd].phc = p;
+            }
+            return fd;
+        }
+    } else if(strncmp(ptp_dev, name, sizeof(ptp_dev) - 1) == 0)
+        // Skip PHC clocks
         return 0;
     mode_t mode = 0;
     if((flags & O_CREAT) == O_CREAT || (flags & O_TMPFILE) == O_TMPFILE) {
@@ -117,6 +588,9 @@ int ioctl(int fd, unsigned long rq, ...)
     va_start(ap, rq);
     void *arg = va_arg(ap, void *);
     va_end(ap);
+    VirtPhc *p = fd2Phc(fd);
+    if(p != nullptr)
+        return virtIoctl(*p, rq, arg);
     ifreq *ifr = (ifreq *)arg;
     switch(rq) {
         case SIOCGIFHWADDR:
@@ -148,6 +622,53 @@ int ioctl(int fd, unsigned long rq, ...)
     }
     return 0;
 }
+ssize_t read(int fd, void *buf, size_t count)
+{
+    VirtPhc *p = fd2Phc(fd);
+    if(p == nullptr)
+        return orgFunc(read, fd, buf, count);
+    size_t max = count / sizeof(ptp_extts_event);
+    if(max == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    // Wait for the first event
+    uint64_t val;
+    ssize_t ret = orgFunc(read, fd, &val, sizeof val);
+    if(ret < 0)
+        return ret;
+    std::lock_guard<std::mutex> lk(p->lock);
+    std::deque<ptp_extts_event> &events = files[fd].events;
+    ptp_extts_event *ent = (ptp_extts_event *)buf;
+    size_t num = 0;
+    while(num < max && !events.empty()) {
+        // The first event was taken by the wait
+        if(num > 0 && orgFunc(read, fd, &val, sizeof val) < 0)
+            break;
+        *ent++ = events.front();
+        events.pop_front();
+        num++;
+    }
+    return num * sizeof(ptp_extts_event);
+}
+int close(int fd)
+{
+    VirtPhc *p = fd2Phc(fd);
+    if(p != nullptr) {
+        std::lock_guard<std::mutex> lk(p->lock);
+        files[fd].phc = nullptr;
+        files[fd].events.clear();
+    }
+    return orgFunc(close, fd);
+}
+char *realpath(const char *name, char *resolved)
+{
+    if(dev2Phc(name) == nullptr)
+        return orgFunc(realpath, name, resolved);
+    if(resolved == nullptr)
+        return strdup(name);
+    return strcpy(resolved, name);
+}
 /*****************************************************************************/
 #define STAT_RET(nm)\
     if(_##nm != nullptr)\
@@ -156,6 +677,8 @@ int ioctl(int fd, unsigned long rq, ...)
 #define STAT_BODY\
     if(sp != nullptr && name != nullptr &&\
         strncmp(ptp_dev, name, sizeof(ptp_dev) - 1) == 0) {\
+        if(phcNum > 0 && dev2Phc(name) == nullptr) {\
+            errno = ENOENT; return -1; }\
         sp->st_mode = S_IFCHR; return 0; }
 int stat(const char *name, struct stat *sp)
 {
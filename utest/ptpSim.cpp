@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Virtual PHC of the ptp4l_sim preload library unit tests
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ * @details
+ *  The tests run with the simulator preloaded, see utest_sim in
+ *   utest/Makefile, which sets the simulated clocks below.
+ *  The virtual PHCs are shared by all the tests.
+ */
+
+#include <dlfcn.h>
+#include <unistd.h>
+#include "phcSmpl.h"
+#include "err.h"
+
+using namespace ptpmgmt;
+
+// PTP_SIM_OFFSET and PTP_SIM_DRIFT of the utest_sim target
+static const int64_t simOffset[] = { 5000000, -2000000 };
+static const float_freq simDrift[] = { 20000, -50000 };
+static const int64_t NSEC_PER_SEC = 1000000000;
+
+class PtpSimTest : public ::testing::Test
+{
+  protected:
+    int (*trueOffset)(int, int64_t *);
+    int (*injectExtts)(int, unsigned int, int64_t);
+    PtpClock clk0, clk1;
+    void SetUp() override {
+        trueOffset = (int(*)(int, int64_t *))
+            dlsym(RTLD_DEFAULT, "ptp_sim_true_offset");
+        injectExtts = (int(*)(int, unsigned int, int64_t))
+            dlsym(RTLD_DEFAULT, "ptp_sim_inject_extts");
+        ASSERT_NE(trueOffset, nullptr);
+        ASSERT_NE(injectExtts, nullptr);
+        ASSERT_TRUE(clk0.initUsingIndex(0, true));
+        ASSERT_TRUE(clk1.initUsingIndex(1));
+    }
+    int64_t offset(int index) {
+        int64_t off = 0;
+        EXPECT_EQ(trueOffset(index, &off), 0);
+        return off;
+    }
+};
+
+// Tests the simulated offset with the cross time stamp methods
+// bool sample(PhcClockSample_t &res)
+// int ptp_sim_true_offset(int ptpIndex, int64_t *offset)
+TEST_F(PtpSimTest, Offset)
+{
+    // The drift adds 20 microseconds per second of the test run
+    EXPECT_NEAR(offset(0), simOffset[0], 1000000);
+    int64_t off;
+    EXPECT_EQ(trueOffset(2, &off), -1);
+    PhcCrossTs cts;
+    ASSERT_TRUE(cts.setClock(&clk0));
+    static const PhcCrossMethod_e methods[] = { PHC_CROSS_PRECISE,
+        PHC_CROSS_EXT, PHC_CROSS_BASIC
+    };
+    for(PhcCrossMethod_e method : methods) {
+        ASSERT_TRUE(cts.setMethod(method));
+        PhcClockSample_t res;
+        ASSERT_TRUE(cts.sample(res));
+        EXPECT_TRUE(res.valid);
+        EXPECT_NEAR(res.offset, offset(0), 10000) <<
+            PhcCrossTs::method2str(method);
+    }
+}
+
+// Tests the simulated drift and the frequency correction
+// bool setFreq(float_freq freq) const
+// bool offsetClock(int64_t offset) const
+TEST_F(PtpSimTest, Frequency)
+{
+    // Cancel the drift, the offset holds
+    ASSERT_TRUE(clk1.setFreq(-simDrift[1]));
+    int64_t start = offset(1);
+    usleep(200000);
+    EXPECT_NEAR(offset(1), start, 1000);
+    // The offset moves a millisecond at once
+    ASSERT_TRUE(clk1.offsetClock(1000000));
+    EXPECT_NEAR(offset(1), start + 1000000, 1000);
+    // Without correction the clock drifts 10 microseconds in 200 ms
+    ASSERT_TRUE(clk1.setFreq(0));
+    start = offset(1);
+    usleep(200000);
+    EXPECT_NEAR(offset(1) - start, simDrift[1] / 5, 2000);
+}
+
+// Tests injected external time stamps
+// bool ExternTSEbable(unsigned int index, uint8_t flags) const
+// int ptp_sim_inject_extts(int ptpIndex, unsigned int channel, int64_t ts)
+// bool readEvents(std::vector<PtpEvent_t> &events, size_t max) const
+TEST_F(PtpSimTest, InjectEvent)
+{
+    static const int64_t ts = 1700000000 * NSEC_PER_SEC + 123456789;
+    ASSERT_TRUE(clk1.ExternTSEbable(0, PTP_EXTERN_TS_RISING_EDGE));
+    EXPECT_EQ(injectExtts(1, 2, ts), -1);
+    ASSERT_EQ(injectExtts(1, 0, ts), 0);
+    // A pulse per second edge may come first
+    std::vector<PtpEvent_t> events;
+    ASSERT_TRUE(clk1.readEvents(events));
+    bool found = false;
+    for(const auto &e : events) {
+        if(e.index == 0 && e.time.toNanoseconds() == (uint64_t)ts)
+            found = true;
+    }
+    EXPECT_TRUE(found);
+    EXPECT_TRUE(clk1.ExternTSDisable(0));
+}
+
+// Tests the pulse per second edges of PTP_SIM_PPS
+// bool readEvent(PtpEvent_t &event) const
+TEST_F(PtpSimTest, PulsePerSecond)
+{
+    ASSERT_TRUE(clk0.ExternTSEbable(1, PTP_EXTERN_TS_RISING_EDGE));
+    PtpEvent_t event;
+    int64_t prev = 0;
+    for(int i = 0; i < 2; i++) {
+        ASSERT_TRUE(clk0.readEvent(event));
+        EXPECT_EQ(event.index, 1);
+        int64_t edge = event.time.toNanoseconds();
+        // The edge is on the system clock second
+        int64_t phase = (edge - offset(0)) % NSEC_PER_SEC;
+        if(phase > NSEC_PER_SEC / 2)
+            phase -= NSEC_PER_SEC;
+        EXPECT_NEAR(phase, 0, 10000);
+        if(i > 0) {
+            EXPECT_NEAR(edge - prev, NSEC_PER_SEC + simDrift[0], 200000);
+        }
+        prev = edge;
+    }
+    EXPECT_TRUE(clk0.ExternTSDisable(1));
+}
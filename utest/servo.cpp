@@ -0,0 +1,275 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later
+   SPDX-FileCopyrightText: Copyright © 2024 Erez Geva <ErezGeva2@gmail.com> */
+
+/** @file
+ * @brief Clock servos and discipline classes unit tests
+ *
+ * @author Erez Geva <ErezGeva2@@gmail.com>
+ * @copyright © 2024 Erez Geva
+ *
+ */
+
+#include <cmath>
+#include "servo.h"
+#include "phcSmpl.h"
+#include "err.h"
+
+using namespace ptpmgmt;
+
+// Simulate a clock with a frequency error, return the last offset
+static int64_t simulate(Servo &servo, float_freq drift, size_t num,
+    float_freq &freq)
+{
+    long double offset = 0;
+    freq = 0;
+    for(size_t i = 1; i <= num; i++) {
+        offset += drift + freq;
+        servoState_e state;
+        float_freq ret = servo.sample(std::llround(offset), i * 1000000000ULL,
+                state);
+        if(state != SERVO_UNLOCKED)
+            freq = ret;
+        if(state == SERVO_JUMP)
+            offset = 0;
+    }
+    return std::llround(offset);
+}
+
+// Tests PI servo sample method
+// float_freq sample(int64_t offset, uint64_t localTs, servoState_e &state)
+TEST(PiServoTest, MethodSample)
+{
+    PiServo s;
+    EXPECT_NEAR(s.getKp(), 0.7, 1e-9);
+    EXPECT_NEAR(s.getKi(), 0.3, 1e-9);
+    servoState_e state;
+    EXPECT_EQ(s.sample(1000, 1000000000, state), 0);
+    EXPECT_EQ(state, SERVO_UNLOCKED);
+    // Drift is 100 ppb
+    EXPECT_EQ(s.sample(1100, 2000000000, state), -100);
+    EXPECT_EQ(state, SERVO_LOCKED);
+    EXPECT_NEAR(s.sample(200, 3000000000, state), -300, 1e-9);
+    EXPECT_EQ(state, SERVO_LOCKED);
+}
+
+// Tests PI servo first step
+TEST(PiServoTest, FirstStep)
+{
+    PiServo s;
+    servoState_e state;
+    s.sample(100000, 1000000000, state);
+    EXPECT_EQ(state, SERVO_UNLOCKED);
+    EXPECT_EQ(s.sample(100010, 2000000000, state), -10);
+    EXPECT_EQ(state, SERVO_JUMP);
+    // First step is done only once
+    s.reset();
+    s.sample(100000, 3000000000, state);
+    s.sample(100010, 4000000000, state);
+    EXPECT_EQ(state, SERVO_LOCKED);
+}
+
+// Tests PI servo step threshold
+// void setStepThreshold(int64_t threshold)
+TEST(PiServoTest, MethodSetStepThreshold)
+{
+    PiServo s;
+    s.setStepThreshold(1000);
+    servoState_e state;
+    s.sample(10, 1000000000, state);
+    s.sample(20, 2000000000, state);
+    EXPECT_EQ(state, SERVO_LOCKED);
+    // Servo resets on a big offset
+    s.sample(2000, 3000000000, state);
+    EXPECT_EQ(state, SERVO_UNLOCKED);
+}
+
+// Tests stable threshold
+// void setStableThreshold(int64_t threshold, size_t num)
+TEST(PiServoTest, MethodSetStableThreshold)
+{
+    PiServo s;
+    s.setStableThreshold(500, 2);
+    servoState_e state;
+    s.sample(1000, 1000000000, state);
+    s.sample(1100, 2000000000, state);
+    EXPECT_EQ(state, SERVO_LOCKED);
+    s.sample(200, 3000000000, state);
+    EXPECT_EQ(state, SERVO_LOCKED);
+    s.sample(100, 4000000000, state);
+    EXPECT_EQ(state, SERVO_LOCKED_STABLE);
+    s.sample(600, 5000000000, state);
+    EXPECT_EQ(state, SERVO_LOCKED);
+}
+
+// Tests PI servo constants
+// bool syncInterval(float_seconds interval)
+// bool setConstants(float_freq kp, float_freq ki)
+TEST(PiServoTest, MethodSetConstants)
+{
+    PiServo s;
+    EXPECT_FALSE(s.syncInterval(0));
+    EXPECT_TRUE(s.syncInterval(4));
+    EXPECT_EQ(s.getSyncInterval(), 4);
+    EXPECT_NEAR(s.getKp(), 0.175, 1e-9);
+    EXPECT_NEAR(s.getKi(), 0.075, 1e-9);
+    EXPECT_FALSE(s.setConstants(-1, 0));
+    EXPECT_TRUE(s.setConstants(0.5, 0.1));
+    EXPECT_NEAR(s.getKp(), 0.5, 1e-9);
+    EXPECT_NEAR(s.getKi(), 0.1, 1e-9);
+    EXPECT_TRUE(s.setConstants(0, 0));
+    EXPECT_NEAR(s.getKp(), 0.175, 1e-9);
+}
+
+// Tests PI servo converge
+TEST(PiServoTest, Converge)
+{
+    PiServo s;
+    float_freq freq;
+    int64_t offset = simulate(s, 250, 60, freq);
+    EXPECT_LE(llabs(offset), 1);
+    EXPECT_NEAR(freq, -250, 1);
+}
+
+// Tests maximum frequency
+// bool setMaxFreq(float_freq maxFreq)
+TEST(PiServoTest, MethodSetMaxFreq)
+{
+    PiServo s;
+    EXPECT_FALSE(s.setMaxFreq(0));
+    EXPECT_TRUE(s.setMaxFreq(50));
+    EXPECT_EQ(s.getMaxFreq(), 50);
+    servoState_e state;
+    s.sample(0, 1000000000, state);
+    EXPECT_EQ(s.sample(1000, 2000000000, state), -50);
+}
+
+// Tests linear regression servo first step
+TEST(LinRegServoTest, FirstStep)
+{
+    LinRegServo s;
+    servoState_e state;
+    EXPECT_EQ(s.sample(50000, 1000000000, state), 0);
+    EXPECT_EQ(state, SERVO_UNLOCKED);
+    EXPECT_EQ(s.sample(50010, 2000000000, state), -10);
+    EXPECT_EQ(state, SERVO_JUMP);
+}
+
+// Tests linear regression servo keeps the frequency without regression
+// void setFreq(float_freq freq)
+TEST(LinRegServoTest, MethodSetFreq)
+{
+    LinRegServo s;
+    servoState_e state;
+    s.setFreq(-200);
+    // A single point has no regression
+    EXPECT_EQ(s.sample(1000, 1000000000, state), -200);
+    EXPECT_EQ(state, SERVO_UNLOCKED);
+    // Local time goes backward, the servo starts over
+    EXPECT_EQ(s.sample(1000, 500000000, state), -200);
+    EXPECT_EQ(state, SERVO_UNLOCKED);
+}
+
+// Tests linear regression servo converge
+// bool setHorizon(size_t intervals)
+TEST(LinRegServoTest, Converge)
+{
+    LinRegServo s;
+    EXPECT_FALSE(s.setHorizon(0));
+    EXPECT_TRUE(s.setHorizon(2));
+    float_freq freq;
+    int64_t offset = simulate(s, -400, 40, freq);
+    EXPECT_LE(llabs(offset), 1);
+    EXPECT_NEAR(freq, 400, 1);
+}
+
+class ClockDisciplineTest : public ::testing::Test, public ClockDiscipline
+{
+  protected:
+    PtpClock clk;
+    void SetUp() override {
+        useTestMode(true);
+        PhcCrossTs::clearCache();
+        ASSERT_TRUE(clk.initUsingIndex(0, false));
+    }
+    void TearDown() override {
+        stop();
+        useTestMode(false);
+    }
+};
+
+// Tests setClocks method
+// bool setClocks(const PtpClock *target, const PtpClock *source)
+TEST_F(ClockDisciplineTest, MethodSetClocks)
+{
+    EXPECT_FALSE(update());
+    EXPECT_STREQ(Error::getMsg().c_str(), "Clocks are not set");
+    EXPECT_FALSE(setClocks(nullptr, nullptr));
+    EXPECT_FALSE(setClocks(&clk, &clk));
+    PtpClock noInit;
+    EXPECT_FALSE(setClocks(&noInit, nullptr));
+    EXPECT_TRUE(setClocks(&clk, nullptr));
+}
+
+// Tests configuration methods
+// bool setServo(Servo *servo)
+// bool setInterval(float_seconds interval)
+// bool setHoldover(float_seconds holdover)
+// bool setSamples(size_t samples)
+// bool setPriority(int priority)
+// bool setCpu(int cpu)
+TEST_F(ClockDisciplineTest, MethodSetConfig)
+{
+    EXPECT_FALSE(setServo(nullptr));
+    EXPECT_TRUE(setServo(new LinRegServo));
+    EXPECT_NE(dynamic_cast<LinRegServo *>(&getServo()), nullptr);
+    EXPECT_FALSE(setInterval(0));
+    EXPECT_TRUE(setInterval(0.5));
+    EXPECT_EQ(getInterval(), 0.5);
+    EXPECT_FALSE(setHoldover(-1));
+    EXPECT_TRUE(setHoldover(10));
+    EXPECT_FALSE(setSamples(0));
+    EXPECT_FALSE(setSamples(26));
+    EXPECT_TRUE(setSamples(5));
+    EXPECT_FALSE(setPriority(-1));
+    EXPECT_TRUE(setPriority(0));
+    EXPECT_FALSE(setCpu(CPU_SETSIZE));
+    EXPECT_TRUE(setCpu(-1));
+}
+
+// Tests update method
+// bool update()
+// DisciplineStatus_t getStatus() const
+TEST_F(ClockDisciplineTest, MethodUpdate)
+{
+    EXPECT_TRUE(setClocks(&clk, nullptr));
+    EXPECT_TRUE(update());
+    DisciplineStatus_t st = getStatus();
+    EXPECT_EQ(st.state, DISCIPLINE_UNLOCKED);
+    EXPECT_EQ(st.servo, SERVO_UNLOCKED);
+    // Driver support precise cross time stamp
+    EXPECT_EQ(st.offset, -398000000047);
+    EXPECT_EQ(st.delay, 0);
+    EXPECT_EQ(st.updates, 1);
+    EXPECT_EQ(st.time, Timestamp_t(415, 182));
+    // System clock as target, PHC as source
+    EXPECT_TRUE(setClocks(nullptr, &clk));
+    EXPECT_TRUE(update());
+    st = getStatus();
+    EXPECT_EQ(st.offset, 398000000047);
+    EXPECT_EQ(st.updates, 2);
+}
+
+// Tests start method
+// bool start()
+// void stop()
+// bool isRunning() const
+TEST_F(ClockDisciplineTest, MethodStart)
+{
+    EXPECT_FALSE(start());
+    EXPECT_TRUE(setClocks(&clk, nullptr));
+    EXPECT_TRUE(start());
+    EXPECT_TRUE(isRunning());
+    EXPECT_FALSE(setInterval(2));
+    stop();
+    EXPECT_FALSE(isRunning());
+}
@@ -9,7 +9,9 @@
  *
  */
 
+#include <linux/ptp_clock.h>
 #include "types.h"
+#include "timeCvrt.h"
 
 using namespace ptpmgmt;
 
@@ -428,6 +430,69 @@ TEST(TimeStampTest, MethodMinusSeconds)
     EXPECT_EQ(t.nanosecondsField, 930000000);
 }
 
+// Tests add nanoseconds method
+// Timestamp_t &addNanoseconds(int64_t nanoseconds)
+TEST(TimeStampTest, MethodAddNanoseconds)
+{
+    Timestamp_t t = { 17, 930000012 };
+    t.addNanoseconds(24540000045);
+    EXPECT_EQ(t.secondsField, 42);
+    EXPECT_EQ(t.nanosecondsField, 470000057);
+    t.addNanoseconds(-24540000045);
+    EXPECT_EQ(t.secondsField, 17);
+    EXPECT_EQ(t.nanosecondsField, 930000012);
+    t.addNanoseconds(-930000013);
+    EXPECT_EQ(t.secondsField, 16);
+    EXPECT_EQ(t.nanosecondsField, 999999999);
+}
+
+// Tests difference in nanoseconds method
+// int64_t diffNanoseconds(const Timestamp_t &ts) const
+TEST(TimeStampTest, MethodDiffNanoseconds)
+{
+    Timestamp_t t1 = { 42, 470000000 };
+    Timestamp_t t2 = { 24, 540000001 };
+    EXPECT_EQ(t1.diffNanoseconds(t2), 17929999999);
+    EXPECT_EQ(t2.diffNanoseconds(t1), -17929999999);
+}
+
+// Tests convert clock times to nanoseconds
+// void timeToNanoseconds(const Timestamp_t *ts, int64_t *ns, size_t num)
+// void timeToNanoseconds(const ptp_clock_time *ts, int64_t *ns, size_t num)
+TEST(TimeStampTest, TimeToNanoseconds)
+{
+    Timestamp_t t[3] = { { 53, 654 }, { 0, 999999999 }, { 17, 0 } };
+    int64_t ns[3];
+    timeToNanoseconds(t, ns, 3);
+    EXPECT_EQ(ns[0], 53000000654);
+    EXPECT_EQ(ns[1], 999999999);
+    EXPECT_EQ(ns[2], 17000000000);
+    ptp_clock_time p[2] = { { .sec = 53, .nsec = 654 }, { .sec = -1, .nsec = 5 } };
+    timeToNanoseconds(p, ns, 2);
+    EXPECT_EQ(ns[0], 53000000654);
+    EXPECT_EQ(ns[1], -999999995);
+}
+
+// Tests clock times differences in nanoseconds
+// void timeDiffNanoseconds(const Timestamp_t *a, const Timestamp_t *b,
+//     int64_t *diff, size_t num)
+// void timeDiffNanoseconds(const ptp_clock_time *a, const ptp_clock_time *b,
+//     int64_t *diff, size_t num)
+TEST(TimeStampTest, TimeDiffNanoseconds)
+{
+    Timestamp_t a[2] = { { 42, 470000000 }, { 24, 540000001 } };
+    Timestamp_t b[2] = { { 24, 540000001 }, { 42, 470000000 } };
+    int64_t diff[2];
+    timeDiffNanoseconds(a, b, diff, 2);
+    EXPECT_EQ(diff[0], 17929999999);
+    EXPECT_EQ(diff[1], -17929999999);
+    ptp_clock_time pa[2] = { { .sec = 42, .nsec = 470000000 }, { .sec = 5, .nsec = 0 } };
+    ptp_clock_time pb[2] = { { .sec = 24, .nsec = 540000001 }, { .sec = 5, .nsec = 7 } };
+    timeDiffNanoseconds(pa, pb, diff, 2);
+    EXPECT_EQ(diff[0], 17929999999);
+    EXPECT_EQ(diff[1], -7);
+}
+
 /*****************************************************************************/
 // Unit tests for struct ClockIdentity_t
 
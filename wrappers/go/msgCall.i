@@ -13,6 +13,7 @@
 BaseMngTlv *allocTlv(mng_vals_e id) {
   switch(id) {
 #define _ptpmCaseUF(n) case n: return new n##_t;
+#define _ptpmCaseTUF(n) _ptpmCaseUF(n)
 #define A(n, v, sc, a, sz, f) _ptpmCase##f(n)
 #include "ids.h"
     default: